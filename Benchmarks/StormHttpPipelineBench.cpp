@@ -0,0 +1,215 @@
+
+// Measures keep-alive request throughput against the HTTP server frontend.  Each load connection keeps a fixed number of
+// requests in flight, so a depth past MaxPipelinedRequests exercises the server pausing and resuming reads.
+//
+// Usage: StormHttpPipelineBench [seconds] [connections] [depth] [max pipelined requests]
+
+#include "StormSocketBackend.h"
+#include "StormSocketServerFrontendHttp.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+using namespace StormSockets;
+
+static const uint16_t kBenchPort = 9081;
+static const char kRequest[] = "GET /bench HTTP/1.1\r\nHost: localhost\r\n\r\n";
+static const char kResponseStart[] = "HTTP/1.1 ";
+
+static std::atomic_bool s_Stop = { false };
+static std::atomic<int64_t> s_Responses = { 0 };
+
+static void ServerThread(StormSocketServerFrontendHttp & server)
+{
+  StormSocketEventInfo event;
+  while (s_Stop == false)
+  {
+    if (server.GetEvent(event) == false)
+    {
+      std::this_thread::yield();
+      continue;
+    }
+
+    switch (event.Type)
+    {
+    case StormSocketEventType::Data:
+    {
+      auto & request = event.GetHttpRequestReader();
+      StormHttpResponseWriter response = server.CreateOutgoingResponse(200, "OK");
+      response.WriteBody("ok", 2);
+      server.FinalizeOutgoingResponse(response, true);
+      server.SendResponse(request, response);
+      server.FreeOutgoingResponse(response);
+      server.FreeIncomingRequest(request);
+      break;
+    }
+    case StormSocketEventType::Disconnected:
+      server.FinalizeConnection(event.ConnectionId);
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+static void LoadThread(int depth)
+{
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0)
+  {
+    return;
+  }
+
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  // Wake up now and then to notice the run is over
+  timeval timeout = { 0, 100 * 1000 };
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(kBenchPort);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  if (connect(fd, (sockaddr *)&addr, sizeof(addr)) != 0)
+  {
+    close(fd);
+    return;
+  }
+
+  std::string batch;
+  for (int index = 0; index < depth; ++index)
+  {
+    batch += kRequest;
+  }
+
+  if (send(fd, batch.data(), batch.size(), 0) != (ssize_t)batch.size())
+  {
+    close(fd);
+    return;
+  }
+
+  // Responses are counted by their status lines, a partial match is carried over to the next read
+  const int start_len = (int)sizeof(kResponseStart) - 1;
+  char buffer[64 * 1024];
+  int matched = 0;
+
+  while (s_Stop == false)
+  {
+    ssize_t bytes = recv(fd, buffer, sizeof(buffer), 0);
+    if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+    {
+      continue;
+    }
+
+    if (bytes <= 0)
+    {
+      break;
+    }
+
+    int completed = 0;
+    for (ssize_t index = 0; index < bytes; ++index)
+    {
+      if (buffer[index] == kResponseStart[matched])
+      {
+        matched++;
+        if (matched == start_len)
+        {
+          completed++;
+          matched = 0;
+        }
+      }
+      else
+      {
+        matched = buffer[index] == kResponseStart[0] ? 1 : 0;
+      }
+    }
+
+    if (completed == 0)
+    {
+      continue;
+    }
+
+    s_Responses.fetch_add(completed);
+
+    // Keep the same number of requests in flight
+    batch.clear();
+    for (int index = 0; index < completed; ++index)
+    {
+      batch += kRequest;
+    }
+
+    if (send(fd, batch.data(), batch.size(), 0) != (ssize_t)batch.size())
+    {
+      break;
+    }
+  }
+
+  close(fd);
+}
+
+int main(int argc, char ** argv)
+{
+  int seconds = argc > 1 ? atoi(argv[1]) : 5;
+  int connections = argc > 2 ? atoi(argv[2]) : 16;
+  int depth = argc > 3 ? atoi(argv[3]) : 32;
+  int max_pipelined = argc > 4 ? atoi(argv[4]) : 8;
+
+  StormSocketInitSettings backend_settings;
+  backend_settings.MaxConnections = connections + 16;
+  backend_settings.HeapSize = 64 * 1024 * 1024;
+  StormSocketBackend backend(backend_settings);
+
+  StormSocketServerFrontendHttpSettings server_settings;
+  server_settings.MaxConnections = connections + 16;
+  server_settings.MessageQueueSize = 4096;
+  server_settings.ListenSettings.Port = kBenchPort;
+  server_settings.ListenSettings.LocalInterface = "127.0.0.1";
+  server_settings.MaxPipelinedRequests = max_pipelined;
+  StormSocketServerFrontendHttp server(server_settings, &backend);
+
+  std::thread server_thread(ServerThread, std::ref(server));
+
+  std::vector<std::thread> load_threads;
+  for (int index = 0; index < connections; ++index)
+  {
+    load_threads.emplace_back(LoadThread, depth);
+  }
+
+  // Let the connections fill their pipelines before measuring
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  int64_t start_count = s_Responses;
+  auto start_time = std::chrono::steady_clock::now();
+
+  std::this_thread::sleep_for(std::chrono::seconds(seconds));
+
+  int64_t end_count = s_Responses;
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+  s_Stop = true;
+  for (auto & thread : load_threads)
+  {
+    thread.join();
+  }
+
+  server_thread.join();
+
+  printf("connections: %d  depth: %d  max pipelined: %d\n", connections, depth, max_pipelined);
+  printf("%.0f requests/sec\n", (end_count - start_count) / elapsed);
+  return 0;
+}
@@ -0,0 +1,181 @@
+
+// Measures websocket message throughput from the server frontend to a client frontend over loopback, first with plain
+// frames and then with permessage-deflate negotiated on both sides.  Payloads are JSON-like text, so they compress the way
+// typical application messages do.
+//
+// Usage: StormWebsocketDeflateBench [seconds] [message size] [no context takeover]
+
+#include "StormSocketBackend.h"
+#include "StormSocketServerFrontendWebsocket.h"
+#include "StormSocketClientFrontendWebsocket.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+using namespace StormSockets;
+
+static const uint16_t kBenchPort = 9082;
+
+static std::atomic_bool s_Stop = { false };
+static std::atomic<int64_t> s_Messages = { 0 };
+static std::atomic<int64_t> s_PayloadBytes = { 0 };
+
+static std::string BuildPayload(int size)
+{
+  std::string payload;
+  int record = 0;
+  while ((int)payload.size() < size)
+  {
+    char buffer[160];
+    snprintf(buffer, sizeof(buffer), "{\"id\":%d,\"type\":\"update\",\"x\":%d.%02d,\"y\":%d.%02d,\"name\":\"entity_%d\",\"active\":%s},",
+      record, (record * 37) % 1000, record % 100, (record * 53) % 1000, (record * 7) % 100, record % 64, (record & 1) ? "true" : "false");
+
+    payload += buffer;
+    record++;
+  }
+
+  payload.resize(size);
+  return payload;
+}
+
+static void ServerThread(StormSocketServerFrontendWebsocket & server, const std::string & payload)
+{
+  StormSocketConnectionId connection_id = StormSocketConnectionId::InvalidConnectionId;
+
+  StormSocketEventInfo event;
+  while (s_Stop == false)
+  {
+    while (server.GetEvent(event))
+    {
+      switch (event.Type)
+      {
+      case StormSocketEventType::ClientHandShakeCompleted:
+        connection_id = event.ConnectionId;
+        break;
+      case StormSocketEventType::Data:
+        server.FreeIncomingPacket(event.GetWebsocketReader());
+        break;
+      case StormSocketEventType::Disconnected:
+        server.FinalizeConnection(event.ConnectionId);
+        connection_id = StormSocketConnectionId::InvalidConnectionId;
+        break;
+      default:
+        break;
+      }
+    }
+
+    if (connection_id == StormSocketConnectionId::InvalidConnectionId)
+    {
+      std::this_thread::yield();
+      continue;
+    }
+
+    // Build each message from scratch so the compression cost lands on every send, like a real server
+    auto writer = server.CreateOutgoingPacket(StormSocketWebsocketDataType::Text, true);
+    writer.WriteByteBlock(payload.data(), 0, payload.size());
+    server.FinalizeOutgoingPacket(writer);
+    server.SendPacketToConnectionBlocking(writer, connection_id);
+    server.FreeOutgoingPacket(writer);
+  }
+}
+
+static void ClientThread(StormSocketClientFrontendWebsocket & client)
+{
+  StormSocketEventInfo event;
+  while (s_Stop == false)
+  {
+    if (client.GetEvent(event) == false)
+    {
+      std::this_thread::yield();
+      continue;
+    }
+
+    switch (event.Type)
+    {
+    case StormSocketEventType::Data:
+    {
+      auto & reader = event.GetWebsocketReader();
+      s_PayloadBytes += reader.GetRemainingLength();
+      s_Messages++;
+      client.FreeIncomingPacket(reader);
+      break;
+    }
+    case StormSocketEventType::Disconnected:
+      client.FinalizeConnection(event.ConnectionId);
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+static void RunBench(int seconds, const std::string & payload, bool deflate, bool no_context_takeover)
+{
+  s_Stop = false;
+  s_Messages = 0;
+  s_PayloadBytes = 0;
+
+  StormSocketInitSettings backend_settings;
+  backend_settings.MaxConnections = 16;
+  backend_settings.HeapSize = 64 * 1024 * 1024;
+  StormSocketBackend backend(backend_settings);
+
+  StormSocketServerFrontendWebsocketSettings server_settings;
+  server_settings.MaxConnections = 8;
+  server_settings.MessageQueueSize = 4096;
+  server_settings.ListenSettings.Port = kBenchPort;
+  server_settings.ListenSettings.LocalInterface = "127.0.0.1";
+  server_settings.UsePerMessageDeflate = deflate;
+  server_settings.DeflateLocalNoContextTakeover = no_context_takeover;
+  StormSocketServerFrontendWebsocket server(server_settings, &backend);
+
+  StormSocketClientFrontendWebsocketSettings client_settings;
+  client_settings.MaxConnections = 8;
+  client_settings.MessageQueueSize = 4096;
+  client_settings.UseMasking = true;
+  client_settings.UsePerMessageDeflate = deflate;
+  StormSocketClientFrontendWebsocket client(client_settings, &backend);
+
+  std::thread server_thread(ServerThread, std::ref(server), std::cref(payload));
+  std::thread client_thread(ClientThread, std::ref(client));
+
+  StormSocketClientFrontendWebsocketRequestData request_data;
+  client.RequestConnect("127.0.0.1", kBenchPort, request_data);
+
+  // Let the connection come up and the send queue fill before measuring
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  int64_t start_messages = s_Messages;
+  int64_t start_bytes = s_PayloadBytes;
+  auto start_time = std::chrono::steady_clock::now();
+
+  std::this_thread::sleep_for(std::chrono::seconds(seconds));
+
+  int64_t end_messages = s_Messages;
+  int64_t end_bytes = s_PayloadBytes;
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+  s_Stop = true;
+  server_thread.join();
+  client_thread.join();
+
+  printf("%-12s %12.0f messages/sec %10.1f MB/sec of payload\n", deflate ? "deflate" : "uncompressed",
+    (end_messages - start_messages) / elapsed, (end_bytes - start_bytes) / elapsed / (1024.0 * 1024.0));
+}
+
+int main(int argc, char ** argv)
+{
+  int seconds = argc > 1 ? atoi(argv[1]) : 5;
+  int message_size = argc > 2 ? atoi(argv[2]) : 4096;
+  bool no_context_takeover = argc > 3 ? atoi(argv[3]) != 0 : false;
+
+  std::string payload = BuildPayload(message_size);
+
+  printf("message size: %d  no context takeover: %s\n", message_size, no_context_takeover ? "yes" : "no");
+  RunBench(seconds, payload, false, no_context_takeover);
+  RunBench(seconds, payload, true, no_context_takeover);
+  return 0;
+}
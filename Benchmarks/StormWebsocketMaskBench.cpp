@@ -0,0 +1,83 @@
+
+// Measures websocket masking throughput for payloads from 1 KB to 1 MB, comparing StormWebsocketApplyMask against the
+// byte at a time loop it replaced.  Each pass masks the same buffer, so the larger sizes also show the cache falling off.
+//
+// Usage: StormWebsocketMaskBench [total megabytes per size]
+
+#include "StormWebsocketMask.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace StormSockets;
+
+static void MaskBytewise(void * data, int length, uint32_t mask)
+{
+  uint8_t * ptr = (uint8_t *)data;
+  for (int index = 0; index < length; index++)
+  {
+    ptr[index] ^= (uint8_t)(mask >> ((index & 3) * 8));
+  }
+}
+
+template <typename Func>
+static double MeasureThroughput(std::vector<uint8_t> & buffer, int length, int64_t total_bytes, Func && func)
+{
+  int64_t passes = std::max<int64_t>(total_bytes / length, 1);
+
+  // Warm the buffer and the branch predictors before timing
+  func(buffer.data(), length);
+
+  auto start_time = std::chrono::steady_clock::now();
+  for (int64_t pass = 0; pass < passes; pass++)
+  {
+    func(buffer.data(), length);
+  }
+
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+  return (passes * (double)length) / elapsed / (1024.0 * 1024.0 * 1024.0);
+}
+
+int main(int argc, char ** argv)
+{
+  int total_mb = argc > 1 ? atoi(argv[1]) : 1024;
+  int64_t total_bytes = (int64_t)total_mb * 1024 * 1024;
+
+  static const uint32_t kMask = 0x9A3C51E7;
+  static const int kMaxLength = 1024 * 1024;
+
+  // Offset by one so the data isn't conveniently aligned for the vector paths
+  std::vector<uint8_t> buffer(kMaxLength + 1);
+  for (size_t index = 0; index < buffer.size(); index++)
+  {
+    buffer[index] = (uint8_t)index;
+  }
+
+  // The vector paths have to agree with the plain loop, including the odd bytes at the end
+  std::vector<uint8_t> check(buffer.begin() + 1, buffer.end());
+  StormWebsocketApplyMask(check.data(), kMaxLength, kMask);
+  std::vector<uint8_t> expected(buffer.begin() + 1, buffer.end());
+  MaskBytewise(expected.data(), kMaxLength, kMask);
+  if (memcmp(check.data(), expected.data(), kMaxLength) != 0)
+  {
+    printf("StormWebsocketApplyMask does not match the bytewise mask\n");
+    return 1;
+  }
+
+  printf("%10s %14s %14s %8s\n", "size", "bytewise GB/s", "apply GB/s", "speedup");
+  for (int length = 1024; length <= kMaxLength; length *= 4)
+  {
+    double bytewise = MeasureThroughput(buffer, length, total_bytes,
+      [](uint8_t * ptr, int len) { MaskBytewise(ptr + 1, len, kMask); });
+    double apply = MeasureThroughput(buffer, length, total_bytes,
+      [](uint8_t * ptr, int len) { StormWebsocketApplyMask(ptr + 1, len, kMask); });
+
+    printf("%8d K %14.2f %14.2f %7.1fx\n", length / 1024, bytewise, apply, apply / bytewise);
+  }
+
+  return 0;
+}
@@ -0,0 +1,130 @@
+
+#include "StormDnsCache.h"
+
+namespace StormSockets
+{
+  StormDnsCache::StormDnsCache(StormDnsResolveFunc resolve_func, int ttl_seconds, int negative_ttl_seconds) :
+    m_ResolveFunc(std::move(resolve_func)),
+    m_TTL(ttl_seconds),
+    m_NegativeTTL(negative_ttl_seconds)
+  {
+
+  }
+
+  void StormDnsCache::Resolve(const char * host, StormDnsResultCallback callback)
+  {
+    std::string host_str = host;
+    bool cache_hit = false;
+    bool success = false;
+    std::vector<StormSocketIPAddress> addrs;
+
+    {
+      StormLockGuard<StormMutex> lock(m_Lock);
+      auto now = std::chrono::steady_clock::now();
+
+      auto itr = m_Entries.find(host_str);
+      if (itr != m_Entries.end())
+      {
+        auto & entry = itr->second;
+        if (entry.m_Resolved == false)
+        {
+          entry.m_Waiters.emplace_back(std::move(callback));
+          return;
+        }
+
+        if (entry.m_Expires > now)
+        {
+          cache_hit = true;
+          success = entry.m_Success;
+          addrs = entry.m_Addrs;
+        }
+        else
+        {
+          entry = Entry();
+          entry.m_Waiters.emplace_back(std::move(callback));
+        }
+      }
+      else
+      {
+        if (m_Entries.size() >= kSweepThreshold)
+        {
+          for (auto sweep = m_Entries.begin(); sweep != m_Entries.end();)
+          {
+            if (sweep->second.m_Resolved && sweep->second.m_Expires <= now)
+            {
+              sweep = m_Entries.erase(sweep);
+            }
+            else
+            {
+              ++sweep;
+            }
+          }
+        }
+
+        itr = m_Entries.emplace(host_str, Entry()).first;
+        itr->second.m_Waiters.emplace_back(std::move(callback));
+      }
+    }
+
+    // Called outside the lock since the caller usually starts connecting from here
+    if (cache_hit)
+    {
+      callback(success, addrs);
+      return;
+    }
+
+    m_ResolveFunc(host_str, [this, host_str](bool lookup_success, const std::vector<StormSocketIPAddress> & lookup_addrs, int ttl_seconds)
+    {
+      CompleteLookup(host_str, lookup_success, lookup_addrs, ttl_seconds);
+    });
+  }
+
+  void StormDnsCache::Clear()
+  {
+    StormLockGuard<StormMutex> lock(m_Lock);
+    for (auto itr = m_Entries.begin(); itr != m_Entries.end();)
+    {
+      if (itr->second.m_Resolved)
+      {
+        itr = m_Entries.erase(itr);
+      }
+      else
+      {
+        ++itr;
+      }
+    }
+  }
+
+  void StormDnsCache::CompleteLookup(const std::string & host, bool success, const std::vector<StormSocketIPAddress> & addrs, int ttl_seconds)
+  {
+    std::vector<StormDnsResultCallback> waiters;
+
+    {
+      StormLockGuard<StormMutex> lock(m_Lock);
+      auto itr = m_Entries.find(host);
+      if (itr == m_Entries.end())
+      {
+        return;
+      }
+
+      if (ttl_seconds < 0)
+      {
+        ttl_seconds = success ? m_TTL : m_NegativeTTL;
+      }
+
+      auto & entry = itr->second;
+      entry.m_Resolved = true;
+      entry.m_Success = success;
+      entry.m_Addrs = addrs;
+      entry.m_Expires = std::chrono::steady_clock::now() + std::chrono::seconds(ttl_seconds);
+
+      waiters = std::move(entry.m_Waiters);
+      entry.m_Waiters.clear();
+    }
+
+    for (auto & waiter : waiters)
+    {
+      waiter(success, addrs);
+    }
+  }
+}
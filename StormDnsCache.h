@@ -0,0 +1,51 @@
+#pragma once
+
+#include "StormMutex.h"
+#include "StormSocketIPAddress.h"
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace StormSockets
+{
+  // Reports a lookup, addresses in the order they should be tried.  A negative ttl uses the cache's default
+  using StormDnsResolveCallback = std::function<void(bool success, const std::vector<StormSocketIPAddress> & addrs, int ttl_seconds)>;
+  using StormDnsResolveFunc = std::function<void(const std::string & host, StormDnsResolveCallback callback)>;
+
+  using StormDnsResultCallback = std::function<void(bool success, const std::vector<StormSocketIPAddress> & addrs)>;
+
+  class StormDnsCache
+  {
+  public:
+    StormDnsCache(StormDnsResolveFunc resolve_func, int ttl_seconds, int negative_ttl_seconds);
+
+    // Calls back immediately on a cache hit.  Lookups for a host that's already being resolved wait on that lookup
+    void Resolve(const char * host, StormDnsResultCallback callback);
+    void Clear();
+
+  private:
+
+    void CompleteLookup(const std::string & host, bool success, const std::vector<StormSocketIPAddress> & addrs, int ttl_seconds);
+
+    struct Entry
+    {
+      bool m_Resolved = false;
+      bool m_Success = false;
+      std::vector<StormSocketIPAddress> m_Addrs;
+      std::chrono::steady_clock::time_point m_Expires;
+      std::vector<StormDnsResultCallback> m_Waiters;
+    };
+
+    static const std::size_t kSweepThreshold = 1024;
+
+    StormDnsResolveFunc m_ResolveFunc;
+    int m_TTL;
+    int m_NegativeTTL;
+
+    StormMutex m_Lock;
+    std::unordered_map<std::string, Entry> m_Entries;
+  };
+}
@@ -0,0 +1,133 @@
+
+#include "StormFileSource.h"
+
+#ifdef _WINDOWS
+#include <io.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace StormSockets
+{
+  int StormFileOpen(const char * path, uint64_t & length)
+  {
+#ifdef _WINDOWS
+    int fd = _open(path, _O_RDONLY | _O_BINARY | _O_NOINHERIT);
+    if (fd < 0)
+    {
+      return -1;
+    }
+
+    auto file_len = _lseeki64(fd, 0, SEEK_END);
+    if (file_len < 0)
+    {
+      _close(fd);
+      return -1;
+    }
+
+    length = (uint64_t)file_len;
+    return fd;
+#else
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+      return -1;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) < 0 || S_ISREG(file_stat.st_mode) == false)
+    {
+      close(fd);
+      return -1;
+    }
+
+    length = (uint64_t)file_stat.st_size;
+    return fd;
+#endif
+  }
+
+  int StormFileDuplicate(int fd)
+  {
+#ifdef _WINDOWS
+    return _dup(fd);
+#else
+    return fcntl(fd, F_DUPFD_CLOEXEC, 0);
+#endif
+  }
+
+  void StormFileClose(int fd)
+  {
+#ifdef _WINDOWS
+    _close(fd);
+#else
+    close(fd);
+#endif
+  }
+
+  bool StormFileMap(int fd, uint64_t offset, int length, StormFileMapping & mapping)
+  {
+#ifdef _WINDOWS
+    // Windows doesn't get a real mapping here, the chunk is just read into a heap buffer
+    void * buffer = malloc(length);
+    if (buffer == nullptr)
+    {
+      return false;
+    }
+
+    if (_lseeki64(fd, offset, SEEK_SET) < 0 || _read(fd, buffer, length) != length)
+    {
+      free(buffer);
+      return false;
+    }
+
+    mapping.m_Base = buffer;
+    mapping.m_MappedLength = length;
+    mapping.m_Data = buffer;
+    return true;
+#else
+    static const uint64_t page_size = (uint64_t)sysconf(_SC_PAGESIZE);
+
+    // Touching a mapping past the end of the file faults, so make sure the file hasn't shrunk
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) < 0 || offset + length > (uint64_t)file_stat.st_size)
+    {
+      return false;
+    }
+
+    uint64_t map_offset = offset - (offset % page_size);
+    std::size_t map_length = (std::size_t)(offset - map_offset) + length;
+
+    void * base = mmap(nullptr, map_length, PROT_READ, MAP_PRIVATE, fd, (off_t)map_offset);
+    if (base == MAP_FAILED)
+    {
+      return false;
+    }
+
+    mapping.m_Base = base;
+    mapping.m_MappedLength = map_length;
+    mapping.m_Data = (uint8_t *)base + (offset - map_offset);
+    return true;
+#endif
+  }
+
+  void StormFileUnmap(StormFileMapping & mapping)
+  {
+    if (mapping.m_Base == nullptr)
+    {
+      return;
+    }
+
+#ifdef _WINDOWS
+    free(mapping.m_Base);
+#else
+    munmap(mapping.m_Base, mapping.m_MappedLength);
+#endif
+
+    mapping = StormFileMapping();
+  }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace StormSockets
+{
+  struct StormFileMapping
+  {
+    void * m_Base = nullptr;
+    std::size_t m_MappedLength = 0;
+    void * m_Data = nullptr;
+  };
+
+  int StormFileOpen(const char * path, uint64_t & length);
+  int StormFileDuplicate(int fd);
+  void StormFileClose(int fd);
+
+  bool StormFileMap(int fd, uint64_t offset, int length, StormFileMapping & mapping);
+  void StormFileUnmap(StormFileMapping & mapping);
+}
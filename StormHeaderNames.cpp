@@ -0,0 +1,40 @@
+
+#include "StormHeaderNames.h"
+
+#include <string.h>
+
+namespace StormSockets
+{
+  StormHeaderName::Index StormClassifyHeaderName(StormMessageReaderCursor & header, int name_length)
+  {
+    if (name_length <= 0 || name_length > StormHeaderNameTable::kMaxNameLength)
+    {
+      return StormHeaderName::Unknown;
+    }
+
+    char name[StormHeaderNameTable::kMaxNameLength];
+    StormMessageReaderCursor name_reader = header;
+    name_reader.ReadByteBlock(name, name_length);
+
+    for (int index = 0; index < name_length; index++)
+    {
+      if (name[index] >= 'A' && name[index] <= 'Z')
+      {
+        name[index] += 'a' - 'A';
+      }
+    }
+
+    uint32_t slot = StormHeaderNameTable::Hash(name, name_length, StormHeaderNameTable::kSeed) % StormHeaderNameTable::kSlots;
+    int type = StormHeaderNameTable::kTable.m_Slots[slot];
+
+    if (type < 0 || StormHeaderNameTable::kTable.m_Lengths[type] != name_length ||
+      memcmp(name, StormHeaderNameTable::kNames[type], name_length) != 0)
+    {
+      return StormHeaderName::Unknown;
+    }
+
+    header.Advance(name_length + 1);
+    header.SkipWhiteSpace();
+    return (StormHeaderName::Index)type;
+  }
+}
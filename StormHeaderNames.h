@@ -0,0 +1,132 @@
+#pragma once
+
+#include "StormMessageReaderCursor.h"
+
+#include <cstdint>
+
+namespace StormSockets
+{
+  namespace StormHeaderName
+  {
+    enum Index
+    {
+      ContentLength,
+      TransferEncoding,
+      Connection,
+      Upgrade,
+      SecWebsocketKey,
+      SecWebsocketVersion,
+      SecWebsocketProtocol,
+      SecWebsocketAccept,
+      SecWebsocketExtensions,
+      Count,
+      Unknown = Count,
+    };
+  }
+
+  // Perfect hash over the header names the parsers care about.  The seed is searched for at compile time so that every
+  // name lands in its own slot, classifying a header is then one hash and one compare
+  namespace StormHeaderNameTable
+  {
+    static constexpr const char * kNames[StormHeaderName::Count] =
+    {
+      "content-length",
+      "transfer-encoding",
+      "connection",
+      "upgrade",
+      "sec-websocket-key",
+      "sec-websocket-version",
+      "sec-websocket-protocol",
+      "sec-websocket-accept",
+      "sec-websocket-extensions",
+    };
+
+    static constexpr int kMaxNameLength = 32;
+    static constexpr uint32_t kSlots = 16;
+
+    constexpr int NameLength(const char * name)
+    {
+      int length = 0;
+      while (name[length] != 0)
+      {
+        length++;
+      }
+
+      return length;
+    }
+
+    // Expects lower case input
+    constexpr uint32_t Hash(const char * name, int length, uint32_t seed)
+    {
+      uint32_t hash = seed;
+      for (int index = 0; index < length; index++)
+      {
+        hash = (hash ^ (uint8_t)name[index]) * 16777619u;
+      }
+
+      return hash ^ (hash >> 15);
+    }
+
+    constexpr bool SeedIsPerfect(uint32_t seed)
+    {
+      bool used[kSlots] = {};
+      for (auto name : kNames)
+      {
+        uint32_t slot = Hash(name, NameLength(name), seed) % kSlots;
+        if (used[slot])
+        {
+          return false;
+        }
+
+        used[slot] = true;
+      }
+
+      return true;
+    }
+
+    constexpr uint32_t FindSeed()
+    {
+      for (uint32_t seed = 2166136261u; seed < 2166136261u + 65536; seed++)
+      {
+        if (SeedIsPerfect(seed))
+        {
+          return seed;
+        }
+      }
+
+      return 0;
+    }
+
+    static constexpr uint32_t kSeed = FindSeed();
+    static_assert(kSeed != 0, "No perfect hash seed for the header name table");
+
+    struct Table
+    {
+      int8_t m_Slots[kSlots];
+      int8_t m_Lengths[StormHeaderName::Count];
+    };
+
+    constexpr Table BuildTable()
+    {
+      Table table = {};
+      for (uint32_t slot = 0; slot < kSlots; slot++)
+      {
+        table.m_Slots[slot] = -1;
+      }
+
+      for (int index = 0; index < StormHeaderName::Count; index++)
+      {
+        int length = NameLength(kNames[index]);
+        table.m_Slots[Hash(kNames[index], length, kSeed) % kSlots] = (int8_t)index;
+        table.m_Lengths[index] = (int8_t)length;
+      }
+
+      return table;
+    }
+
+    static constexpr Table kTable = BuildTable();
+  }
+
+  // header is the full line and name_length is where its ':' is.  For a known name, header is advanced to the value
+  StormHeaderName::Index StormClassifyHeaderName(StormMessageReaderCursor & header, int name_length);
+}
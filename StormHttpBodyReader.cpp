@@ -70,10 +70,9 @@ namespace StormSockets
   {
     if (m_Reader.GetRemainingLength() < 2)
     {
-      uint16_t v1 = ReadByte() & 0xFF;
-      uint16_t v2 = ReadByte() & 0xFF;
-
-      return (uint16_t)((v2 << 8) | v1);
+      uint16_t v;
+      ReadByteBlock(&v, sizeof(v));
+      return v;
     }
 
     return m_Reader.ReadInt16();
@@ -83,10 +82,9 @@ namespace StormSockets
   {
     if (m_Reader.GetRemainingLength() < 4)
     {
-      uint32_t v1 = ReadInt16() & 0xFFFF;
-      uint32_t v2 = ReadInt16() & 0xFFFF;
-
-      return (uint32_t)((v2 << 16) | v1);
+      uint32_t v;
+      ReadByteBlock(&v, sizeof(v));
+      return v;
     }
 
     return m_Reader.ReadInt32();
@@ -96,10 +94,9 @@ namespace StormSockets
   {
     if (m_Reader.GetRemainingLength() < 8)
     {
-      uint64_t v1 = ReadInt32() & 0xFFFFFFFF;
-      uint64_t v2 = ReadInt32() & 0xFFFFFFFF;
-
-      return (uint64_t)((v2 << 32) | v1);
+      uint64_t v;
+      ReadByteBlock(&v, sizeof(v));
+      return v;
     }
 
     return m_Reader.ReadInt64();
@@ -36,6 +36,23 @@ namespace StormSockets
 
     void ReadByteBlock(void * buffer, int length);
 
+    // Consumes the rest of the body, calling callback(const void * data, int length) for each contiguous span
+    template <typename Callback>
+    void ForEachSegment(Callback && callback)
+    {
+      while (true)
+      {
+        m_Reader.ForEachSegment(callback);
+
+        if (m_ReaderAllocator->GetNextBlock(m_PacketInfo) == nullptr)
+        {
+          return;
+        }
+
+        Advance();
+      }
+    }
+
     int GetRemainingLength() { return m_FullDataLen; }
   };
 
@@ -0,0 +1,117 @@
+
+#include "StormHttpHeaderIndex.h"
+
+#include <hash/Hash.h>
+#include <cctype>
+
+namespace StormSockets
+{
+  uint32_t StormHttpHeaderNameHash(const char * name, int & name_length)
+  {
+    uint32_t hash = crc32begin();
+    name_length = 0;
+
+    while (name[name_length] != 0)
+    {
+      hash = crc32additive(hash, (char)tolower(name[name_length]));
+      name_length++;
+    }
+
+    return crc32end(hash);
+  }
+
+  bool StormHttpHeaderNameMatch(StormMessageReaderCursor name_cursor, const char * name, int name_length)
+  {
+    if (name_cursor.GetRemainingLength() != name_length)
+    {
+      return false;
+    }
+
+    for (int index = 0; index < name_length; ++index)
+    {
+      if (tolower(name_cursor.ReadByte()) != tolower(name[index]))
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  void StormHttpHeaderIndex::Init()
+  {
+    m_Count = 0;
+    m_Overflow = false;
+
+    for (auto & entry : m_Entries)
+    {
+      entry.m_NameLength = 0;
+    }
+  }
+
+  void StormHttpHeaderIndex::AddHeader(const StormMessageReaderCursor & header_line, int name_length)
+  {
+    if (name_length <= 0)
+    {
+      return;
+    }
+
+    if (m_Count >= kMaxEntries)
+    {
+      m_Overflow = true;
+      return;
+    }
+
+    StormMessageReaderCursor name(header_line, name_length);
+    StormMessageReaderCursor value(header_line);
+    value.Advance(name_length + 1);
+    value.SkipWhiteSpace();
+
+    uint32_t hash = crc32begin();
+    StormMessageReaderCursor name_reader(name);
+    while (name_reader.GetRemainingLength() > 0)
+    {
+      hash = crc32additive(hash, (char)tolower(name_reader.ReadByte()));
+    }
+
+    hash = crc32end(hash);
+
+    int slot = hash & (kSlots - 1);
+    while (m_Entries[slot].m_NameLength != 0)
+    {
+      slot = (slot + 1) & (kSlots - 1);
+    }
+
+    auto & entry = m_Entries[slot];
+    entry.m_Hash = hash;
+    entry.m_NameLength = name.m_DataLength;
+    entry.m_NameOffset = name.m_ReadOffset;
+    entry.m_NameBlock = name.m_CurBlock;
+    entry.m_ValueLength = value.m_DataLength;
+    entry.m_ValueOffset = value.m_ReadOffset;
+    entry.m_ValueBlock = value.m_CurBlock;
+    m_Count++;
+  }
+
+  bool StormHttpHeaderIndex::FindHeader(const char * name, StormFixedBlockAllocator * allocator, StormMessageReaderCursor & out_value)
+  {
+    int name_length;
+    uint32_t hash = StormHttpHeaderNameHash(name, name_length);
+
+    int slot = hash & (kSlots - 1);
+    while (m_Entries[slot].m_NameLength != 0)
+    {
+      auto & entry = m_Entries[slot];
+      if (entry.m_Hash == hash && entry.m_NameLength == name_length &&
+        StormHttpHeaderNameMatch(StormMessageReaderCursor(allocator, entry.m_NameBlock, entry.m_NameLength, entry.m_NameOffset), name, name_length))
+      {
+        out_value = StormMessageReaderCursor(allocator, entry.m_ValueBlock, entry.m_ValueLength, entry.m_ValueOffset);
+        return true;
+      }
+
+      slot = (slot + 1) & (kSlots - 1);
+    }
+
+    return false;
+  }
+}
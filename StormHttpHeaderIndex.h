@@ -0,0 +1,42 @@
+#pragma once
+
+#include "StormMessageReaderCursor.h"
+
+#include <cstdint>
+
+namespace StormSockets
+{
+  struct StormHttpHeaderIndexEntry
+  {
+    uint32_t m_Hash;
+    int m_NameLength; // Zero for empty slots
+    int m_NameOffset;
+    int m_ValueLength;
+    int m_ValueOffset;
+    void * m_NameBlock;
+    void * m_ValueBlock;
+  };
+
+  // Open addressed table of header name -> value span, built while the headers are parsed.  Lives in a single
+  // block from the connection's allocator and points back into the receive buffer
+  struct StormHttpHeaderIndex
+  {
+    static const int kSlots = 64;
+    static const int kMaxEntries = 48;
+
+    int m_Count;
+    bool m_Overflow;
+    StormHttpHeaderIndexEntry m_Entries[kSlots];
+
+    void Init();
+
+    // header_line is the full line, name_length is where its ':' is
+    void AddHeader(const StormMessageReaderCursor & header_line, int name_length);
+
+    // Returns the first header with that name, names are case insensitive
+    bool FindHeader(const char * name, StormFixedBlockAllocator * allocator, StormMessageReaderCursor & out_value);
+  };
+
+  uint32_t StormHttpHeaderNameHash(const char * name, int & name_length);
+  bool StormHttpHeaderNameMatch(StormMessageReaderCursor name_cursor, const char * name, int name_length);
+}
@@ -11,8 +11,9 @@ namespace StormSockets
 
     strs.push_back("HTTP/1.1");
     strs.push_back("HTTP/1.0");
-    strs.push_back("content-length: ");
-    strs.push_back("transfer-encoding: chunked");
+    strs.push_back("chunked");
+    strs.push_back("close");
+    strs.push_back("keep-alive");
 
     if (strs.size() != (int)StormHttpHeaderType::Count)
     {
@@ -10,8 +10,9 @@ namespace StormSockets
     {
       HttpVer,
       HttpVer1,
-      ContentLength,
-      ChunkedEncoding,
+      Chunked,
+      ConnectionClose,
+      ConnectionKeepAlive,
       Count,
     };
   }
@@ -8,10 +8,12 @@ namespace StormSockets
 {
   StormHttpRequestReader::StormHttpRequestReader(void * block, int data_len, int read_offset, StormSocketConnectionId connection_id,
     StormFixedBlockAllocator * block_allocator, StormFixedBlockAllocator * reader_allocator,
-    const StormMessageReaderCursor & method, StormMessageReaderCursor & uri, StormMessageHeaderReader & headers) :
+    const StormMessageReaderCursor & method, StormMessageReaderCursor & uri, StormMessageHeaderReader & headers,
+    StormFixedBlockHandle header_index) :
     m_Method(method),
     m_URI(uri),
-    m_Headers(headers)
+    m_Headers(headers),
+    m_HeaderIndex(header_index)
   {
     m_Allocator = block_allocator;
     m_ReaderAllocator = reader_allocator;
@@ -21,6 +23,11 @@ namespace StormSockets
 
     m_FullDataLen = 0;
     m_BodyDataLen = data_len;
+    m_RequestIndex = 0;
+    m_StreamedBody = false;
+    m_BodyChunk = false;
+    m_LastChunk = false;
+    m_Http10 = false;
 
     m_FirstPacketHandle = packet_handle;
     m_LastPacketHandle = packet_handle;
@@ -37,6 +44,44 @@ namespace StormSockets
     return StormHttpBodyReader(packet_info, m_Allocator, m_ReaderAllocator, m_BodyDataLen);
   }
 
+  bool StormHttpRequestReader::FindHeader(const char * name, StormMessageReaderCursor & out_value)
+  {
+    if (m_HeaderIndex != InvalidBlockHandle)
+    {
+      StormHttpHeaderIndex * index = (StormHttpHeaderIndex *)m_Allocator->ResolveHandle(m_HeaderIndex);
+      if (index->m_Overflow == false)
+      {
+        return index->FindHeader(name, m_Allocator, out_value);
+      }
+    }
+
+    // Too many headers to index, fall back to scanning them
+    int name_length;
+    StormHttpHeaderNameHash(name, name_length);
+
+    StormMessageHeaderReader header_reader = m_Headers;
+    while (true)
+    {
+      int full_data_len;
+      bool got_header;
+      int header_name_length;
+      StormMessageReaderCursor header = header_reader.AdvanceToNextHeader(full_data_len, got_header, header_name_length);
+
+      if (got_header == false || header.GetRemainingLength() == 0)
+      {
+        return false;
+      }
+
+      if (header_name_length == name_length && StormHttpHeaderNameMatch(StormMessageReaderCursor(header, name_length), name, name_length))
+      {
+        out_value = header;
+        out_value.Advance(name_length + 1);
+        out_value.SkipWhiteSpace();
+        return true;
+      }
+    }
+  }
+
   void StormHttpRequestReader::AddBlock(void * block, int data_len, int read_offset)
   {
     StormFixedBlockHandle packet_handle = m_ReaderAllocator->AllocateBlock(StormFixedBlockType::Reader);
@@ -53,6 +98,12 @@ namespace StormSockets
 
   void StormHttpRequestReader::FreeChain()
   {
+    if (m_HeaderIndex != InvalidBlockHandle)
+    {
+      m_Allocator->FreeBlock(m_HeaderIndex, StormFixedBlockType::Custom);
+      m_HeaderIndex = InvalidBlockHandle;
+    }
+
     StormFixedBlockHandle cur_packet = m_FirstPacketHandle;
 
     while (cur_packet != InvalidBlockHandle)
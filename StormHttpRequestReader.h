@@ -6,6 +6,7 @@
 #include "StormMessageReaderCursor.h"
 #include "StormMessageHeaderReader.h"
 #include "StormHttpBodyReader.h"
+#include "StormHttpHeaderIndex.h"
 
 #include <cstdint>
 
@@ -22,10 +23,16 @@ namespace StormSockets
     int m_FullDataLen;
     int m_BodyDataLen;
     StormSocketConnectionId m_ConnectionId;
+    uint32_t m_RequestIndex;
+    bool m_StreamedBody;
+    bool m_BodyChunk;
+    bool m_LastChunk;
+    bool m_Http10;
 
     StormMessageReaderCursor m_Method;
     StormMessageReaderCursor m_URI;
     StormMessageHeaderReader m_Headers;
+    StormFixedBlockHandle m_HeaderIndex;
 
     friend class StormSocketServerFrontendHttp;
 
@@ -39,10 +46,19 @@ namespace StormSockets
     StormMessageReaderCursor & GetURI() { return m_URI; }
     StormMessageHeaderReader & GetHeaderReader() { return m_Headers; }
 
+    // Looks the header up in the index built during parsing, name is case insensitive.  out_value starts after the ':' and any spaces
+    bool FindHeader(const char * name, StormMessageReaderCursor & out_value);
+    StormSocketConnectionId GetConnectionId() { return m_ConnectionId; }
+
+    // A streamed request has no body of its own, the body follows in BodyChunk events
+    bool HasStreamedBody() const { return m_StreamedBody; }
+    bool IsLastChunk() const { return m_LastChunk; }
+
   private:
     StormHttpRequestReader(void * block, int data_len, int read_offset, StormSocketConnectionId connection_id,
       StormFixedBlockAllocator * block_allocator, StormFixedBlockAllocator * reader_allocator,
-      const StormMessageReaderCursor & method, StormMessageReaderCursor & uri, StormMessageHeaderReader & headers);
+      const StormMessageReaderCursor & method, StormMessageReaderCursor & uri, StormMessageHeaderReader & headers,
+      StormFixedBlockHandle header_index = InvalidBlockHandle);
 
     void AddBlock(void * block, int data_len, int read_offset);
     void FreeChain();
@@ -13,7 +13,8 @@ namespace StormSockets
     m_StatusLine(status_line),
     m_ResponsePhrase(response_phrase),
     m_Headers(headers),
-    m_ResponseCode(response_code)
+    m_ResponseCode(response_code),
+    m_RequestTag(0)
   {
     m_Allocator = block_allocator;
     m_ReaderAllocator = reader_allocator;
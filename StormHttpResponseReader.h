@@ -28,6 +28,7 @@ namespace StormSockets
     StormMessageReaderCursor m_ResponsePhrase;
     StormMessageHeaderReader m_Headers;
     int m_ResponseCode;
+    uint64_t m_RequestTag;
 
     friend class StormSocketClientFrontendHttp;
     friend class StormSocketFrontendHttpBase;
@@ -42,6 +43,7 @@ namespace StormSockets
     StormMessageReaderCursor GetResponsePhraseReader() { return m_ResponsePhrase; }
     StormMessageHeaderReader GetHeaderReader() { return m_Headers; }
     int GetResponseCode() const { return m_ResponseCode; }
+    uint64_t GetRequestTag() const { return m_RequestTag; }
 
   private:
     StormHttpResponseReader(void * block, int data_len, int read_offset, StormSocketConnectionId connection_id,
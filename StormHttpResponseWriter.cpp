@@ -1,5 +1,6 @@
 
 #include "StormHttpResponseWriter.h"
+#include "StormFileSource.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -11,6 +12,8 @@ namespace StormSockets
   static const char * http_ver = "HTTP/1.1 ";
   static const char * host_header = "Host: ";
   static const char * content_len = "Content-Length: ";
+  static const char * chunked_encoding = "Transfer-Encoding: chunked\r\n";
+  static const char * connection_close = "Connection: close\r\n";
 
   StormHttpResponseWriter::StormHttpResponseWriter(int response_code, const char * response_phrase, StormMessageWriter & header_writer, StormMessageWriter & body_writer)
   {
@@ -47,9 +50,50 @@ namespace StormSockets
     m_BodyWriter.WriteByteBlock(data, 0, len);
   }
 
+  bool StormHttpResponseWriter::SetBodyFile(const char * path)
+  {
+    uint64_t length;
+    int fd = StormFileOpen(path, length);
+    if (fd < 0)
+    {
+      return false;
+    }
+
+    return SetBodyFile(fd, 0, length);
+  }
+
+  bool StormHttpResponseWriter::SetBodyFile(int fd, uint64_t offset, uint64_t length)
+  {
+#ifdef _INCLUDEOS
+    // The backend can't send file bodies on this platform
+    StormFileClose(fd);
+    return false;
+#else
+    if (m_BodyFile >= 0 || m_BodyWriter.GetLength() > 0)
+    {
+      StormFileClose(fd);
+      return false;
+    }
+
+    m_BodyFile = fd;
+    m_HeaderWriter.m_PacketInfo->m_OwnedFile = fd;
+    m_BodyFileOffset = offset;
+    m_BodyFileLength = length;
+    return true;
+#endif
+  }
+
   void StormHttpResponseWriter::FinalizeHeaders(bool write_content_len)
   {
-    if (write_content_len && m_BodyWriter.GetLength() > 0)
+    if (write_content_len && m_BodyFile >= 0)
+    {
+      char body_len_str[40];
+
+      snprintf(body_len_str, sizeof(body_len_str), "%llu\r\n", (unsigned long long)m_BodyFileLength);
+      m_HeaderWriter.WriteString(content_len);
+      m_HeaderWriter.WriteString(body_len_str);
+    }
+    else if (write_content_len && m_BodyWriter.GetLength() > 0)
     {
       int body_len = m_BodyWriter.GetLength();
       char body_len_str[40];
@@ -62,6 +106,56 @@ namespace StormSockets
     m_HeaderWriter.WriteInt16(line_ending);
   }
 
+  void StormHttpResponseWriter::FinalizeStreamHeaders(int64_t content_length, bool allow_chunked)
+  {
+    if (content_length < 0 && allow_chunked == false)
+    {
+      m_CloseDelimited = true;
+      m_HeaderWriter.WriteString(connection_close);
+      m_HeaderWriter.WriteInt16(line_ending);
+    }
+    else if (content_length < 0)
+    {
+      m_Chunked = true;
+      m_HeaderWriter.WriteString(chunked_encoding);
+      m_HeaderWriter.WriteInt16(line_ending);
+
+      int body_len = m_BodyWriter.GetLength();
+      if (body_len > 0)
+      {
+        // The chunk header goes at the end of the headers so the buffered body doesn't have to be copied
+        char chunk_len_str[20];
+        snprintf(chunk_len_str, sizeof(chunk_len_str), "%x\r\n", body_len);
+        m_HeaderWriter.WriteString(chunk_len_str);
+        m_BodyWriter.WriteInt16(line_ending);
+      }
+    }
+    else
+    {
+      char body_len_str[40];
+
+      snprintf(body_len_str, sizeof(body_len_str), "%llu\r\n", (unsigned long long)content_length);
+      m_HeaderWriter.WriteString(content_len);
+      m_HeaderWriter.WriteString(body_len_str);
+      m_HeaderWriter.WriteInt16(line_ending);
+    }
+  }
+
+  void StormHttpResponseWriter::WriteChunk(StormMessageWriter & writer, const void * data, int len)
+  {
+    char chunk_len_str[20];
+    snprintf(chunk_len_str, sizeof(chunk_len_str), "%x\r\n", len);
+
+    writer.WriteString(chunk_len_str);
+    writer.WriteByteBlock(data, 0, len);
+    writer.WriteInt16(line_ending);
+  }
+
+  void StormHttpResponseWriter::WriteLastChunk(StormMessageWriter & writer)
+  {
+    writer.WriteString("0\r\n\r\n");
+  }
+
   void StormHttpResponseWriter::DebugPrint()
   {
     m_HeaderWriter.DebugPrint();
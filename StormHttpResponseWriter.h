@@ -9,6 +9,12 @@ namespace StormSockets
     StormMessageWriter m_HeaderWriter;
     StormMessageWriter m_BodyWriter;
 
+    int m_BodyFile = -1;
+    uint64_t m_BodyFileOffset = 0;
+    uint64_t m_BodyFileLength = 0;
+    bool m_Chunked = false;
+    bool m_CloseDelimited = false;
+
     friend class StormSocketBackend;
 
   public:
@@ -23,8 +29,23 @@ namespace StormSockets
     void WriteHeaders(const void * data, unsigned int len);
     void WriteBody(const void * data, unsigned int len);
 
+    bool SetBodyFile(const char * path);
+    // Takes ownership of fd, which is closed along with the response, or right away if this returns false
+    bool SetBodyFile(int fd, uint64_t offset, uint64_t length);
+    bool HasBodyFile() { return m_BodyFile >= 0; }
+
     void FinalizeHeaders(bool write_content_len = true);
 
+    // For responses whose body is sent after the headers.  A negative content_length uses chunked encoding, in which case
+    // anything already in the body writer goes out as the first chunk.  Without allow_chunked, for HTTP/1.0 clients, the body
+    // runs until the connection is closed instead
+    void FinalizeStreamHeaders(int64_t content_length = -1, bool allow_chunked = true);
+    bool IsChunked() const { return m_Chunked; }
+    bool IsCloseDelimited() const { return m_CloseDelimited; }
+
+    static void WriteChunk(StormMessageWriter & writer, const void * data, int len);
+    static void WriteLastChunk(StormMessageWriter & writer);
+
     void DebugPrint();
 
     StormMessageWriter & GetHeaderWriter() { return m_HeaderWriter; }
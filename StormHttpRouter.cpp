@@ -0,0 +1,337 @@
+
+#include "StormHttpRouter.h"
+
+#include <stdexcept>
+#include <string.h>
+
+namespace StormSockets
+{
+  bool StormHttpRouteParams::Get(const char * name, StormMessageReaderCursor & out_value) const
+  {
+    for (int index = 0; index < m_Count; ++index)
+    {
+      if (strcmp(m_Names[index], name) == 0)
+      {
+        out_value = m_Values[index];
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  StormHttpRouter::StormHttpRouter() :
+    m_Root(std::make_unique<Node>()),
+    m_HasIOThreadRoutes(false)
+  {
+
+  }
+
+  StormHttpRouter::~StormHttpRouter()
+  {
+
+  }
+
+  void StormHttpRouter::AddRoute(const char * method, const char * pattern, StormHttpRouteHandler handler, StormHttpRouteDispatch::Index dispatch)
+  {
+    if (pattern == nullptr || pattern[0] != '/')
+    {
+      throw std::runtime_error("Route patterns must start with '/'");
+    }
+
+    Node * node = m_Root.get();
+    int param_count = 0;
+    std::string text;
+
+    const char * cur = pattern;
+    while (*cur != 0)
+    {
+      if ((*cur == ':' || *cur == '*') && cur[-1] == '/')
+      {
+        if (text.size() > 0)
+        {
+          node = InsertStatic(node, text);
+          text.clear();
+        }
+
+        bool wildcard = *cur == '*';
+        const char * name_start = cur + 1;
+        const char * name_end = name_start;
+        while (*name_end != 0 && *name_end != '/')
+        {
+          name_end++;
+        }
+
+        std::string name(name_start, name_end);
+        if (++param_count > StormHttpRouteParams::kMaxParams)
+        {
+          throw std::runtime_error("Too many parameters in route pattern");
+        }
+
+        if (wildcard)
+        {
+          if (*name_end != 0)
+          {
+            throw std::runtime_error("Wildcards must be the last segment of a route pattern");
+          }
+
+          if (!node->m_WildcardChild)
+          {
+            node->m_WildcardChild = std::make_unique<Node>();
+            node->m_WildcardName = name;
+          }
+          else if (node->m_WildcardName != name)
+          {
+            throw std::runtime_error("Conflicting wildcard names in route patterns");
+          }
+
+          node = node->m_WildcardChild.get();
+        }
+        else
+        {
+          if (!node->m_ParamChild)
+          {
+            node->m_ParamChild = std::make_unique<Node>();
+            node->m_ParamName = name;
+          }
+          else if (node->m_ParamName != name)
+          {
+            throw std::runtime_error("Conflicting parameter names in route patterns");
+          }
+
+          node = node->m_ParamChild.get();
+        }
+
+        cur = name_end;
+        continue;
+      }
+
+      text.push_back(*cur);
+      cur++;
+    }
+
+    if (text.size() > 0)
+    {
+      node = InsertStatic(node, text);
+    }
+
+    node->m_Routes.emplace_back(Route{ method ? method : "", dispatch, std::move(handler) });
+    if (dispatch == StormHttpRouteDispatch::IOThread)
+    {
+      m_HasIOThreadRoutes = true;
+    }
+  }
+
+  StormHttpRouter::Node * StormHttpRouter::InsertStatic(Node * node, const std::string & text)
+  {
+    std::size_t offset = 0;
+    while (offset < text.size())
+    {
+      Node * next = nullptr;
+      for (auto & child : node->m_Children)
+      {
+        if (child->m_Prefix[0] == text[offset])
+        {
+          next = child.get();
+          break;
+        }
+      }
+
+      if (next == nullptr)
+      {
+        node->m_Children.emplace_back(std::make_unique<Node>());
+        node->m_Children.back()->m_Prefix = text.substr(offset);
+        return node->m_Children.back().get();
+      }
+
+      std::size_t common = 0;
+      while (common < next->m_Prefix.size() && offset + common < text.size() && next->m_Prefix[common] == text[offset + common])
+      {
+        common++;
+      }
+
+      if (common < next->m_Prefix.size())
+      {
+        // Split the edge so the shared part becomes its own node
+        auto split = std::make_unique<Node>();
+        split->m_Prefix = next->m_Prefix.substr(0, common);
+
+        for (auto & child : node->m_Children)
+        {
+          if (child.get() == next)
+          {
+            next->m_Prefix = next->m_Prefix.substr(common);
+            split->m_Children.emplace_back(std::move(child));
+            child = std::move(split);
+            next = child.get();
+            break;
+          }
+        }
+      }
+
+      node = next;
+      offset += common;
+    }
+
+    return node;
+  }
+
+  bool StormHttpRouter::Dispatch(StormHttpRequestReader & request)
+  {
+    StormHttpRouteParams params;
+    const StormHttpRouteHandler * handler = FindRoute(request, StormHttpRouteDispatch::WorkerQueue, params);
+    if (handler == nullptr)
+    {
+      return false;
+    }
+
+    (*handler)(request, params);
+    return true;
+  }
+
+  const StormHttpRouteHandler * StormHttpRouter::FindRoute(StormHttpRequestReader & request, StormHttpRouteDispatch::Index dispatch, StormHttpRouteParams & out_params)
+  {
+    StormMessageReaderCursor path = request.GetURI();
+    StormMessageReaderCursor method = request.GetMethod();
+
+    // The query string isn't part of the match
+    int path_length = 0;
+    StormMessageReaderCursor scan = path;
+    while (scan.GetRemainingLength() > 0 && scan.ReadByte() != '?')
+    {
+      path_length++;
+    }
+
+    out_params.m_Count = 0;
+    const Route * route = MatchNode(*m_Root, path, path_length, method, dispatch, out_params);
+    return route ? &route->m_Handler : nullptr;
+  }
+
+  const StormHttpRouter::Route * StormHttpRouter::MatchNode(const Node & node, StormMessageReaderCursor path, int path_length,
+    StormMessageReaderCursor & method, StormHttpRouteDispatch::Index dispatch, StormHttpRouteParams & params)
+  {
+    if (path_length == 0)
+    {
+      const Route * route = MatchRoutes(node, method, dispatch);
+      if (route)
+      {
+        return route;
+      }
+    }
+    else
+    {
+      uint8_t next_byte = path.PeekByte();
+      for (auto & child : node.m_Children)
+      {
+        if ((uint8_t)child->m_Prefix[0] != next_byte)
+        {
+          continue;
+        }
+
+        int prefix_length = (int)child->m_Prefix.size();
+        if (prefix_length > path_length)
+        {
+          break;
+        }
+
+        StormMessageReaderCursor child_path = path;
+        bool matched = true;
+        for (int index = 0; index < prefix_length; ++index)
+        {
+          if (child_path.ReadByte() != (uint8_t)child->m_Prefix[index])
+          {
+            matched = false;
+            break;
+          }
+        }
+
+        if (matched)
+        {
+          const Route * route = MatchNode(*child, child_path, path_length - prefix_length, method, dispatch, params);
+          if (route)
+          {
+            return route;
+          }
+        }
+
+        break;
+      }
+
+      if (node.m_ParamChild && next_byte != '/')
+      {
+        StormMessageReaderCursor param_end = path;
+        int param_length = 0;
+        while (param_length < path_length && param_end.PeekByte() != '/')
+        {
+          param_end.Advance(1);
+          param_length++;
+        }
+
+        int param_index = params.m_Count++;
+        params.m_Names[param_index] = node.m_ParamName.c_str();
+        params.m_Values[param_index] = StormMessageReaderCursor(path, param_length);
+
+        const Route * route = MatchNode(*node.m_ParamChild, param_end, path_length - param_length, method, dispatch, params);
+        if (route)
+        {
+          return route;
+        }
+
+        params.m_Count = param_index;
+      }
+    }
+
+    if (node.m_WildcardChild)
+    {
+      const Route * route = MatchRoutes(*node.m_WildcardChild, method, dispatch);
+      if (route)
+      {
+        params.m_Names[params.m_Count] = node.m_WildcardName.c_str();
+        params.m_Values[params.m_Count] = StormMessageReaderCursor(path, path_length);
+        params.m_Count++;
+        return route;
+      }
+    }
+
+    return nullptr;
+  }
+
+  const StormHttpRouter::Route * StormHttpRouter::MatchRoutes(const Node & node, StormMessageReaderCursor & method, StormHttpRouteDispatch::Index dispatch)
+  {
+    for (auto & route : node.m_Routes)
+    {
+      if (route.m_Dispatch != dispatch)
+      {
+        continue;
+      }
+
+      if (route.m_Method.size() == 0)
+      {
+        return &route;
+      }
+
+      if (method.GetRemainingLength() != (int)route.m_Method.size())
+      {
+        continue;
+      }
+
+      StormMessageReaderCursor method_reader = method;
+      bool matched = true;
+      for (auto c : route.m_Method)
+      {
+        if (method_reader.ReadByte() != (uint8_t)c)
+        {
+          matched = false;
+          break;
+        }
+      }
+
+      if (matched)
+      {
+        return &route;
+      }
+    }
+
+    return nullptr;
+  }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "StormHttpRequestReader.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace StormSockets
+{
+  namespace StormHttpRouteDispatch
+  {
+    enum Index
+    {
+      WorkerQueue,  // Delivered as a normal Data event, the thread that drains events calls Dispatch
+      IOThread,     // Called straight from the IO thread that finished parsing the request, no event is queued.
+                    // The request is freed when the handler returns, so the handler must not free or keep it
+    };
+  }
+
+  struct StormHttpRouteParams
+  {
+    static const int kMaxParams = 8;
+
+    int m_Count = 0;
+    const char * m_Names[kMaxParams];
+    StormMessageReaderCursor m_Values[kMaxParams];
+
+    // Values point into the request, so they're only valid until it's freed
+    bool Get(const char * name, StormMessageReaderCursor & out_value) const;
+  };
+
+  using StormHttpRouteHandler = std::function<void(StormHttpRequestReader & request, const StormHttpRouteParams & params)>;
+
+  // Radix tree of method + path patterns, matched directly against the request URI.  Patterns are '/' separated,
+  // a ":name" segment matches one segment and a trailing "*name" matches the rest of the path.  Static segments are
+  // preferred over params, and params over wildcards.  Routes must all be added before the frontend starts
+  class StormHttpRouter
+  {
+  public:
+    StormHttpRouter();
+    ~StormHttpRouter();
+
+    // An empty method matches any method
+    void AddRoute(const char * method, const char * pattern, StormHttpRouteHandler handler,
+      StormHttpRouteDispatch::Index dispatch = StormHttpRouteDispatch::WorkerQueue);
+
+    // Runs the handler for a worker queue route, returns false if nothing matched so the caller can answer the request itself
+    bool Dispatch(StormHttpRequestReader & request);
+
+    bool HasIOThreadRoutes() const { return m_HasIOThreadRoutes; }
+    const StormHttpRouteHandler * FindRoute(StormHttpRequestReader & request, StormHttpRouteDispatch::Index dispatch, StormHttpRouteParams & out_params);
+
+  private:
+
+    struct Route
+    {
+      std::string m_Method;
+      StormHttpRouteDispatch::Index m_Dispatch;
+      StormHttpRouteHandler m_Handler;
+    };
+
+    struct Node
+    {
+      std::string m_Prefix;
+      std::vector<std::unique_ptr<Node>> m_Children;
+
+      std::unique_ptr<Node> m_ParamChild;
+      std::string m_ParamName;
+      std::unique_ptr<Node> m_WildcardChild;
+      std::string m_WildcardName;
+
+      std::vector<Route> m_Routes;
+    };
+
+    Node * InsertStatic(Node * node, const std::string & text);
+
+    const Route * MatchNode(const Node & node, StormMessageReaderCursor path, int path_length, StormMessageReaderCursor & method,
+      StormHttpRouteDispatch::Index dispatch, StormHttpRouteParams & params);
+    const Route * MatchRoutes(const Node & node, StormMessageReaderCursor & method, StormHttpRouteDispatch::Index dispatch);
+
+    std::unique_ptr<Node> m_Root;
+    bool m_HasIOThreadRoutes;
+  };
+}
@@ -2,39 +2,144 @@
 
 #include <stdexcept>
 
+#if defined(__x86_64__) || defined(_M_X64)
+#define STORM_HEADER_X64
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
 namespace StormSockets
 {
+#ifdef STORM_HEADER_X64
+  static int StormLowestSetBit(int bits)
+  {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, (unsigned long)bits);
+    return (int)index;
+#else
+    return __builtin_ctz((unsigned int)bits);
+#endif
+  }
+#endif
+
+  // Returns the offset of the first '\n', or -1.  Also finds the first ':' ahead of it unless colon is already set
+  static int StormScanHeaderLine(const uint8_t * data, int length, int & colon)
+  {
+    int offset = 0;
+
+#ifdef STORM_HEADER_X64
+    __m128i newline_char = _mm_set1_epi8('\n');
+    __m128i colon_char = _mm_set1_epi8(':');
+
+    while (offset + 16 <= length)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i *)(data + offset));
+      int newline_bits = _mm_movemask_epi8(_mm_cmpeq_epi8(v, newline_char));
+
+      if (colon < 0)
+      {
+        int colon_bits = _mm_movemask_epi8(_mm_cmpeq_epi8(v, colon_char));
+        if (newline_bits != 0)
+        {
+          colon_bits &= (newline_bits & -newline_bits) - 1;
+        }
+
+        if (colon_bits != 0)
+        {
+          colon = offset + StormLowestSetBit(colon_bits);
+        }
+      }
+
+      if (newline_bits != 0)
+      {
+        return offset + StormLowestSetBit(newline_bits);
+      }
+
+      offset += 16;
+    }
+#endif
+
+    for (; offset < length; ++offset)
+    {
+      if (data[offset] == '\n')
+      {
+        return offset;
+      }
+
+      if (colon < 0 && data[offset] == ':')
+      {
+        colon = offset;
+      }
+    }
+
+    return -1;
+  }
+
   StormMessageHeaderReader::StormMessageHeaderReader(StormFixedBlockAllocator * allocator, void * cur_block, int data_length, int read_offset) :
     StormMessageReaderCursor(allocator, cur_block, data_length, read_offset)
   {
 
   }
 
-	StormMessageReaderCursor StormMessageHeaderReader::AdvanceToNextHeader(int & full_data_length, bool & found_complete_header)
-	{
+  StormMessageReaderCursor StormMessageHeaderReader::AdvanceToNextHeader(int & full_data_length, bool & found_complete_header)
+  {
+    int name_length;
+    return AdvanceToNextHeader(full_data_length, found_complete_header, name_length);
+  }
+
+  StormMessageReaderCursor StormMessageHeaderReader::AdvanceToNextHeader(int & full_data_length, bool & found_complete_header, int & name_length)
+  {
     auto start_block = m_CurBlock;
     auto start_offset = m_ReadOffset;
 
-		int num_read = 0;
-		full_data_length = 0;
-		while (GetRemainingLength() > 0)
-		{
-			char v = ReadByte();
-			full_data_length++;
+    uint8_t last_byte = 0;
+    full_data_length = 0;
+    name_length = -1;
+
+    // Scans a block at a time instead of going through ReadByte
+    while (m_DataLength > 0)
+    {
+      const uint8_t * segment = (const uint8_t *)m_CurBlock + m_ReadOffset;
+      int segment_length = std::min(m_FixedBlockSize - m_ReadOffset, m_DataLength);
+
+      int colon = name_length >= 0 ? 0 : -1;
+      int line_end = StormScanHeaderLine(segment, segment_length, colon);
+
+      if (name_length < 0 && colon >= 0)
+      {
+        name_length = full_data_length + colon;
+      }
+
+      if (line_end >= 0)
+      {
+        if (line_end > 0)
+        {
+          last_byte = segment[line_end - 1];
+        }
+
+        int line_length = full_data_length + line_end;
+        full_data_length += line_end + 1;
+        Advance(line_end + 1);
+
+        if (last_byte == '\r')
+        {
+          line_length--;
+        }
 
-			if (v == '\n')
-			{
         found_complete_header = true;
-				return StormMessageReaderCursor(m_Allocator, start_block, num_read, start_offset);
-			}
+        return StormMessageReaderCursor(m_Allocator, start_block, line_length, start_offset);
+      }
 
-			if (v != '\r')
-			{
-				num_read++;
-			}
-		}
+      last_byte = segment[segment_length - 1];
+      full_data_length += segment_length;
+      Advance(segment_length);
+    }
 
     found_complete_header = false;
-		return StormMessageReaderCursor(m_Allocator, start_block, 0, start_offset);
-	}
-}
\ No newline at end of file
+    name_length = -1;
+    return StormMessageReaderCursor(m_Allocator, start_block, 0, start_offset);
+  }
+}
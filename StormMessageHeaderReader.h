@@ -16,5 +16,8 @@ namespace StormSockets
     StormMessageHeaderReader(const StormMessageHeaderReader & rhs) = default;
 
     StormMessageReaderCursor AdvanceToNextHeader(int & full_data_length, bool & found_complete_header);
+
+    // Same as above, name_length is where the first ':' sits in the returned line, or -1 if it doesn't have one
+    StormMessageReaderCursor AdvanceToNextHeader(int & full_data_length, bool & found_complete_header, int & name_length);
 	};
 }
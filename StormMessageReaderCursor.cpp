@@ -3,6 +3,7 @@
 #include "StormMemOps.h"
 
 #include <stdexcept>
+#include <climits>
 
 #include <hash/Hash.h>
 
@@ -170,6 +171,12 @@ namespace StormSockets
 
     memcpy(buffer, Marshal::MemOffset(m_CurBlock, m_ReadOffset), length);
     m_ReadOffset += length;
+
+    if (m_ReadOffset >= m_FixedBlockSize)
+    {
+      m_CurBlock = m_Allocator->GetNextBlock(m_CurBlock);
+      m_ReadOffset = 0;
+    }
   }
 
   void StormMessageReaderCursor::SkipWhiteSpace()
@@ -190,6 +197,21 @@ namespace StormSockets
   }
 
   bool StormMessageReaderCursor::ReadNumber(int & value, int required_digits)
+  {
+    StormMessageReaderCursor reader_copy = *this;
+    int64_t wide_value;
+
+    if (reader_copy.ReadNumber(wide_value, required_digits) == false || wide_value > INT_MAX)
+    {
+      return false;
+    }
+
+    value = (int)wide_value;
+    *this = reader_copy;
+    return true;
+  }
+
+  bool StormMessageReaderCursor::ReadNumber(int64_t & value, int required_digits)
   {
     if (GetRemainingLength() == 0)
     {
@@ -216,6 +238,11 @@ namespace StormSockets
         }
       }
 
+      if (value > (INT64_MAX - 9) / 10)
+      {
+        return false;
+      }
+
       value *= 10;
       value += digit - '0';
 
@@ -236,6 +263,11 @@ namespace StormSockets
 
     if (required_digits <= 0)
     {
+      if (value > (INT64_MAX - 9) / 10)
+      {
+        return false;
+      }
+
       value *= 10;
       value += digit - '0';
 
@@ -247,6 +279,21 @@ namespace StormSockets
   }
 
   bool StormMessageReaderCursor::ReadHexNumber(int & value, int required_digits)
+  {
+    StormMessageReaderCursor reader_copy = *this;
+    int64_t wide_value;
+
+    if (reader_copy.ReadHexNumber(wide_value, required_digits) == false || wide_value > INT_MAX)
+    {
+      return false;
+    }
+
+    value = (int)wide_value;
+    *this = reader_copy;
+    return true;
+  }
+
+  bool StormMessageReaderCursor::ReadHexNumber(int64_t & value, int required_digits)
   {
     if (GetRemainingLength() == 0)
     {
@@ -269,6 +316,11 @@ namespace StormSockets
         required_digits--;
       }
 
+      if (value > (INT64_MAX >> 4))
+      {
+        return false;
+      }
+
       value *= 16;
       if (digit >= '0' && digit <= '9')
       {
@@ -4,6 +4,7 @@
 
 
 #include <stdint.h>
+#include <algorithm>
 
 namespace StormSockets
 {
@@ -18,6 +19,7 @@ namespace StormSockets
 
     friend class StormWebsocketMessageReader;
     friend class StormHttpBodyReader;
+    friend struct StormHttpHeaderIndex;
 
   public:
     StormMessageReaderCursor() = default;
@@ -35,10 +37,32 @@ namespace StormSockets
 
     void ReadByteBlock(void * buffer, int length);
 
+    // Consumes the rest of the cursor, calling callback(const void * data, int length) for each contiguous span
+    template <typename Callback>
+    void ForEachSegment(Callback && callback)
+    {
+      while (m_DataLength > 0)
+      {
+        int segment_length = std::min(m_FixedBlockSize - m_ReadOffset, m_DataLength);
+        callback((const uint8_t *)m_CurBlock + m_ReadOffset, segment_length);
+
+        m_ReadOffset += segment_length;
+        m_DataLength -= segment_length;
+
+        if (m_ReadOffset >= m_FixedBlockSize)
+        {
+          m_CurBlock = m_Allocator->GetNextBlock(m_CurBlock);
+          m_ReadOffset = 0;
+        }
+      }
+    }
+
     void SkipWhiteSpace();
 
     bool ReadNumber(int & value, int required_digits = -1);
+    bool ReadNumber(int64_t & value, int required_digits = -1);
     bool ReadHexNumber(int & value, int required_digits = -1);
+    bool ReadHexNumber(int64_t & value, int required_digits = -1);
 
     uint32_t HashRemainingData(bool include_spaces);
     uint32_t HashUntilDelimiter(char delimiter);
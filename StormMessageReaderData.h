@@ -1,5 +1,7 @@
 #pragma once
 
+#include "StormFixedBlockAllocator.h"
+
 namespace StormSockets
 {
   struct StormMessageReaderData
@@ -7,5 +9,12 @@ namespace StormSockets
     void * m_CurBlock;
     int m_DataLength;
     int m_ReadOffset;
+
+    // Block chain that belongs to this record instead of the receive buffer, used for inflated websocket data
+    StormFixedBlockHandle m_OwnedBlocks;
+
+    // Websocket data left masked (and text left unvalidated) until it's read, m_Mask is rotated as the data is consumed
+    uint32_t m_Mask;
+    bool m_Deferred;
   };
 }
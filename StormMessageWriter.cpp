@@ -33,6 +33,10 @@ namespace StormSockets
     m_PacketInfo->m_TotalLength = 0;
     m_PacketInfo->m_SendOffset = 0;
     m_PacketInfo->m_RefCount = 1;
+    m_PacketInfo->m_OwnedFile = -1;
+    m_PacketInfo->m_NextPacket = InvalidBlockHandle;
+    m_PacketInfo->m_SlicePacket = InvalidBlockHandle;
+    m_PacketInfo->m_SliceLength = 0;
   }
 
 
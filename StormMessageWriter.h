@@ -30,6 +30,21 @@ namespace StormSockets
     volatile int m_TotalLength;
     volatile int m_SendOffset;
     std::atomic_int m_RefCount;
+
+    // File descriptor that gets closed along with the packet, used by file backed http bodies
+    int m_OwnedFile;
+
+    // The packet that follows this one when they're queued together as a sequence
+    StormFixedBlockHandle m_NextPacket;
+
+    // Bytes sent after this packet's own, read straight out of another packet that's kept alive until this one is released.
+    // The slice starts m_SliceOffset bytes into m_SliceBlock and uses [m_SliceBlockStart, m_SliceBlockEnd) of the blocks after it
+    StormFixedBlockHandle m_SlicePacket;
+    StormFixedBlockHandle m_SliceBlock;
+    int m_SliceOffset;
+    int m_SliceLength;
+    int m_SliceBlockStart;
+    int m_SliceBlockEnd;
   };
 
   class StormMessageWriter
@@ -41,12 +56,19 @@ namespace StormSockets
     StormFixedBlockAllocator * m_SenderAllocator;
     bool m_IsEncrypted;
 
+    // The next packet on the same priority lane continues this one, so no other lane gets sent in between
+    bool m_HoldsLane = false;
+
+    // Stands on its own on the wire, so it can be sent between the packets of a message that holds a lane
+    bool m_ControlFrame = false;
+
     int m_ReservedHeaderLength;
     int m_ReservedTrailerLength;
     int m_HeaderLength;
     int m_TrailerLength;
 
     friend class StormSocketBackend;
+    friend class StormHttpResponseWriter;
 
   protected:
 
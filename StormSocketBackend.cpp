@@ -1,6 +1,7 @@
 
 #include "StormSocketBackend.h"
 #include "StormSocketLog.h"
+#include "StormFileSource.h"
 
 #include <fstream>
 #include <chrono>
@@ -29,7 +30,9 @@
 
 #ifdef _LINUX
 #include <cstdio>
+#include <cerrno>
 #include <dirent.h>
+#include <sys/sendfile.h>
 #endif
 
 #ifdef _WINDOWS
@@ -96,8 +99,70 @@ namespace StormSockets
     StormFixedBlockHandle m_StartBlock;
     StormFixedBlockHandle m_PacketHandle;
     std::atomic_int * m_RefCount;
+
+    // File backed blocks send m_DataLen bytes of the file starting at m_FileOffset instead of m_DataStart
+    int m_FileDescriptor;
+    bool m_CloseFile;
+    uint64_t m_FileOffset;
+
+    // Set on the last block of a packet that came out of the priority lanes
+    bool m_Staged;
   };
 
+  template <typename Callback>
+  static void ForEachSliceSegment(StormFixedBlockAllocator & allocator, StormMessageWriterData * packet_info, Callback && callback)
+  {
+    StormFixedBlockHandle block_handle = packet_info->m_SliceBlock;
+    int offset = packet_info->m_SliceOffset;
+    int remaining = packet_info->m_SliceLength;
+
+    while (remaining > 0 && block_handle != InvalidBlockHandle)
+    {
+      int length = std::min(remaining, packet_info->m_SliceBlockEnd - offset);
+      remaining -= length;
+      callback(Marshal::MemOffset(allocator.ResolveHandle(block_handle), offset), length, remaining == 0);
+
+      block_handle = allocator.GetNextBlock(block_handle);
+      offset = packet_info->m_SliceBlockStart;
+    }
+  }
+
+#ifndef _INCLUDEOS
+  static StormSocketIPAddress ToStormAddress(const asio::ip::address & addr)
+  {
+    StormSocketIPAddress result;
+    if (addr.is_v4())
+    {
+      result.m_V4 = addr.to_v4().to_ulong();
+    }
+    else if (addr.to_v6().is_v4_mapped())
+    {
+      // IPv4 clients of a dual stack listener
+      result.m_V4 = asio::ip::make_address_v4(asio::ip::v4_mapped, addr.to_v6()).to_ulong();
+    }
+    else
+    {
+      auto bytes = addr.to_v6().to_bytes();
+      result.m_IsV6 = true;
+      std::copy(bytes.begin(), bytes.end(), result.m_V6);
+    }
+
+    return result;
+  }
+
+  static asio::ip::address ToAsioAddress(const StormSocketIPAddress & addr)
+  {
+    if (addr.m_IsV6 == false)
+    {
+      return asio::ip::address_v4(addr.m_V4);
+    }
+
+    asio::ip::address_v6::bytes_type bytes;
+    std::copy(addr.m_V6, addr.m_V6 + bytes.size(), bytes.begin());
+    return asio::ip::address_v6(bytes);
+  }
+#endif
+
   StormSocketBackend::StormSocketBackend(const StormSocketInitSettings & settings) :
     m_Allocator(settings.HeapSize, settings.BlockSize, false),
     m_MessageSenders(settings.MaxPendingOutgoingPacketsPerConnection * sizeof(StormMessageWriterData) * settings.MaxConnections, sizeof(StormMessageWriterData), false),
@@ -106,6 +171,9 @@ namespace StormSockets
 #ifndef _INCLUDEOS
     m_ClosingConnectionQueue(settings.MaxConnections),
     m_Resolver(m_IOService),
+    m_DnsCache(settings.ResolveFunc ? settings.ResolveFunc : 
+      StormDnsResolveFunc([this](const std::string & host, StormDnsResolveCallback callback) { ResolveHost(host, std::move(callback)); }),
+      settings.DnsCacheTTL, settings.DnsNegativeCacheTTL),
 #else
 
 #endif
@@ -117,16 +185,28 @@ namespace StormSockets
     m_MaxConnections = settings.MaxConnections;
 
     m_HandshakeTimeout = settings.HandshakeTimeout;
+#ifndef _INCLUDEOS
+    m_ConnectAttemptDelay = std::max(settings.ConnectAttemptDelay, 0);
+#endif
     m_FixedBlockSize = settings.BlockSize;
+    m_MaxFileBlocksInFlight = settings.MaxFileBlocksInFlight;
+    m_MaxStagedPackets = std::max(settings.MaxStagedPacketsPerConnection, 1);
+    m_MaxPendingOutgoingPackets = std::max(settings.MaxPendingOutgoingPacketsPerConnection, 1);
+
+    for (int lane = 0; lane < StormSocketSendPriority::Count; lane++)
+    {
+      m_SendPriorityWeights[lane] = std::max(settings.SendPriorityWeights[lane], 1);
+    }
 
     m_Connections = std::make_unique<StormSocketConnectionBase[]>(settings.MaxConnections);
     m_ThreadStopRequested = false;
 
-    m_OutputQueue = std::make_unique<StormMessageMegaQueue<StormMessageWriter>[]>(settings.MaxConnections);
-    m_OutputQueueArray = std::make_unique<StormMessageMegaContainer<StormMessageWriter>[]>(settings.MaxConnections * settings.MaxPendingOutgoingPacketsPerConnection);
-    m_OutputQueueIncdices = std::make_unique<StormGenIndex[]>(settings.MaxConnections * settings.MaxPendingOutgoingPacketsPerConnection);
+    int num_output_queues = settings.MaxConnections * StormSocketSendPriority::Count;
+    m_OutputQueue = std::make_unique<StormMessageMegaQueue<StormMessageWriter>[]>(num_output_queues);
+    m_OutputQueueArray = std::make_unique<StormMessageMegaContainer<StormMessageWriter>[]>(num_output_queues * settings.MaxPendingOutgoingPacketsPerConnection);
+    m_OutputQueueIncdices = std::make_unique<StormGenIndex[]>(num_output_queues * settings.MaxPendingOutgoingPacketsPerConnection);
 
-    for (int index = 0; index < settings.MaxConnections; index++)
+    for (int index = 0; index < num_output_queues; index++)
     {
       m_OutputQueue[index].Init(m_OutputQueueIncdices.get(), m_OutputQueueArray.get(),
         index * settings.MaxPendingOutgoingPacketsPerConnection, settings.MaxPendingOutgoingPacketsPerConnection);
@@ -137,6 +217,7 @@ namespace StormSockets
     m_NumIOThreads = settings.NumIOThreads;
 
     m_Timeouts = std::make_unique<std::optional<asio::steady_timer>[]>(settings.MaxConnections);
+    m_FlushTimers = std::make_unique<std::optional<asio::steady_timer>[]>(settings.MaxConnections);
 
     m_SendThreadSemaphores = std::make_unique<StormSemaphore[]>(settings.NumSendThreads);
     m_SendQueue = std::make_unique<StormMessageMegaQueue<StormSocketIOOperation>[]>(settings.NumSendThreads);
@@ -146,7 +227,7 @@ namespace StormSockets
     m_CloseConnectionSemaphore.Init(settings.MaxConnections);
     m_CloseConnectionThread = std::thread(&StormSocketBackend::CloseSocketThread, this);
 
-    for (int index = 0; index < settings.MaxConnections; index++)
+    for (int index = 0; index < num_output_queues; index++)
     {
       m_OutputQueue[index].Init(m_OutputQueueIncdices.get(), m_OutputQueueArray.get(),
         index * settings.MaxPendingOutgoingPacketsPerConnection, settings.MaxPendingOutgoingPacketsPerConnection);
@@ -157,7 +238,7 @@ namespace StormSockets
       m_SendQueue[index].Init(m_SendQueueIncdices.get(), m_SendQueueArray.get(),
         index * settings.MaxSendQueueElements, settings.MaxSendQueueElements);
 
-      int semaphore_max = settings.MaxSendQueueElements + (settings.MaxConnections * settings.MaxPendingOutgoingPacketsPerConnection) / settings.NumSendThreads;
+      int semaphore_max = settings.MaxSendQueueElements + (num_output_queues * settings.MaxPendingOutgoingPacketsPerConnection) / settings.NumSendThreads;
       m_SendThreadSemaphores[index].Init(semaphore_max * 2);
     }
 
@@ -419,8 +500,14 @@ namespace StormSockets
     auto acceptor_pair = m_Acceptors.emplace(std::make_pair(acceptor_id, std::move(new_acceptor)));
     auto & acceptor = acceptor_pair.first->second;
 
-    asio::ip::tcp::endpoint endpoint(asio::ip::address_v4::from_string(init_data.LocalInterface), init_data.Port);
-    acceptor.m_Acceptor.open(asio::ip::tcp::v4());
+    asio::ip::tcp::endpoint endpoint(asio::ip::make_address(init_data.LocalInterface), init_data.Port);
+    acceptor.m_Acceptor.open(endpoint.protocol());
+    if (endpoint.address().is_v6())
+    {
+      // Take IPv4 connections too, they show up as mapped addresses
+      acceptor.m_Acceptor.set_option(asio::ip::v6_only(false));
+    }
+
     acceptor.m_Acceptor.set_option(asio::ip::tcp::no_delay(true));
     acceptor.m_Acceptor.set_option(asio::socket_base::reuse_address(true));
     acceptor.m_Acceptor.bind(endpoint);
@@ -455,7 +542,7 @@ namespace StormSockets
       auto & acceptor = acceptor_itr->second;  
 
       StormSocketConnectionId connection_id = AllocateConnection(acceptor.m_Frontend,
-        client->remote().address().v4().whole, client->remote().port(), false, nullptr);
+        StormSocketIPv4Address(client->remote().address().v4().whole), client->remote().port(), false, nullptr);
 
       if (connection_id == StormSocketConnectionId::InvalidConnectionId)
       {
@@ -498,70 +585,41 @@ namespace StormSockets
   StormSocketConnectionId StormSocketBackend::RequestConnect(StormSocketFrontend * frontend, const char * ip_addr, int port, const void * init_data)
   {
 #ifndef _INCLUDEOS    
-    asio::ip::tcp::socket socket(m_IOService);
-    asio::error_code ec;
-    socket.open(asio::ip::tcp::v4(), ec);
-
-    if(ec)
-    {
-      StormSocketLog("Could not create new client socket\n");
-      return StormSocketConnectionId::InvalidConnectionId;
-    }
-
-    socket.set_option(asio::ip::tcp::no_delay(true), ec);
-
-    auto connection_id = AllocateConnection(frontend, 0, port, true, init_data);
+    auto connection_id = AllocateConnection(frontend, StormSocketIPAddress(), port, true, init_data);
 
     if (connection_id == StormSocketConnectionId::InvalidConnectionId)
     {
       StormSocketLog("Could not allocate connection id\n");
-
-      socket.close();
       return StormSocketConnectionId::InvalidConnectionId;
     }
 
-    m_ClientSockets[connection_id].emplace(std::move(socket));
-    auto numerical_addr = asio::ip::address_v4::from_string(ip_addr, ec);
+    // Opened once we know which address family the connection ends up on
+    m_ClientSockets[connection_id].emplace(m_IOService);
+
+    asio::error_code ec;
+    auto numerical_addr = asio::ip::make_address(ip_addr, ec);
 
     if (!ec)
     {
-      PrepareToConnect(connection_id, numerical_addr.to_ulong(), port);
+      PrepareToConnect(connection_id, { ToStormAddress(numerical_addr) }, port);
     }
     else
     {
-      asio::ip::tcp::resolver::query resolver_query(ip_addr, std::to_string(port));
-
-      auto resolver_callback = [this, connection_id, port](asio::error_code ec, asio::ip::tcp::resolver::iterator itr)
+      m_DnsCache.Resolve(ip_addr, [this, connection_id, port](bool success, const std::vector<StormSocketIPAddress> & addrs)
       {
-        if (!ec)
+        if (success && addrs.size() > 0)
         {
-          while (itr != asio::ip::tcp::resolver::iterator())
-          {
-            asio::ip::tcp::endpoint ep = *itr;
-
-            if (ep.protocol() == ep.protocol().v4())
-            {
-              PrepareToConnect(connection_id, ep.address().to_v4().to_ulong(), port);
-              return;
-            }
-
-            ++itr;
-          }
-                
-          StormSocketLog("Resolve failed\n");
-          ConnectFailed(connection_id);
+          PrepareToConnect(connection_id, addrs, port);
         }
         else
         {
           StormSocketLog("Resolve failed\n");
           ConnectFailed(connection_id);
         }
-      };
-
-      m_Resolver.async_resolve(resolver_query, resolver_callback);
+      });
     }
 #else
-    auto connection_id = AllocateConnection(frontend, 0, port, true, init_data);
+    auto connection_id = AllocateConnection(frontend, StormSocketIPAddress(), port, true, init_data);
 
     if (connection_id == StormSocketConnectionId::InvalidConnectionId)
     {
@@ -631,9 +689,47 @@ namespace StormSockets
     return connection_id;
   }
 
-  bool StormSocketBackend::QueueOutgoingPacket(StormMessageWriter & writer, StormSocketConnectionId id)
+  bool StormSocketBackend::QueueOutgoingPacket(StormMessageWriter & writer, StormSocketConnectionId id, StormSocketSendPriority::Index priority)
+  {
+    int queue_index = id * StormSocketSendPriority::Count + priority;
+    return m_OutputQueue[queue_index].Enqueue(writer, id.GetGen(), m_OutputQueueIncdices.get(), m_OutputQueueArray.get());
+  }
+
+  void * StormSocketBackend::ReserveControlBuffer(StormSocketConnectionId id, int & buffer_index)
+  {
+    auto & connection = GetConnection(id);
+    if (connection.m_SlotGen != id.GetGen())
+    {
+      return nullptr;
+    }
+
+#ifndef DISABLE_MBED
+    // Encrypted records have to go out in the order they were created
+    if (connection.m_Frontend->UseSSL(id, connection.m_FrontendId))
+    {
+      return nullptr;
+    }
+#endif
+
+    for (int index = 0; index < kControlBufferCount; index++)
+    {
+      int expected = 0;
+      if (connection.m_ControlBufferRefs[index].compare_exchange_strong(expected, 1))
+      {
+        buffer_index = index;
+        return connection.m_ControlBuffers[index];
+      }
+    }
+
+    return nullptr;
+  }
+
+  void StormSocketBackend::SendControlBuffer(StormSocketConnectionId id, int buffer_index, int length)
   {
-    return m_OutputQueue[id].Enqueue(writer, id.GetGen(), m_OutputQueueIncdices.get(), m_OutputQueueArray.get());
+    auto & connection = GetConnection(id);
+    connection.m_ControlBufferLength[buffer_index] = length;
+
+    SignalOutgoingSocket(id, StormSocketIOOperationType::QueueControl, buffer_index);
   }
 
   StormSocketConnectionBase & StormSocketBackend::GetConnection(int index)
@@ -697,7 +793,7 @@ namespace StormSockets
     FreeOutgoingPacket(writer.m_BodyWriter);
   }
 
-  bool StormSocketBackend::SendPacketToConnection(StormMessageWriter & writer, StormSocketConnectionId id)
+  bool StormSocketBackend::SendPacketToConnection(StormMessageWriter & writer, StormSocketConnectionId id, StormSocketSendPriority::Index priority)
   {
     if (writer.m_PacketInfo->m_TotalLength == 0)
     {
@@ -715,11 +811,11 @@ namespace StormSockets
       return false;
     }
 
-    writer.m_PacketInfo->m_RefCount.fetch_add(1);
-    if (QueueOutgoingPacket(writer, id) == false)
+    ReferenceSequence(writer, 1);
+    if (QueueOutgoingPacket(writer, id, priority) == false)
     {
       ReleasePacketSlot(id);
-      writer.m_PacketInfo->m_RefCount.fetch_sub(1);
+      ReferenceSequence(writer, -1);
       return false;
     }
 
@@ -728,7 +824,7 @@ namespace StormSockets
     return true;
   }
 
-  void StormSocketBackend::SendPacketToConnectionBlocking(StormMessageWriter & writer, StormSocketConnectionId id)
+  void StormSocketBackend::SendPacketToConnectionBlocking(StormMessageWriter & writer, StormSocketConnectionId id, StormSocketSendPriority::Index priority)
   {
 #ifndef _INCLUDEOS
     while (!ReservePacketSlot(id))
@@ -738,20 +834,20 @@ namespace StormSockets
 
     auto & connection = GetConnection(id);
 
-    writer.m_PacketInfo->m_RefCount.fetch_add(1);
-    while (QueueOutgoingPacket(writer, id) == false)
+    ReferenceSequence(writer, 1);
+    while (QueueOutgoingPacket(writer, id, priority) == false)
     {
       if (connection.m_SlotGen != id.GetGen())
       {
         ReleasePacketSlot(id);
-        writer.m_PacketInfo->m_RefCount.fetch_sub(1);
+        ReferenceSequence(writer, -1);
         return;
       }
 
       if ((connection.m_DisconnectFlags & StormSocketDisconnectFlags::kTerminateFlags) != 0)
       {
         ReleasePacketSlot(id);
-        writer.m_PacketInfo->m_RefCount.fetch_sub(1);
+        ReferenceSequence(writer, -1);
         return;
       }
 
@@ -760,8 +856,202 @@ namespace StormSockets
 
     SignalOutgoingSocket(id, StormSocketIOOperationType::QueuePacket);
 #else
-    SendPacketToConnection(writer, id);
+    SendPacketToConnection(writer, id, priority);
+#endif
+  }
+
+  bool StormSocketBackend::SendPacketSequenceToConnection(StormMessageWriter * writers, int num_writers, StormSocketConnectionId id,
+    StormSocketSendPriority::Index priority)
+  {
+    if (num_writers <= 0)
+    {
+      return false;
+    }
+
+    LinkPacketSequence(writers, num_writers);
+    return SendPacketToConnection(writers[0], id, priority);
+  }
+
+  void StormSocketBackend::SendPacketSequenceToConnectionBlocking(StormMessageWriter * writers, int num_writers, StormSocketConnectionId id,
+    StormSocketSendPriority::Index priority)
+  {
+    if (num_writers <= 0)
+    {
+      return;
+    }
+
+    LinkPacketSequence(writers, num_writers);
+    SendPacketToConnectionBlocking(writers[0], id, priority);
+  }
+
+  int StormSocketBackend::BroadcastSequence(StormMessageWriter * writers, int num_writers, const StormSocketConnectionId * ids, int num_ids)
+  {
+    if (num_writers <= 0)
+    {
+      return 0;
+    }
+
+    LinkPacketSequence(writers, num_writers);
+    return Broadcast(writers[0], ids, num_ids);
+  }
+
+  void StormSocketBackend::LinkPacketSequence(StormMessageWriter * writers, int num_writers)
+  {
+    for (int index = 0; index < num_writers; index++)
+    {
+      writers[index].m_HoldsLane = false;
+      writers[index].m_PacketInfo->m_NextPacket = index < num_writers - 1 ? writers[index + 1].m_PacketHandle : InvalidBlockHandle;
+    }
+  }
+
+  void StormSocketBackend::ReferenceSequence(StormMessageWriter & writer, int amount)
+  {
+    // Every packet in the sequence is freed on its own once it's sent
+    StormMessageWriterData * packet_info = writer.m_PacketInfo;
+    while (true)
+    {
+      packet_info->m_RefCount.fetch_add(amount);
+      if (packet_info->m_NextPacket == InvalidBlockHandle)
+      {
+        return;
+      }
+
+      packet_info = (StormMessageWriterData *)m_MessageSenders.ResolveHandle(packet_info->m_NextPacket);
+    }
+  }
+
+  StormMessageWriter StormSocketBackend::GetSequencePacket(StormFixedBlockHandle packet_handle)
+  {
+    StormMessageWriter writer;
+    writer.m_PacketHandle = packet_handle;
+    writer.m_PacketInfo = (StormMessageWriterData *)m_MessageSenders.ResolveHandle(packet_handle);
+    writer.m_Allocator = &m_Allocator;
+    writer.m_SenderAllocator = &m_MessageSenders;
+    writer.m_IsEncrypted = false;
+    writer.m_ReservedHeaderLength = 0;
+    writer.m_ReservedTrailerLength = 0;
+    writer.m_HeaderLength = 0;
+    writer.m_TrailerLength = 0;
+    return writer;
+  }
+
+  void StormSocketBackend::FreeOutgoingSequence(StormMessageWriter & writer)
+  {
+    StormFixedBlockHandle next_packet = writer.m_PacketInfo->m_NextPacket;
+    FreeOutgoingPacket(writer);
+    FreeSequencePackets(next_packet);
+  }
+
+  void StormSocketBackend::FreeSequencePackets(StormFixedBlockHandle packet_handle)
+  {
+    while (packet_handle != InvalidBlockHandle)
+    {
+      StormMessageWriter writer = GetSequencePacket(packet_handle);
+      packet_handle = writer.m_PacketInfo->m_NextPacket;
+      FreeOutgoingPacket(writer);
+    }
+  }
+
+  int StormSocketBackend::Broadcast(StormMessageWriter & writer, const StormSocketConnectionId * ids, int num_ids)
+  {
+    if (writer.m_PacketInfo->m_TotalLength == 0 || num_ids <= 0)
+    {
+      return 0;
+    }
+
+    // Take every reference up front, then give back the ones that didn't make it into a queue
+    ReferenceSequence(writer, num_ids);
+
+#ifndef _INCLUDEOS
+    int ids_per_block = m_FixedBlockSize / sizeof(StormSocketConnectionId);
+
+    std::vector<StormSocketIOOperation> thread_ops(m_NumSendThreads);
+    std::vector<StormFixedBlockHandle> thread_cur_blocks(m_NumSendThreads, InvalidBlockHandle);
+
+    for (auto & op : thread_ops)
+    {
+      op.m_Type = StormSocketIOOperationType::QueuePacketBatch;
+      op.m_ConnectionId = StormSocketConnectionId::InvalidConnectionId;
+      op.m_Size = 0;
+      op.m_BatchBlock = InvalidBlockHandle;
+    }
+#endif
+
+    int num_queued = 0;
+    for (int index = 0; index < num_ids; index++)
+    {
+      auto id = ids[index];
+      auto & connection = GetConnection(id);
+      if (connection.m_SlotGen != id.GetGen())
+      {
+        continue;
+      }
+
+      if (!ReservePacketSlot(id))
+      {
+        continue;
+      }
+
+      if (QueueOutgoingPacket(writer, id) == false)
+      {
+        ReleasePacketSlot(id);
+        continue;
+      }
+
+      connection.m_PacketsSent.fetch_add(1);
+      num_queued++;
+
+#ifndef _INCLUDEOS
+      int send_thread_index = id % m_NumSendThreads;
+      auto & op = thread_ops[send_thread_index];
+      auto & cur_block = thread_cur_blocks[send_thread_index];
+
+      int block_offset = op.m_Size % ids_per_block;
+      if (block_offset == 0)
+      {
+        if (cur_block == InvalidBlockHandle)
+        {
+          cur_block = m_Allocator.AllocateBlock(StormFixedBlockType::BlockMem);
+          op.m_BatchBlock = cur_block;
+        }
+        else
+        {
+          cur_block = m_Allocator.AllocateBlock(cur_block, StormFixedBlockType::BlockMem);
+        }
+      }
+
+      StormSocketConnectionId * block_ids = (StormSocketConnectionId *)m_Allocator.ResolveHandle(cur_block);
+      block_ids[block_offset] = id;
+      op.m_Size++;
+#else
+      SignalOutgoingSocket(id, StormSocketIOOperationType::QueuePacket);
+#endif
+    }
+
+#ifndef _INCLUDEOS
+    for (int send_thread_index = 0; send_thread_index < m_NumSendThreads; send_thread_index++)
+    {
+      auto & op = thread_ops[send_thread_index];
+      if (op.m_Size == 0)
+      {
+        continue;
+      }
+
+      while (m_SendQueue[send_thread_index].Enqueue(op, 0, m_SendQueueIncdices.get(), m_SendQueueArray.get()) == false)
+      {
+        std::this_thread::yield();
+      }
+
+      m_SendThreadSemaphores[send_thread_index].Release();
+    }
 #endif
+
+    if (num_queued < num_ids)
+    {
+      ReferenceSequence(writer, num_queued - num_ids);
+    }
+
+    return num_queued;
   }
 
   void StormSocketBackend::SendHttpRequestToConnection(StormHttpRequestWriter & writer, StormSocketConnectionId id)
@@ -771,7 +1061,93 @@ namespace StormSockets
 
   void StormSocketBackend::SendHttpResponseToConnection(StormHttpResponseWriter & writer, StormSocketConnectionId id)
   {
-    SendHttpToConnection(writer.m_HeaderWriter, writer.m_BodyWriter, id);
+    if (writer.m_BodyFile < 0)
+    {
+      SendHttpToConnection(writer.m_HeaderWriter, writer.m_BodyWriter, id);
+      return;
+    }
+
+#ifndef _INCLUDEOS
+    auto & connection = GetConnection(id);
+    if (connection.m_SlotGen != id.GetGen())
+    {
+      return;
+    }
+
+    int fd = StormFileDuplicate(writer.m_BodyFile);
+    if (fd < 0)
+    {
+      StormSocketLog("Could not duplicate response body file\n");
+      return;
+    }
+
+    SendPacketToConnectionBlocking(writer.m_HeaderWriter, id);
+
+    // Split the file up so that each pending block's length fits in an int
+    static const uint64_t kMaxFileSegmentSize = 1 << 30;
+
+    StormFixedBlockHandle start_block_handle = InvalidBlockHandle;
+    StormFixedBlockHandle prev_block_handle = InvalidBlockHandle;
+
+    uint64_t file_offset = writer.m_BodyFileOffset;
+    uint64_t file_remaining = writer.m_BodyFileLength;
+
+    while (file_remaining > 0)
+    {
+      uint64_t segment_size = std::min(file_remaining, kMaxFileSegmentSize);
+
+      StormFixedBlockHandle file_block_handle = m_PendingSendBlocks.AllocateBlock(StormFixedBlockType::SendBlock);
+      StormPendingSendBlock * file_block = (StormPendingSendBlock *)m_PendingSendBlocks.ResolveHandle(file_block_handle);
+
+      file_block->m_DataStart = nullptr;
+      file_block->m_DataLen = (int)segment_size;
+      file_block->m_RefCount = nullptr;
+      file_block->m_FileDescriptor = fd;
+      file_block->m_FileOffset = file_offset;
+      file_block->m_Staged = false;
+
+      file_offset += segment_size;
+      file_remaining -= segment_size;
+
+      file_block->m_CloseFile = (file_remaining == 0);
+
+      if (prev_block_handle != InvalidBlockHandle)
+      {
+        m_PendingSendBlocks.SetNextBlock(prev_block_handle, file_block_handle);
+      }
+      else
+      {
+        start_block_handle = file_block_handle;
+      }
+
+      prev_block_handle = file_block_handle;
+    }
+
+    if (start_block_handle == InvalidBlockHandle)
+    {
+      StormFileClose(fd);
+      return;
+    }
+
+    int send_thread_index = id % m_NumSendThreads;
+
+    StormSocketIOOperation op;
+    op.m_ConnectionId = id;
+    op.m_Type = StormSocketIOOperationType::QueueFile;
+    op.m_Size = 0;
+    op.m_SendBlock = start_block_handle;
+
+    while (m_SendQueue[send_thread_index].Enqueue(op, 0, m_SendQueueIncdices.get(), m_SendQueueArray.get()) == false)
+    {
+      std::this_thread::yield();
+    }
+
+    m_SendThreadSemaphores[send_thread_index].Release();
+#else
+    // SetBodyFile refuses files here, so the headers can't promise a body that never comes
+    StormSocketLog("File backed responses are not supported on this platform\n");
+    ForceDisconnect(id);
+#endif
   }
 
   void StormSocketBackend::SendHttpToConnection(StormMessageWriter & header_writer, StormMessageWriter & body_writer, StormSocketConnectionId id)
@@ -941,31 +1317,72 @@ namespace StormSockets
 
   void StormSocketBackend::ReleaseOutgoingPacket(StormMessageWriter & writer)
   {
-    StormFixedBlockHandle start_block = writer.m_PacketInfo->m_StartBlock;
-    m_Allocator.FreeBlockChain(start_block, StormFixedBlockType::BlockMem);
-    m_MessageSenders.FreeBlock(writer.m_PacketHandle, StormFixedBlockType::Sender);
+    ReleasePacketData(writer.m_PacketInfo, writer.m_PacketHandle);
   }
 
-  void StormSocketBackend::SetSocketDisconnected(StormSocketConnectionId id)
+  void StormSocketBackend::ReleasePacketData(StormMessageWriterData * packet_info, StormFixedBlockHandle packet_handle)
   {
-    auto & connection = GetConnection(id);
+    if (packet_info->m_OwnedFile >= 0)
+    {
+      StormFileClose(packet_info->m_OwnedFile);
+    }
 
-    while (true)
+    if (packet_info->m_SlicePacket != InvalidBlockHandle)
     {
-      if (id.GetGen() != connection.m_SlotGen)
+      StormMessageWriterData * source_info = (StormMessageWriterData *)m_MessageSenders.ResolveHandle(packet_info->m_SlicePacket);
+      if (source_info->m_RefCount.fetch_sub(1) == 1)
       {
-        return;
+        ReleasePacketData(source_info, packet_info->m_SlicePacket);
       }
+    }
 
-      StormSocketDisconnectFlags::Index cur_flags = (StormSocketDisconnectFlags::Index)connection.m_DisconnectFlags;
-      if ((cur_flags & StormSocketDisconnectFlags::kSocket) != 0)
-      {
-        return;
-      }
+    m_Allocator.FreeBlockChain(packet_info->m_StartBlock, StormFixedBlockType::BlockMem);
+    m_MessageSenders.FreeBlock(packet_handle, StormFixedBlockType::Sender);
+  }
 
-      int new_flags = cur_flags | StormSocketDisconnectFlags::kSocket | StormSocketDisconnectFlags::kLocalClose | StormSocketDisconnectFlags::kRemoteClose;
-      if (std::atomic_compare_exchange_weak((std::atomic_int *)&connection.m_DisconnectFlags, (int *)&cur_flags, (int)new_flags))
-      {
+  void StormSocketBackend::SetPacketSlice(StormMessageWriter & writer, StormMessageWriter & source, int offset, int length)
+  {
+    int block_start = source.m_ReservedHeaderLength;
+    int block_end = m_FixedBlockSize - source.m_ReservedTrailerLength;
+
+    StormFixedBlockHandle block_handle = source.m_PacketInfo->m_StartBlock;
+    while (offset >= block_end - block_start)
+    {
+      block_handle = m_Allocator.GetNextBlock(block_handle);
+      offset -= block_end - block_start;
+    }
+
+    source.m_PacketInfo->m_RefCount.fetch_add(1);
+
+    StormMessageWriterData * packet_info = writer.m_PacketInfo;
+    packet_info->m_SlicePacket = source.m_PacketHandle;
+    packet_info->m_SliceBlock = block_handle;
+    packet_info->m_SliceOffset = block_start + offset;
+    packet_info->m_SliceLength = length;
+    packet_info->m_SliceBlockStart = block_start;
+    packet_info->m_SliceBlockEnd = block_end;
+  }
+
+  void StormSocketBackend::SetSocketDisconnected(StormSocketConnectionId id)
+  {
+    auto & connection = GetConnection(id);
+
+    while (true)
+    {
+      if (id.GetGen() != connection.m_SlotGen)
+      {
+        return;
+      }
+
+      StormSocketDisconnectFlags::Index cur_flags = (StormSocketDisconnectFlags::Index)connection.m_DisconnectFlags;
+      if ((cur_flags & StormSocketDisconnectFlags::kSocket) != 0)
+      {
+        return;
+      }
+
+      int new_flags = cur_flags | StormSocketDisconnectFlags::kSocket | StormSocketDisconnectFlags::kLocalClose | StormSocketDisconnectFlags::kRemoteClose;
+      if (std::atomic_compare_exchange_weak((std::atomic_int *)&connection.m_DisconnectFlags, (int *)&cur_flags, (int)new_flags))
+      {
         if (connection.m_PendingSendBlockStart != InvalidBlockHandle)
         {
           //printf("bad\n");
@@ -1037,6 +1454,9 @@ namespace StormSockets
 
           QueueCloseSocket(id);
           connection.m_FailedConnection = true;
+
+          // A parked connection has no read outstanding to notice the close
+          ResumeReceive(id);
         }
 
         return;
@@ -1060,15 +1480,18 @@ namespace StormSockets
       connection.m_SlotGen = (connection.m_SlotGen + 1) & 0xFF;
       FreeConnectionResources(id);
 
-      if (m_HandshakeTimeout > 0)
+      // The timer is either the handshake timeout or the keepalive timer
       {
         StormLockGuard<StormMutex> lock(connection.m_TimeoutLock);
+        if (m_Timeouts[id.GetIndex()])
+        {
 #ifndef _INCLUDEOS
-        m_Timeouts[id.GetIndex()]->cancel();
+          m_Timeouts[id.GetIndex()]->cancel();
 #else
-        Timers::stop(m_Timeouts[id.GetIndex()].value());
+          Timers::stop(m_Timeouts[id.GetIndex()].value());
 #endif
-        m_Timeouts[id.GetIndex()] = std::nullopt;
+          m_Timeouts[id.GetIndex()] = std::nullopt;
+        }
       }
 
       FreeConnectionSlot(id);
@@ -1078,13 +1501,76 @@ namespace StormSockets
     return false;
   }
 
+  void StormSocketBackend::Flush(StormSocketConnectionId id)
+  {
+    SignalOutgoingSocket(id, StormSocketIOOperationType::Flush);
+  }
+
   void StormSocketBackend::SetHandshakeComplete(StormSocketConnectionId id)
   {
     auto & connection = GetConnection(id);
     connection.m_HandshakeComplete.store(true);
   }
 
-  StormSocketConnectionId StormSocketBackend::AllocateConnection(StormSocketFrontend * frontend, uint32_t remote_ip, uint16_t remote_port, bool for_connect, const void * init_data)
+  void StormSocketBackend::StartKeepalive(StormSocketConnectionId id, int interval_ms)
+  {
+    auto & connection = GetConnection(id);
+    StormLockGuard<StormMutex> lock(connection.m_TimeoutLock);
+
+    if (connection.m_SlotGen != id.GetGen())
+    {
+      return;
+    }
+
+    // Replaces the handshake timeout, since the handshake is done by now
+    ArmKeepalive(id, interval_ms);
+  }
+
+  void StormSocketBackend::ArmKeepalive(StormSocketConnectionId id, int interval_ms)
+  {
+    int index = id.GetIndex();
+
+#ifndef _INCLUDEOS
+    auto handler = [=](const asio::error_code & error)
+    {
+      if (!error)
+      {
+        KeepaliveTimerExpired(id, interval_ms);
+      }
+    };
+
+    m_Timeouts[index].emplace(m_IOService, std::chrono::steady_clock::now() + std::chrono::milliseconds(interval_ms));
+    m_Timeouts[index]->async_wait(handler);
+#else
+    if (m_Timeouts[index])
+    {
+      Timers::stop(m_Timeouts[index].value());
+    }
+
+    m_Timeouts[index] = Timers::oneshot(std::chrono::milliseconds(interval_ms), [=](id_t)
+    {
+      KeepaliveTimerExpired(id, interval_ms);
+    });
+#endif
+  }
+
+  void StormSocketBackend::KeepaliveTimerExpired(StormSocketConnectionId id, int interval_ms)
+  {
+    auto & connection = GetConnection(id);
+    StormLockGuard<StormMutex> lock(connection.m_TimeoutLock);
+
+    if (connection.m_SlotGen != id.GetGen())
+    {
+      return;
+    }
+
+    if (connection.m_Frontend->KeepaliveTick(id, connection.m_FrontendId))
+    {
+      ArmKeepalive(id, interval_ms);
+    }
+  }
+
+  StormSocketConnectionId StormSocketBackend::AllocateConnection(StormSocketFrontend * frontend, const StormSocketIPAddress & remote_addr, uint16_t remote_port, bool for_connect, const void * init_data)
   {
     auto frontend_id = frontend->AllocateFrontendId();
     if (frontend_id == InvalidFrontendId)
@@ -1104,17 +1590,40 @@ namespace StormSockets
         connection.m_UnparsedDataLength = 0;
         connection.m_ParseOffset = 0;
         connection.m_ReadOffset = 0;
-        connection.m_RemoteIP = remote_ip;
+        connection.m_RemoteIP = remote_addr.m_IsV6 ? 0 : remote_addr.m_V4;
+        connection.m_RemoteAddress = remote_addr;
         connection.m_RemotePort = remote_port;
         connection.m_PendingPackets = 0;
         connection.m_DisconnectFlags = 0;
 
         connection.m_SSLContext = SSLContext();
         connection.m_RecvCriticalSection = 0;
+        connection.m_RecvPauseRequested = false;
+        connection.m_RecvParked = false;
+        connection.m_RecvResumed = false;
 
         connection.m_PendingSendBlockStart = InvalidBlockHandle;
         connection.m_PendingSendBlockCur = InvalidBlockHandle;
+        connection.m_PendingSendBlockInFlight = InvalidBlockHandle;
         connection.m_Transmitting = false;
+        connection.m_StagedPackets = 0;
+        connection.m_LockedLane = -1;
+        connection.m_SequenceNext = InvalidBlockHandle;
+        connection.m_DeferredPackets.clear();
+        connection.m_CoalesceWindow = frontend->GetCoalesceWindow();
+        connection.m_CoalesceBytes = frontend->GetCoalesceBytes();
+        connection.m_FlushTimerArmed = false;
+        connection.m_FlushDue = false;
+
+        for (int lane = 0; lane < StormSocketSendPriority::Count; lane++)
+        {
+          connection.m_LaneCredits[lane] = m_SendPriorityWeights[lane];
+        }
+
+        for (auto & ref_count : connection.m_ControlBufferRefs)
+        {
+          ref_count = 0;
+        }
 
         connection.m_PacketsRecved = 0;
         connection.m_PacketsSent = 0;
@@ -1172,7 +1681,7 @@ namespace StormSockets
         if (for_connect == false)
         {
           connection.m_DisconnectFlags |= StormSocketDisconnectFlags::kConnectFinished;
-          frontend->QueueConnectEvent(connection_id, connection.m_FrontendId, remote_ip, remote_port);
+          frontend->QueueConnectEvent(connection_id, connection.m_FrontendId, connection.m_RemoteIP, remote_port);
         }
 
         frontend->AssociateConnectionId(connection_id);
@@ -1237,7 +1746,7 @@ namespace StormSockets
     new_socket.set_option(asio::ip::tcp::no_delay(true), ec);
 
     StormSocketConnectionId connection_id = AllocateConnection(acceptor.m_Frontend,
-      acceptor.m_AcceptEndpoint.address().to_v4().to_ulong(), acceptor.m_AcceptEndpoint.port(), false, nullptr);
+      ToStormAddress(acceptor.m_AcceptEndpoint.address()), acceptor.m_AcceptEndpoint.port(), false, nullptr);
 
     if (connection_id == StormSocketConnectionId::InvalidConnectionId)
     {
@@ -1353,7 +1862,44 @@ namespace StormSockets
 #endif
   }
 
-  void StormSocketBackend::PrepareToConnect(StormSocketConnectionId id, uint32_t addr, uint16_t port)
+#ifndef _INCLUDEOS
+  void StormSocketBackend::ResolveHost(const std::string & host, StormDnsResolveCallback callback)
+  {
+    asio::ip::tcp::resolver::query resolver_query(host, "");
+
+    // getaddrinfo doesn't report a TTL, so the cache's default applies
+    auto resolver_callback = [callback](asio::error_code ec, asio::ip::tcp::resolver::iterator itr)
+    {
+      std::vector<asio::ip::address> resolved;
+      if (!ec)
+      {
+        while (itr != asio::ip::tcp::resolver::iterator())
+        {
+          asio::ip::address addr = itr->endpoint().address();
+          if (std::find(resolved.begin(), resolved.end(), addr) == resolved.end())
+          {
+            resolved.push_back(addr);
+          }
+
+          ++itr;
+        }
+      }
+
+      std::vector<StormSocketIPAddress> addrs;
+      for (auto & addr : resolved)
+      {
+        addrs.push_back(ToStormAddress(addr));
+      }
+
+      callback(addrs.size() > 0, addrs, -1);
+    };
+
+    m_Resolver.async_resolve(resolver_query, resolver_callback);
+  }
+#endif
+
+#ifndef _INCLUDEOS
+  void StormSocketBackend::PrepareToConnect(StormSocketConnectionId id, const std::vector<StormSocketIPAddress> & addrs, uint16_t port)
   {
     auto & connection = GetConnection(id);
     if ((connection.m_DisconnectFlags & StormSocketDisconnectFlags::kAllFlags) != 0)
@@ -1363,24 +1909,165 @@ namespace StormSockets
       return;
     }
 
-#ifndef _INCLUDEOS
-    connection.m_RemoteIP = addr;
-    auto connect_callback = [this, id](asio::error_code ec)
+    auto attempt = std::make_shared<ConnectAttempt>();
+    attempt->m_ConnectionId = id;
+    attempt->m_Port = port;
+
+    // Alternate address families, starting with whichever the resolver put first
+    std::vector<StormSocketIPAddress> preferred, other;
+    for (auto & addr : addrs)
+    {
+      (addr.m_IsV6 == addrs[0].m_IsV6 ? preferred : other).push_back(addr);
+    }
+
+    for (std::size_t index = 0; index < preferred.size() || index < other.size(); index++)
+    {
+      if (index < preferred.size())
+      {
+        attempt->m_Addrs.push_back(preferred[index]);
+      }
+
+      if (index < other.size())
+      {
+        attempt->m_Addrs.push_back(other[index]);
+      }
+    }
+
+    attempt->m_Sockets.resize(attempt->m_Addrs.size());
+    StartConnectAttempt(attempt);
+  }
+
+  void StormSocketBackend::StartConnectAttempt(std::shared_ptr<ConnectAttempt> attempt)
+  {
+    StormLockGuard<StormMutex> lock(attempt->m_Lock);
+    if (attempt->m_Done || attempt->m_NextAddr >= attempt->m_Addrs.size())
+    {
+      return;
+    }
+
+    std::size_t index = attempt->m_NextAddr;
+    attempt->m_NextAddr++;
+    attempt->m_Outstanding++;
+
+    asio::ip::tcp::endpoint ep(ToAsioAddress(attempt->m_Addrs[index]), attempt->m_Port);
+    auto & socket = attempt->m_Sockets[index].emplace(m_IOService);
+
+    asio::error_code ec;
+    socket.open(ep.protocol(), ec);
+    if (ec)
+    {
+      m_IOService.post([this, attempt, index, ec]() { ConnectAttemptComplete(attempt, index, ec); });
+      return;
+    }
+
+    socket.set_option(asio::ip::tcp::no_delay(true), ec);
+    socket.async_connect(ep, [this, attempt, index](const asio::error_code & ec) { ConnectAttemptComplete(attempt, index, ec); });
+
+    if (attempt->m_NextAddr < attempt->m_Addrs.size())
+    {
+      attempt->m_Timer.emplace(m_IOService, std::chrono::steady_clock::now() + std::chrono::milliseconds(m_ConnectAttemptDelay));
+      attempt->m_Timer->async_wait([this, attempt](const asio::error_code & ec)
+      {
+        if (!ec)
+        {
+          StartConnectAttempt(attempt);
+        }
+      });
+    }
+  }
+
+  void StormSocketBackend::ConnectAttemptComplete(std::shared_ptr<ConnectAttempt> attempt, std::size_t index, const asio::error_code & ec)
+  {
+    auto id = attempt->m_ConnectionId;
+    bool connected = false;
+    bool start_next = false;
+    bool failed = false;
+
     {
+      StormLockGuard<StormMutex> lock(attempt->m_Lock);
+      attempt->m_Outstanding--;
+
+      auto & socket = attempt->m_Sockets[index];
+      if (attempt->m_Done)
+      {
+        // Lost the race
+        asio::error_code close_ec;
+        socket->close(close_ec);
+        socket.reset();
+        return;
+      }
+
       if (!ec)
       {
-        FinalizeConnectToHost(id);
+        attempt->m_Done = true;
+        connected = true;
+
+        if (attempt->m_Timer)
+        {
+          attempt->m_Timer->cancel();
+        }
+
+        for (std::size_t other = 0; other < attempt->m_Sockets.size(); other++)
+        {
+          if (other != index && attempt->m_Sockets[other])
+          {
+            asio::error_code close_ec;
+            attempt->m_Sockets[other]->close(close_ec);
+          }
+        }
+
+        auto & connection = GetConnection(id);
+        connection.m_RemoteAddress = attempt->m_Addrs[index];
+        connection.m_RemoteIP = connection.m_RemoteAddress.m_IsV6 ? 0 : connection.m_RemoteAddress.m_V4;
+
+        m_ClientSockets[id].emplace(std::move(*socket));
+        socket.reset();
       }
       else
       {
         StormSocketLog("Failed to connect to server: %d\n", ec.value());
-        ConnectFailed(id);
+
+        asio::error_code close_ec;
+        socket->close(close_ec);
+        socket.reset();
+
+        if (attempt->m_NextAddr < attempt->m_Addrs.size())
+        {
+          // Don't wait out the delay once an attempt has failed
+          start_next = true;
+        }
+        else if (attempt->m_Outstanding == 0)
+        {
+          attempt->m_Done = true;
+          failed = true;
+        }
       }
-    };
-    
-    asio::ip::tcp::endpoint ep(asio::ip::address_v4(addr), port);
-    m_ClientSockets[id]->async_connect(ep, connect_callback);
+    }
+
+    if (connected)
+    {
+      FinalizeConnectToHost(id);
+    }
+    else if (start_next)
+    {
+      StartConnectAttempt(attempt);
+    }
+    else if (failed)
+    {
+      ConnectFailed(id);
+    }
+  }
 #else
+  void StormSocketBackend::PrepareToConnect(StormSocketConnectionId id, uint32_t addr, uint16_t port)
+  {
+    auto & connection = GetConnection(id);
+    if ((connection.m_DisconnectFlags & StormSocketDisconnectFlags::kAllFlags) != 0)
+    {
+      SetDisconnectFlag(id, StormSocketDisconnectFlags::kConnectFinished);
+      SetDisconnectFlag(id, StormSocketDisconnectFlags::kRecvThread);
+      return;
+    }
+
 
     auto net_addr = net::ip4::Addr{ addr };
 
@@ -1404,8 +2091,8 @@ namespace StormSockets
         ProcessNewData(id, true, 0);
       }
     });
-#endif
   }
+#endif
 
   void StormSocketBackend::FinalizeConnectToHost(StormSocketConnectionId connection_id)
   {
@@ -1504,28 +2191,94 @@ namespace StormSockets
   {  
     if (ProcessReceivedData(connection_id, recv_failure) == false)
     {
-#ifndef _INCLUDEOS        
-      auto recheck_callback = [=]()
+      RepostReceivedData(connection_id, recv_failure);
+    }
+    else
+    {
+      if (recv_failure == false)
       {
-        TryProcessReceivedData(connection_id, recv_failure);
-      };
+        auto & connection = GetConnection(connection_id);
+        bool reprocess = false;
+        {
+          StormLockGuard<StormMutex> lock(connection.m_RecvPauseLock);
+          if (connection.m_RecvResumed)
+          {
+            // Resumed while the data was being processed, the frontend may be able to take what's left now
+            connection.m_RecvResumed = false;
+            reprocess = true;
+          }
+          else if (connection.m_RecvPauseRequested)
+          {
+            connection.m_RecvParked = true;
+            return;
+          }
+        }
+
+        if (reprocess)
+        {
+          RepostReceivedData(connection_id, false);
+        }
+        else
+        {
+          PrepareToRecv(connection_id);
+        }
+      }
+    } 
+  }
+
+  void StormSocketBackend::RepostReceivedData(StormSocketConnectionId connection_id, bool recv_failure)
+  {
+#ifndef _INCLUDEOS        
+    auto recheck_callback = [=]()
+    {
+      TryProcessReceivedData(connection_id, recv_failure);
+    };
 
-      ProfileScope prof(ProfilerCategory::kRepost);
-      m_IOService.post(recheck_callback);
+    ProfileScope prof(ProfilerCategory::kRepost);
+    m_IOService.post(recheck_callback);
 #else
-      Events::get().defer([=]()
-      {
-        TryProcessReceivedData(connection_id, recv_failure);
-      });
+    Events::get().defer([=]()
+    {
+      TryProcessReceivedData(connection_id, recv_failure);
+    });
 #endif
+  }
+
+  void StormSocketBackend::PauseReceive(StormSocketConnectionId id)
+  {
+    auto & connection = GetConnection(id);
+    StormLockGuard<StormMutex> lock(connection.m_RecvPauseLock);
+    if (id.GetGen() != connection.m_SlotGen)
+    {
+      return;
     }
-    else
+
+    connection.m_RecvPauseRequested = true;
+    connection.m_RecvResumed = false;
+  }
+
+  void StormSocketBackend::ResumeReceive(StormSocketConnectionId id)
+  {
+    auto & connection = GetConnection(id);
     {
-      if (recv_failure == false)
+      StormLockGuard<StormMutex> lock(connection.m_RecvPauseLock);
+      if (id.GetGen() != connection.m_SlotGen || connection.m_RecvPauseRequested == false)
       {
-        PrepareToRecv(connection_id);
+        return;
       }
-    } 
+
+      connection.m_RecvPauseRequested = false;
+      if (connection.m_RecvParked == false)
+      {
+        // The read thread hasn't parked yet, have it pick the data back up instead
+        connection.m_RecvResumed = true;
+        return;
+      }
+
+      connection.m_RecvParked = false;
+    }
+
+    RepostReceivedData(id, false);
   }
 
   void StormSocketBackend::SignalOutgoingSocket(StormSocketConnectionId connection_id, StormSocketIOOperationType::Index type, std::size_t size)
@@ -1571,6 +2324,7 @@ namespace StormSockets
         if (size >= (std::size_t)send_block->m_DataLen)
         {
           size -= send_block->m_DataLen;
+          connection.m_StagedPackets -= send_block->m_Staged ? 1 : 0;
           block_handle = ReleasePendingSendBlock(block_handle, send_block);
         }
         else
@@ -1594,6 +2348,7 @@ namespace StormSockets
           }
         }
 
+        StagePendingPackets(connection_id, false);
         TransmitConnectionPackets(connection_id);
       }
     }
@@ -1614,6 +2369,8 @@ namespace StormSockets
         return;
       }
 
+      StagePendingPackets(connection_id, true);
+
       connection.m_Closing = true;
       if (connection.m_PendingSendBlockStart == InvalidBlockHandle)
       {
@@ -1622,89 +2379,14 @@ namespace StormSockets
     }
     else if (type == StormSocketIOOperationType::QueuePacket)
     {
-      if (connection_gen != connection.m_SlotGen)
-      {
-        return;
-      }
-
-      if ((connection.m_DisconnectFlags & StormSocketDisconnectFlags::kSendThread) != 0)
-      {
-        return;
-      }
-
-      if (connection.m_Closing)
-      {
-        return;
-      }
-
-      StormMessageWriter writer;
-      if (m_OutputQueue[connection_id].TryDequeue(writer, connection_gen, m_OutputQueueIncdices.get(), m_OutputQueueArray.get()))
-      {
-        uint64_t prof = Profiling::StartProfiler();
-
-#ifndef DISABLE_MBED
-        if (writer.m_IsEncrypted == false && connection.m_Frontend->UseSSL(connection_id, connection.m_FrontendId))
-        {
-          StormMessageWriter encrypted = EncryptWriter(connection_id, writer);
-          FreeOutgoingPacket(writer);
-
-          writer = encrypted;
-        }
-#endif
-
-        StormFixedBlockHandle block_handle = writer.m_PacketInfo->m_StartBlock;;
-        int header_offset = writer.m_PacketInfo->m_SendOffset;
-        int pending_data = writer.m_PacketInfo->m_TotalLength;
-
-        while (block_handle != InvalidBlockHandle)
-        {
-          int potential_data_in_block = m_FixedBlockSize - header_offset - (writer.m_ReservedHeaderLength + writer.m_ReservedTrailerLength);
-          int block_len = std::min(pending_data, potential_data_in_block);
-          int data_start = writer.m_ReservedHeaderLength - writer.m_HeaderLength + header_offset;
-          int data_length = writer.m_HeaderLength + block_len + writer.m_TrailerLength;
-
-          void * block = m_Allocator.ResolveHandle(block_handle);
-          block_handle = m_Allocator.GetNextBlock(block_handle);
-
-          StormFixedBlockHandle outgoing_block_handle = m_PendingSendBlocks.AllocateBlock(StormFixedBlockType::SendBlock);
-          StormPendingSendBlock * outgoing_block = (StormPendingSendBlock *)m_PendingSendBlocks.ResolveHandle(outgoing_block_handle);
-
-          outgoing_block->m_DataLen = data_length;
-          outgoing_block->m_DataStart = Marshal::MemOffset(block, data_start);
-
-          if (block_handle == InvalidBlockHandle)
-          {
-            outgoing_block->m_RefCount = &writer.m_PacketInfo->m_RefCount;
-            outgoing_block->m_StartBlock = writer.m_PacketInfo->m_StartBlock;
-            outgoing_block->m_PacketHandle = writer.m_PacketHandle;
-          }
-          else
-          {
-            outgoing_block->m_RefCount = nullptr;
-          }
-
-          if (connection.m_PendingSendBlockCur != InvalidBlockHandle)
-          {
-            m_PendingSendBlocks.SetNextBlock(connection.m_PendingSendBlockCur, outgoing_block_handle);
-          }
-          else
-          {
-            connection.m_PendingSendBlockStart = outgoing_block_handle;
-          }
-
-          connection.m_PendingSendBlockCur = outgoing_block_handle;
-
-          header_offset = 0;
-          pending_data -= block_len;
-        }
-
-        TransmitConnectionPackets(connection_id);
-
-        Profiling::EndProfiler(prof, ProfilerCategory::kSend);
-      }
-    }
-#endif
-  }
+      ProcessQueuePacket(connection_id);
+    }
+    else if (type == StormSocketIOOperationType::QueueControl)
+    {
+      ProcessQueueControl(connection_id, (int)size);
+    }
+#endif
+  }
 
   bool StormSocketBackend::ProcessReceivedData(StormSocketConnectionId connection_id, bool recv_failure)
   {
@@ -1837,14 +2519,18 @@ namespace StormSockets
   {
     StormSocketIOOperation op;
 
-    StormMessageWriter writer;
-
     while (m_ThreadStopRequested == false)
     {
       m_SendThreadSemaphores[thread_index].WaitOne(100);
 
       while (m_SendQueue[thread_index].TryDequeue(op, 0, m_SendQueueIncdices.get(), m_SendQueueArray.get()))
       {
+        if (op.m_Type == StormSocketIOOperationType::QueuePacketBatch)
+        {
+          ProcessQueuePacketBatch(op);
+          continue;
+        }
+
         StormSocketConnectionId connection_id = op.m_ConnectionId;
         int connection_gen = connection_id.GetGen();
         auto & connection = GetConnection(connection_id);
@@ -1874,12 +2560,20 @@ namespace StormSockets
             if (op.m_Size >= send_block->m_DataLen)
             {
               op.m_Size -= send_block->m_DataLen;
+              connection.m_StagedPackets -= send_block->m_Staged ? 1 : 0;
               block_handle = ReleasePendingSendBlock(block_handle, send_block);
             }
             else
             {
               send_block->m_DataLen -= op.m_Size;
-              send_block->m_DataStart = Marshal::MemOffset(send_block->m_DataStart, op.m_Size);
+              if (send_block->m_FileDescriptor >= 0)
+              {
+                send_block->m_FileOffset += op.m_Size;
+              }
+              else
+              {
+                send_block->m_DataStart = Marshal::MemOffset(send_block->m_DataStart, op.m_Size);
+              }
               break;
             }
           }
@@ -1897,6 +2591,7 @@ namespace StormSockets
               }
             }
 
+            StagePendingPackets(connection_id, false);
             TransmitConnectionPackets(connection_id);
           }
         }
@@ -1918,6 +2613,8 @@ namespace StormSockets
             continue;
           }
 
+          StagePendingPackets(connection_id, true);
+
           connection.m_Closing = true;
           if (connection.m_PendingSendBlockStart == InvalidBlockHandle)
           {
@@ -1925,95 +2622,431 @@ namespace StormSockets
             m_ClientSockets[connection_id]->shutdown(asio::socket_base::shutdown_send, ec);
             SignalCloseThread(connection_id);
           }
+          else
+          {
+            TransmitConnectionPackets(connection_id, true);
+          }
         }
-        else if (op.m_Type == StormSocketIOOperationType::QueuePacket)
+        else if (op.m_Type == StormSocketIOOperationType::Flush)
         {
           if (connection_gen != connection.m_SlotGen)
           {
             continue;
           }
 
-          if ((connection.m_DisconnectFlags & StormSocketDisconnectFlags::kSendThread) != 0)
-          {
-            continue;
-          }
+          connection.m_FlushTimerArmed = false;
+          connection.m_FlushDue = true;
+          TransmitConnectionPackets(connection_id);
+        }
+        else if (op.m_Type == StormSocketIOOperationType::QueuePacket)
+        {
+          ProcessQueuePacket(connection_id);
+        }
+        else if (op.m_Type == StormSocketIOOperationType::QueueFile)
+        {
+          ProcessQueueFile(connection_id, op.m_SendBlock);
+        }
+        else if (op.m_Type == StormSocketIOOperationType::QueueControl)
+        {
+          ProcessQueueControl(connection_id, op.m_Size);
+        }
+      }
+    }
+  }
 
-          if (connection.m_Closing)
+  void StormSocketBackend::ProcessQueuePacketBatch(StormSocketIOOperation & op)
+  {
+    int ids_per_block = m_FixedBlockSize / sizeof(StormSocketConnectionId);
+
+    StormFixedBlockHandle block_handle = op.m_BatchBlock;
+    StormSocketConnectionId * block_ids = (StormSocketConnectionId *)m_Allocator.ResolveHandle(block_handle);
+
+    for (int index = 0; index < op.m_Size; index++)
+    {
+      int block_offset = index % ids_per_block;
+      if (block_offset == 0 && index > 0)
+      {
+        block_handle = m_Allocator.GetNextBlock(block_handle);
+        block_ids = (StormSocketConnectionId *)m_Allocator.ResolveHandle(block_handle);
+      }
+
+      ProcessQueuePacket(block_ids[block_offset]);
+    }
+
+    m_Allocator.FreeBlockChain(op.m_BatchBlock, StormFixedBlockType::BlockMem);
+  }
+
+#endif
+
+  void StormSocketBackend::ProcessQueuePacket(StormSocketConnectionId connection_id)
+  {
+    int connection_gen = connection_id.GetGen();
+    auto & connection = GetConnection(connection_id);
+
+    if (connection_gen != connection.m_SlotGen)
+    {
+      return;
+    }
+
+    if ((connection.m_DisconnectFlags & StormSocketDisconnectFlags::kSendThread) != 0)
+    {
+      return;
+    }
+
+    if (connection.m_Closing)
+    {
+      return;
+    }
+
+    uint64_t prof = Profiling::StartProfiler();
+
+    StagePendingPackets(connection_id, false);
+
+    TransmitConnectionPackets(connection_id);
+    Profiling::EndProfiler(prof, ProfilerCategory::kSend);
+  }
+
+  bool StormSocketBackend::DequeueOutgoingPacket(StormSocketConnectionId connection_id, StormMessageWriter & writer)
+  {
+    int connection_gen = connection_id.GetGen();
+    auto & connection = GetConnection(connection_id);
+
+    if (connection.m_LockedLane >= 0)
+    {
+      // Control frames can still go out between the packets of the locked message, even from behind High lane data
+      if (connection.m_LockedLane != StormSocketSendPriority::High)
+      {
+        int control_index = connection_id * StormSocketSendPriority::Count + StormSocketSendPriority::High;
+        while ((int)connection.m_DeferredPackets.size() < m_MaxPendingOutgoingPackets &&
+          m_OutputQueue[control_index].TryDequeue(writer, connection_gen, m_OutputQueueIncdices.get(), m_OutputQueueArray.get()))
+        {
+          if (writer.m_ControlFrame)
           {
-            continue;
+            return true;
           }
 
-          if (m_OutputQueue[connection_id].TryDequeue(writer, connection_gen, m_OutputQueueIncdices.get(), m_OutputQueueArray.get()))
-          {
-            uint64_t prof = Profiling::StartProfiler();
+          // Data has to wait for the locked message to finish, and keeps its place ahead of the rest of the lane
+          connection.m_DeferredPackets.push_back(writer);
+        }
+      }
+
+      if (connection.m_SequenceNext != InvalidBlockHandle)
+      {
+        writer = GetSequencePacket(connection.m_SequenceNext);
+      }
+      else if (connection.m_LockedLane == StormSocketSendPriority::High && connection.m_DeferredPackets.size() > 0)
+      {
+        // The rest of a deferred message is ahead of whatever is still in the lane
+        writer = connection.m_DeferredPackets.front();
+        connection.m_DeferredPackets.pop_front();
+      }
+      else
+      {
+        int queue_index = connection_id * StormSocketSendPriority::Count + connection.m_LockedLane;
+        if (m_OutputQueue[queue_index].TryDequeue(writer, connection_gen, m_OutputQueueIncdices.get(), m_OutputQueueArray.get()) == false)
+        {
+          return false;
+        }
+
+        if (writer.m_ControlFrame)
+        {
+          return true;
+        }
+      }
+
+      BeginOutgoingPacket(connection, writer, connection.m_LockedLane);
+      return true;
+    }
+
+    if (connection.m_DeferredPackets.size() > 0)
+    {
+      writer = connection.m_DeferredPackets.front();
+      connection.m_DeferredPackets.pop_front();
+      connection.m_LaneCredits[StormSocketSendPriority::High]--;
+      BeginOutgoingPacket(connection, writer, StormSocketSendPriority::High);
+      return true;
+    }
+
+    // Weighted round robin - a lane that has used up its weight waits for the next round unless every other lane is empty
+    for (int pass = 0; pass < 2; pass++)
+    {
+      for (int lane = 0; lane < StormSocketSendPriority::Count; lane++)
+      {
+        if (connection.m_LaneCredits[lane] <= 0)
+        {
+          continue;
+        }
+
+        int queue_index = connection_id * StormSocketSendPriority::Count + lane;
+        if (m_OutputQueue[queue_index].TryDequeue(writer, connection_gen, m_OutputQueueIncdices.get(), m_OutputQueueArray.get()))
+        {
+          connection.m_LaneCredits[lane]--;
+          BeginOutgoingPacket(connection, writer, lane);
+          return true;
+        }
+      }
+
+      for (int lane = 0; lane < StormSocketSendPriority::Count; lane++)
+      {
+        connection.m_LaneCredits[lane] = m_SendPriorityWeights[lane];
+      }
+    }
+
+    return false;
+  }
+
+  void StormSocketBackend::BeginOutgoingPacket(StormSocketConnectionBase & connection, StormMessageWriter & writer, int lane)
+  {
+    connection.m_SequenceNext = writer.m_PacketInfo->m_NextPacket;
+    connection.m_LockedLane = (writer.m_HoldsLane || connection.m_SequenceNext != InvalidBlockHandle) ? lane : -1;
+  }
+
+  void StormSocketBackend::StagePendingPackets(StormSocketConnectionId connection_id, bool flush)
+  {
+    int connection_gen = connection_id.GetGen();
+    auto & connection = GetConnection(connection_id);
+
+    if (connection_gen != connection.m_SlotGen ||
+      (connection.m_DisconnectFlags & StormSocketDisconnectFlags::kSendThread) != 0 ||
+      connection.m_Closing)
+    {
+      return;
+    }
+
+    // Packets stay in their lanes until there's room, so a later high priority packet can still go ahead of them
+    while (flush || connection.m_StagedPackets < m_MaxStagedPackets)
+    {
+      StormMessageWriter writer;
+      if (DequeueOutgoingPacket(connection_id, writer) == false)
+      {
+        return;
+      }
 
 #ifndef DISABLE_MBED
-            if (writer.m_IsEncrypted == false && connection.m_Frontend->UseSSL(connection_id, connection.m_FrontendId))
-            {
-              StormMessageWriter encrypted = EncryptWriter(connection_id, writer);
-              FreeOutgoingPacket(writer);
+      if (writer.m_IsEncrypted == false && connection.m_Frontend->UseSSL(connection_id, connection.m_FrontendId))
+      {
+        StormMessageWriter encrypted = EncryptWriter(connection_id, writer);
+        FreeOutgoingPacket(writer);
 
-              writer = encrypted;
-            }
+        writer = encrypted;
+      }
 #endif
 
-            StormFixedBlockHandle block_handle = writer.m_PacketInfo->m_StartBlock;;
-            int header_offset = writer.m_PacketInfo->m_SendOffset;
-            int pending_data = writer.m_PacketInfo->m_TotalLength;
+      StormFixedBlockHandle last_block_handle;
+      StormFixedBlockHandle start_block_handle = CreatePendingSendBlocks(writer, last_block_handle);
 
-            while (block_handle != InvalidBlockHandle)
-            {
-              int potential_data_in_block = m_FixedBlockSize - header_offset - (writer.m_ReservedHeaderLength + writer.m_ReservedTrailerLength);
-              int block_len = std::min(pending_data, potential_data_in_block);
-              int data_start = writer.m_ReservedHeaderLength - writer.m_HeaderLength + header_offset;
-              int data_length = writer.m_HeaderLength + block_len + writer.m_TrailerLength;
+      StormPendingSendBlock * last_block = (StormPendingSendBlock *)m_PendingSendBlocks.ResolveHandle(last_block_handle);
+      last_block->m_Staged = true;
+      connection.m_StagedPackets++;
 
-              void * block = m_Allocator.ResolveHandle(block_handle);
-              block_handle = m_Allocator.GetNextBlock(block_handle);
+      if (connection.m_PendingSendBlockCur != InvalidBlockHandle)
+      {
+        m_PendingSendBlocks.SetNextBlock(connection.m_PendingSendBlockCur, start_block_handle);
+      }
+      else
+      {
+        connection.m_PendingSendBlockStart = start_block_handle;
+      }
 
-              StormFixedBlockHandle outgoing_block_handle = m_PendingSendBlocks.AllocateBlock(StormFixedBlockType::SendBlock);
-              StormPendingSendBlock * outgoing_block = (StormPendingSendBlock *)m_PendingSendBlocks.ResolveHandle(outgoing_block_handle);
+      connection.m_PendingSendBlockCur = last_block_handle;
+    }
+  }
 
-              outgoing_block->m_DataLen = data_length;
-              outgoing_block->m_DataStart = Marshal::MemOffset(block, data_start);
+  void StormSocketBackend::ProcessQueueFile(StormSocketConnectionId connection_id, StormFixedBlockHandle file_block_handle)
+  {
+    int connection_gen = connection_id.GetGen();
+    auto & connection = GetConnection(connection_id);
 
-              if (block_handle == InvalidBlockHandle)
-              {
-                outgoing_block->m_RefCount = &writer.m_PacketInfo->m_RefCount;
-                outgoing_block->m_StartBlock = writer.m_PacketInfo->m_StartBlock;
-                outgoing_block->m_PacketHandle = writer.m_PacketHandle;
-              }
-              else
-              {
-                outgoing_block->m_RefCount = nullptr;
-              }
+    if (connection_gen != connection.m_SlotGen ||
+      (connection.m_DisconnectFlags & StormSocketDisconnectFlags::kSendThread) != 0 ||
+      connection.m_Closing)
+    {
+      while (file_block_handle != InvalidBlockHandle)
+      {
+        file_block_handle = ReleasePendingSendBlock(file_block_handle, (StormPendingSendBlock *)m_PendingSendBlocks.ResolveHandle(file_block_handle));
+      }
 
-              if (connection.m_PendingSendBlockCur != InvalidBlockHandle)
-              {
-                m_PendingSendBlocks.SetNextBlock(connection.m_PendingSendBlockCur, outgoing_block_handle);
-              }
-              else
-              {
-                connection.m_PendingSendBlockStart = outgoing_block_handle;
-              }
+      return;
+    }
 
-              connection.m_PendingSendBlockCur = outgoing_block_handle;
+    // Anything queued before the file has to go out before it
+    StagePendingPackets(connection_id, true);
 
-              header_offset = 0;
-              pending_data -= block_len;
-            }
+    StormFixedBlockHandle last_block_handle = file_block_handle;
+    while (m_PendingSendBlocks.GetNextBlock(last_block_handle) != InvalidBlockHandle)
+    {
+      last_block_handle = m_PendingSendBlocks.GetNextBlock(last_block_handle);
+    }
 
-            TransmitConnectionPackets(connection_id);
-            Profiling::EndProfiler(prof, ProfilerCategory::kSend);
-          }
-        }
+    if (connection.m_PendingSendBlockCur != InvalidBlockHandle)
+    {
+      m_PendingSendBlocks.SetNextBlock(connection.m_PendingSendBlockCur, file_block_handle);
+    }
+    else
+    {
+      connection.m_PendingSendBlockStart = file_block_handle;
+    }
+
+    connection.m_PendingSendBlockCur = last_block_handle;
+
+    // The file goes out through its own path, so nothing is gained by holding the data in front of it
+    TransmitConnectionPackets(connection_id, true);
+  }
+
+  void StormSocketBackend::ProcessQueueControl(StormSocketConnectionId connection_id, int buffer_index)
+  {
+    int connection_gen = connection_id.GetGen();
+    auto & connection = GetConnection(connection_id);
+
+    // A stale buffer gets reset when the slot is reallocated
+    if (connection_gen != connection.m_SlotGen)
+    {
+      return;
+    }
+
+    if ((connection.m_DisconnectFlags & StormSocketDisconnectFlags::kSendThread) != 0 || connection.m_Closing)
+    {
+      connection.m_ControlBufferRefs[buffer_index] = 0;
+      return;
+    }
+
+    StormFixedBlockHandle control_block_handle = m_PendingSendBlocks.AllocateBlock(StormFixedBlockType::SendBlock);
+    StormPendingSendBlock * control_block = (StormPendingSendBlock *)m_PendingSendBlocks.ResolveHandle(control_block_handle);
+
+    control_block->m_DataStart = connection.m_ControlBuffers[buffer_index];
+    control_block->m_DataLen = connection.m_ControlBufferLength[buffer_index];
+    control_block->m_StartBlock = InvalidBlockHandle;
+    control_block->m_PacketHandle = InvalidBlockHandle;
+    control_block->m_RefCount = &connection.m_ControlBufferRefs[buffer_index];
+    control_block->m_FileDescriptor = -1;
+    control_block->m_Staged = false;
+
+    // Skip past whatever is on the wire, then slot in at the end of the next whole packet so frames aren't split
+    StormFixedBlockHandle insert_after = connection.m_PendingSendBlockCur;
+    StormFixedBlockHandle block_handle = connection.m_PendingSendBlockStart;
+    bool past_in_flight = connection.m_Transmitting == false;
+
+    while (block_handle != InvalidBlockHandle)
+    {
+      StormPendingSendBlock * send_block = (StormPendingSendBlock *)m_PendingSendBlocks.ResolveHandle(block_handle);
+      if (send_block->m_FileDescriptor >= 0)
+      {
+        break;
+      }
+
+      if (block_handle == connection.m_PendingSendBlockInFlight)
+      {
+        past_in_flight = true;
+      }
+
+      if (past_in_flight && send_block->m_RefCount != nullptr)
+      {
+        insert_after = block_handle;
+        break;
+      }
+
+      block_handle = m_PendingSendBlocks.GetNextBlock(block_handle);
+    }
+
+    if (insert_after == InvalidBlockHandle)
+    {
+      connection.m_PendingSendBlockStart = control_block_handle;
+      connection.m_PendingSendBlockCur = control_block_handle;
+    }
+    else
+    {
+      m_PendingSendBlocks.SetNextBlock(control_block_handle, m_PendingSendBlocks.GetNextBlock(insert_after));
+      m_PendingSendBlocks.SetNextBlock(insert_after, control_block_handle);
+
+      if (insert_after == connection.m_PendingSendBlockCur)
+      {
+        connection.m_PendingSendBlockCur = control_block_handle;
       }
     }
+
+    TransmitConnectionPackets(connection_id, true);
   }
 
-#endif
+  StormFixedBlockHandle StormSocketBackend::CreatePendingSendBlocks(StormMessageWriter & writer, StormFixedBlockHandle & last_block_handle)
+  {
+    StormFixedBlockHandle start_block_handle = InvalidBlockHandle;
+    last_block_handle = InvalidBlockHandle;
+
+    StormFixedBlockHandle block_handle = writer.m_PacketInfo->m_StartBlock;
+    int header_offset = writer.m_PacketInfo->m_SendOffset;
+    int pending_data = writer.m_PacketInfo->m_TotalLength;
+
+    while (block_handle != InvalidBlockHandle)
+    {
+      int potential_data_in_block = m_FixedBlockSize - header_offset - (writer.m_ReservedHeaderLength + writer.m_ReservedTrailerLength);
+      int block_len = std::min(pending_data, potential_data_in_block);
+      int data_start = writer.m_ReservedHeaderLength - writer.m_HeaderLength + header_offset;
+      int data_length = writer.m_HeaderLength + block_len + writer.m_TrailerLength;
+
+      void * block = m_Allocator.ResolveHandle(block_handle);
+      block_handle = m_Allocator.GetNextBlock(block_handle);
+
+      StormFixedBlockHandle outgoing_block_handle = m_PendingSendBlocks.AllocateBlock(StormFixedBlockType::SendBlock);
+      StormPendingSendBlock * outgoing_block = (StormPendingSendBlock *)m_PendingSendBlocks.ResolveHandle(outgoing_block_handle);
+
+      outgoing_block->m_DataLen = data_length;
+      outgoing_block->m_DataStart = Marshal::MemOffset(block, data_start);
+      outgoing_block->m_FileDescriptor = -1;
+      outgoing_block->m_Staged = false;
+
+      if (block_handle == InvalidBlockHandle && writer.m_PacketInfo->m_SliceLength == 0)
+      {
+        outgoing_block->m_RefCount = &writer.m_PacketInfo->m_RefCount;
+        outgoing_block->m_StartBlock = writer.m_PacketInfo->m_StartBlock;
+        outgoing_block->m_PacketHandle = writer.m_PacketHandle;
+      }
+      else
+      {
+        outgoing_block->m_RefCount = nullptr;
+      }
+
+      if (last_block_handle != InvalidBlockHandle)
+      {
+        m_PendingSendBlocks.SetNextBlock(last_block_handle, outgoing_block_handle);
+      }
+      else
+      {
+        start_block_handle = outgoing_block_handle;
+      }
+
+      last_block_handle = outgoing_block_handle;
+
+      header_offset = 0;
+      pending_data -= block_len;
+    }
+
+    // Sliced bytes are sent in place, and the packet is only released once the last of them is on the wire
+    ForEachSliceSegment(m_Allocator, writer.m_PacketInfo, [&](void * data, int length, bool last)
+    {
+      StormFixedBlockHandle outgoing_block_handle = m_PendingSendBlocks.AllocateBlock(StormFixedBlockType::SendBlock);
+      StormPendingSendBlock * outgoing_block = (StormPendingSendBlock *)m_PendingSendBlocks.ResolveHandle(outgoing_block_handle);
+
+      outgoing_block->m_DataLen = length;
+      outgoing_block->m_DataStart = data;
+      outgoing_block->m_FileDescriptor = -1;
+      outgoing_block->m_Staged = false;
+      outgoing_block->m_RefCount = nullptr;
+
+      if (last)
+      {
+        outgoing_block->m_RefCount = &writer.m_PacketInfo->m_RefCount;
+        outgoing_block->m_StartBlock = writer.m_PacketInfo->m_StartBlock;
+        outgoing_block->m_PacketHandle = writer.m_PacketHandle;
+      }
 
-  void StormSocketBackend::TransmitConnectionPackets(StormSocketConnectionId connection_id)
+      m_PendingSendBlocks.SetNextBlock(last_block_handle, outgoing_block_handle);
+      last_block_handle = outgoing_block_handle;
+    });
+
+    return start_block_handle;
+  }
+
+  void StormSocketBackend::TransmitConnectionPackets(StormSocketConnectionId connection_id, bool flush)
   {
     auto & connection = GetConnection(connection_id);
     if (connection.m_Transmitting)
@@ -2033,6 +3066,23 @@ namespace StormSockets
     }
 
 #ifndef _INCLUDEOS
+    StormPendingSendBlock * start_block = (StormPendingSendBlock *)m_PendingSendBlocks.ResolveHandle(block_handle);
+    if (start_block->m_FileDescriptor >= 0)
+    {
+      if (TransmitFileBlock(connection_id))
+      {
+        return;
+      }
+
+      if (ExpandFileBlock(connection_id) == false)
+      {
+        SetSocketDisconnected(connection_id);
+        return;
+      }
+
+      block_handle = connection.m_PendingSendBlockStart;
+    }
+
     SendBuffer buffer_set;
     int buffer_size = 0;
     int total_size = 0;
@@ -2045,15 +3095,33 @@ namespace StormSockets
       }
 
       StormPendingSendBlock * send_block = (StormPendingSendBlock *) m_PendingSendBlocks.ResolveHandle(block_handle);
+      if (send_block->m_FileDescriptor >= 0)
+      {
+        break;
+      }
+
       buffer_set[buffer_size] = asio::buffer(send_block->m_DataStart, send_block->m_DataLen);
 
       total_size += send_block->m_DataLen;
+      connection.m_PendingSendBlockInFlight = block_handle;
 
       block_handle = m_PendingSendBlocks.GetNextBlock(block_handle);
     }
 
     if (buffer_size > 0)
     {
+      // Hold a small write back so later ones can join it, unless it's been held long enough or there's more queued than fits
+      bool coalesce = flush == false && connection.m_FlushDue == false && connection.m_Closing == false &&
+        connection.m_CoalesceWindow > 0 && total_size < connection.m_CoalesceBytes && block_handle == InvalidBlockHandle;
+
+      if (coalesce)
+      {
+        ArmFlushTimer(connection_id);
+        return;
+      }
+
+      connection.m_FlushDue = false;
+
       auto send_callback = [=](const asio::error_code & error, std::size_t bytes_transfered)
       {
         if (!error)
@@ -2101,14 +3169,190 @@ namespace StormSockets
 #endif
   }
 
+#ifndef _INCLUDEOS
+  void StormSocketBackend::ArmFlushTimer(StormSocketConnectionId connection_id)
+  {
+    auto & connection = GetConnection(connection_id);
+    if (connection.m_FlushTimerArmed)
+    {
+      return;
+    }
+
+    auto handler = [=](const asio::error_code & error)
+    {
+      if (!error)
+      {
+        SignalOutgoingSocket(connection_id, StormSocketIOOperationType::Flush);
+      }
+    };
+
+    // Only this connection's send thread touches the timer
+    int index = connection_id.GetIndex();
+    m_FlushTimers[index].emplace(m_IOService, std::chrono::steady_clock::now() + std::chrono::microseconds(connection.m_CoalesceWindow));
+    m_FlushTimers[index]->async_wait(handler);
+
+    connection.m_FlushTimerArmed = true;
+  }
+
+  bool StormSocketBackend::TransmitFileBlock([[maybe_unused]] StormSocketConnectionId connection_id)
+  {
+#ifdef _LINUX
+    auto & connection = GetConnection(connection_id);
+    if (connection.m_Frontend->UseSSL(connection_id, connection.m_FrontendId))
+    {
+      return false;
+    }
+
+    StormPendingSendBlock * file_block = (StormPendingSendBlock *)m_PendingSendBlocks.ResolveHandle(connection.m_PendingSendBlockStart);
+
+    off_t file_offset = (off_t)file_block->m_FileOffset;
+    int send_size = std::min(file_block->m_DataLen, m_MaxFileBlocksInFlight * m_FixedBlockSize);
+
+    auto & socket = *m_ClientSockets[connection_id];
+
+    asio::error_code ec;
+    socket.native_non_blocking(true, ec);
+    if (ec)
+    {
+      return false;
+    }
+
+    // The send queue can be cleared while the wait is outstanding, which closes the block's file, so the callback gets its own
+    int file_fd = StormFileDuplicate(file_block->m_FileDescriptor);
+    if (file_fd < 0)
+    {
+      return false;
+    }
+
+    auto native_socket = socket.native_handle();
+    auto send_callback = [=](const asio::error_code & error) mutable
+    {
+      if (error)
+      {
+        StormFileClose(file_fd);
+        SetSocketDisconnected(connection_id);
+        return;
+      }
+
+      auto bytes_transfered = sendfile(native_socket, file_fd, &file_offset, send_size);
+      int send_error = errno;
+      StormFileClose(file_fd);
+
+      if (bytes_transfered < 0 && (send_error == EAGAIN || send_error == EWOULDBLOCK || send_error == EINTR))
+      {
+        bytes_transfered = 0;
+      }
+      else if (bytes_transfered <= 0)
+      {
+        // Either a socket error or the file got shorter than the response claimed
+        SetSocketDisconnected(connection_id);
+        return;
+      }
+
+      SignalOutgoingSocket(connection_id, StormSocketIOOperationType::FreePacket, bytes_transfered);
+    };
+
+    connection.m_PendingSendBlockInFlight = connection.m_PendingSendBlockStart;
+    connection.m_Transmitting = true;
+    socket.async_wait(asio::socket_base::wait_write, send_callback);
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  bool StormSocketBackend::ExpandFileBlock(StormSocketConnectionId connection_id)
+  {
+    auto & connection = GetConnection(connection_id);
+
+    StormFixedBlockHandle file_block_handle = connection.m_PendingSendBlockStart;
+    StormPendingSendBlock * file_block = (StormPendingSendBlock *)m_PendingSendBlocks.ResolveHandle(file_block_handle);
+
+    int chunk_size = std::min(file_block->m_DataLen, m_MaxFileBlocksInFlight * m_FixedBlockSize);
+
+    StormFileMapping mapping;
+    if (StormFileMap(file_block->m_FileDescriptor, file_block->m_FileOffset, chunk_size, mapping) == false)
+    {
+      StormSocketLog("Could not map response body file\n");
+      return false;
+    }
+
+    StormMessageWriter writer;
+
+#ifndef DISABLE_MBED
+    if (connection.m_Frontend->UseSSL(connection_id, connection.m_FrontendId))
+    {
+      auto prof = ProfileScope(ProfilerCategory::kSSLEncrypt);
+
+      const uint8_t * data = (const uint8_t *)mapping.m_Data;
+      int data_to_encrypt = chunk_size;
+
+      while (data_to_encrypt > 0)
+      {
+        int ec = mbedtls_ssl_write(&connection.m_SSLContext.m_SSLContext, data, data_to_encrypt);
+        if (ec < 0)
+        {
+          StormFileUnmap(mapping);
+          return false;
+        }
+
+        data += ec;
+        data_to_encrypt -= ec;
+      }
+
+      writer = connection.m_EncryptWriter;
+      connection.m_EncryptWriter = CreateWriter(true);
+    }
+    else
+#endif
+    {
+      writer = CreateWriter();
+      writer.WriteByteBlock(mapping.m_Data, 0, chunk_size);
+    }
+
+    StormFileUnmap(mapping);
+
+    file_block->m_DataLen -= chunk_size;
+    file_block->m_FileOffset += chunk_size;
+
+    // The chunk goes in front of what's left of the file, the pending blocks own the only reference to it
+    StormFixedBlockHandle last_block_handle;
+    StormFixedBlockHandle start_block_handle = CreatePendingSendBlocks(writer, last_block_handle);
+
+    if (file_block->m_DataLen == 0)
+    {
+      StormFixedBlockHandle next_block_handle = ReleasePendingSendBlock(file_block_handle, file_block);
+      m_PendingSendBlocks.SetNextBlock(last_block_handle, next_block_handle);
+
+      if (next_block_handle == InvalidBlockHandle)
+      {
+        connection.m_PendingSendBlockCur = last_block_handle;
+      }
+    }
+    else
+    {
+      m_PendingSendBlocks.SetNextBlock(last_block_handle, file_block_handle);
+    }
+
+    connection.m_PendingSendBlockStart = start_block_handle;
+    return true;
+  }
+#endif
+
   StormFixedBlockHandle StormSocketBackend::ReleasePendingSendBlock(StormFixedBlockHandle send_block_handle, StormPendingSendBlock * send_block)
   {
+    if (send_block->m_FileDescriptor >= 0 && send_block->m_CloseFile)
+    {
+      StormFileClose(send_block->m_FileDescriptor);
+    }
+
     if (send_block->m_RefCount)
     {
-      if (send_block->m_RefCount->fetch_sub(1) == 1)
+      // Control buffers live in the connection, so there's nothing else to free
+      if (send_block->m_RefCount->fetch_sub(1) == 1 && send_block->m_PacketHandle != InvalidBlockHandle)
       {
-        m_Allocator.FreeBlockChain(send_block->m_StartBlock, StormFixedBlockType::BlockMem);
-        m_MessageSenders.FreeBlock(send_block->m_PacketHandle, StormFixedBlockType::Sender);
+        StormMessageWriterData * packet_info = (StormMessageWriterData *)m_MessageSenders.ResolveHandle(send_block->m_PacketHandle);
+        ReleasePacketData(packet_info, send_block->m_PacketHandle);
       }
     }
 
@@ -2117,20 +3361,36 @@ namespace StormSockets
 
   void StormSocketBackend::ReleaseSendQueue(StormSocketConnectionId connection_id, int connection_gen)
   {
-    StormMessageWriter writer;
-    // Lock the queue so that nothing else can put packets into it
-    m_OutputQueue[connection_id].Lock(connection_gen + 1, m_OutputQueueIncdices.get(), m_OutputQueueArray.get());
+    auto & connection = GetConnection(connection_id);
+    FreeSequencePackets(connection.m_SequenceNext);
+    connection.m_SequenceNext = InvalidBlockHandle;
+
+    for (auto & deferred_packet : connection.m_DeferredPackets)
+    {
+      FreeOutgoingSequence(deferred_packet);
+    }
+
+    connection.m_DeferredPackets.clear();
 
-    // Drain the remaining packets
-    while (m_OutputQueue[connection_id].TryDequeue(writer, connection_gen + 1, m_OutputQueueIncdices.get(), m_OutputQueueArray.get()))
+    StormMessageWriter writer;
+    for (int lane = 0; lane < StormSocketSendPriority::Count; lane++)
     {
-      if (writer.m_PacketInfo != NULL)
+      int queue_index = connection_id * StormSocketSendPriority::Count + lane;
+
+      // Lock the queue so that nothing else can put packets into it
+      m_OutputQueue[queue_index].Lock(connection_gen + 1, m_OutputQueueIncdices.get(), m_OutputQueueArray.get());
+
+      // Drain the remaining packets
+      while (m_OutputQueue[queue_index].TryDequeue(writer, connection_gen + 1, m_OutputQueueIncdices.get(), m_OutputQueueArray.get()))
       {
-        FreeOutgoingPacket(writer);
+        if (writer.m_PacketInfo != NULL)
+        {
+          FreeOutgoingSequence(writer);
+        }
       }
-    }
 
-    m_OutputQueue[connection_id].Reset(connection_gen + 1, m_OutputQueueIncdices.get(), m_OutputQueueArray.get());
+      m_OutputQueue[queue_index].Reset(connection_gen + 1, m_OutputQueueIncdices.get(), m_OutputQueueArray.get());
+    }
   }
 
   StormMessageWriter StormSocketBackend::EncryptWriter(StormSocketConnectionId connection_id, StormMessageWriter & writer)
@@ -2166,6 +3426,14 @@ namespace StormSockets
       block_index++;
     }
 
+    ForEachSliceSegment(m_Allocator, writer.m_PacketInfo, [&](void * data, int length, [[maybe_unused]] bool last)
+    {
+      if (mbedtls_ssl_write(&connection.m_SSLContext.m_SSLContext, (uint8_t *)data, length) < 0)
+      {
+        throw std::runtime_error("Error encrypting packet");
+      }
+    });
+
     StormMessageWriter encrypted = connection.m_EncryptWriter;
     connection.m_EncryptWriter = CreateWriter(true);
 
@@ -22,6 +22,7 @@
 #include "StormSocketServerTypes.h"
 #include "StormSocketIOOperation.h"
 #include "StormSocketFrontend.h"
+#include "StormDnsCache.h"
 
 #ifndef DISABLE_MBED
 #include "mbedtls/ssl.h"
@@ -58,6 +59,7 @@ namespace StormSockets
   
     asio::io_service m_IOService;
     asio::ip::tcp::resolver m_Resolver;
+    StormDnsCache m_DnsCache;
 
     std::unique_ptr<std::optional<asio::ip::tcp::socket>[]> m_ClientSockets;
 
@@ -79,8 +81,26 @@ namespace StormSockets
     StormSemaphore m_IOResetSemaphore;
     std::atomic_int m_IOResetCount;
 
-    static const int kBufferSetCount = 8;
-    typedef std::array<asio::const_buffer, 8> SendBuffer;
+    static const int kBufferSetCount = 32;
+    typedef std::array<asio::const_buffer, kBufferSetCount> SendBuffer;
+
+    std::unique_ptr<std::optional<asio::steady_timer>[]> m_FlushTimers;
+
+    // Outgoing connections race one socket per resolved address, the first to connect becomes the connection's socket
+    struct ConnectAttempt
+    {
+      StormSocketConnectionId m_ConnectionId;
+      uint16_t m_Port = 0;
+      std::vector<StormSocketIPAddress> m_Addrs;
+      std::vector<std::optional<asio::ip::tcp::socket>> m_Sockets;
+      std::optional<asio::steady_timer> m_Timer;
+      std::size_t m_NextAddr = 0;
+      int m_Outstanding = 0;
+      bool m_Done = false;
+      StormMutex m_Lock;
+    };
+
+    int m_ConnectAttemptDelay;
 
 #else
 
@@ -94,6 +114,10 @@ namespace StormSockets
     std::unique_ptr<StormGenIndex[]> m_OutputQueueIncdices;
 
     int m_FixedBlockSize;
+    int m_MaxFileBlocksInFlight;
+    int m_MaxStagedPackets;
+    int m_MaxPendingOutgoingPackets;
+    int m_SendPriorityWeights[StormSocketSendPriority::Count];
     int m_HandshakeTimeout;
     bool m_ThreadStopRequested;
 
@@ -135,8 +159,12 @@ namespace StormSockets
     StormSocketConnectionId RequestConnect(StormSocketFrontend * frontend, const char * ip_addr, int port, const void * init_data);
 
     void RequestStop() { m_ThreadStopRequested = true; }
+#ifndef _INCLUDEOS
+    void ClearDnsCache() { m_DnsCache.Clear(); }
+#endif
 
     int GetFixedBlockSize() { return m_FixedBlockSize; }
+    int GetMaxConnections() { return m_MaxConnections; }
     StormFixedBlockAllocator & GetAllocator() { return m_Allocator; }
     StormFixedBlockAllocator & GetMessageSenders() { return m_MessageSenders; }
     StormFixedBlockAllocator & GetMessageReaders() { return m_MessageReaders; }
@@ -151,12 +179,29 @@ namespace StormSockets
     void FreeOutgoingHttpRequest(StormHttpRequestWriter & writer);
     void FreeOutgoingHttpResponse(StormHttpResponseWriter & writer);
 
-    bool SendPacketToConnection(StormMessageWriter & writer, StormSocketConnectionId id);
-    void SendPacketToConnectionBlocking(StormMessageWriter & writer, StormSocketConnectionId id);
+    bool SendPacketToConnection(StormMessageWriter & writer, StormSocketConnectionId id,
+      StormSocketSendPriority::Index priority = StormSocketSendPriority::Normal);
+    void SendPacketToConnectionBlocking(StormMessageWriter & writer, StormSocketConnectionId id,
+      StormSocketSendPriority::Index priority = StormSocketSendPriority::Normal);
+
+    // The packets are queued as a single entry, so they go in whole or not at all and nothing else on the lane lands between them.
+    // Only control frames on the High lane can be sent in between.  The packets have to come from CreateWriter
+    bool SendPacketSequenceToConnection(StormMessageWriter * writers, int num_writers, StormSocketConnectionId id,
+      StormSocketSendPriority::Index priority = StormSocketSendPriority::Normal);
+    void SendPacketSequenceToConnectionBlocking(StormMessageWriter * writers, int num_writers, StormSocketConnectionId id,
+      StormSocketSendPriority::Index priority = StormSocketSendPriority::Normal);
+    int BroadcastSequence(StormMessageWriter * writers, int num_writers, const StormSocketConnectionId * ids, int num_ids);
+
+    int Broadcast(StormMessageWriter & writer, const StormSocketConnectionId * ids, int num_ids);
     void SendHttpRequestToConnection(StormHttpRequestWriter & writer, StormSocketConnectionId id);
     void SendHttpResponseToConnection(StormHttpResponseWriter & writer, StormSocketConnectionId id);
     void SendHttpToConnection(StormMessageWriter & header_writer, StormMessageWriter & body_writer, StormSocketConnectionId id);
     void FreeOutgoingPacket(StormMessageWriter & writer);
+
+    // Sends length bytes of source after the writer's own data without copying them.  The offset counts from the start of the
+    // source's data, reserved header space excluded
+    void SetPacketSlice(StormMessageWriter & writer, StormMessageWriter & source, int offset, int length);
+
     void FinalizeConnection(StormSocketConnectionId id);
     void ForceDisconnect(StormSocketConnectionId id);
     bool ConnectionIdValid(StormSocketConnectionId id);
@@ -168,19 +213,34 @@ namespace StormSockets
     void ReleasePacketSlot(StormSocketConnectionId id, int amount = 1);
 
     void ReleaseOutgoingPacket(StormMessageWriter & writer);
+    void ReleasePacketData(StormMessageWriterData * packet_info, StormFixedBlockHandle packet_handle);
+    void FreeOutgoingSequence(StormMessageWriter & writer);
     void SetSocketDisconnected(StormSocketConnectionId id);
 
     void SignalCloseThread(StormSocketConnectionId id);
     void SetDisconnectFlag(StormSocketConnectionId id, StormSocketDisconnectFlags::Index flags);
     bool CheckDisconnectFlags(StormSocketConnectionId id, StormSocketDisconnectFlags::Index new_flags);
     void SetHandshakeComplete(StormSocketConnectionId id);
+    void StartKeepalive(StormSocketConnectionId id, int interval_ms);
+
+    // Stops reading from the connection after the data already received is processed, until it gets resumed
+    void PauseReceive(StormSocketConnectionId id);
+    void ResumeReceive(StormSocketConnectionId id);
+
+    bool QueueOutgoingPacket(StormMessageWriter & writer, StormSocketConnectionId id,
+      StormSocketSendPriority::Index priority = StormSocketSendPriority::Normal);
 
-    bool QueueOutgoingPacket(StormMessageWriter & writer, StormSocketConnectionId id);
+    // Control buffers bypass the output queue and get sent ahead of any data that isn't already on the wire
+    void * ReserveControlBuffer(StormSocketConnectionId id, int & buffer_index);
+    void SendControlBuffer(StormSocketConnectionId id, int buffer_index, int length);
     void SignalOutgoingSocket(StormSocketConnectionId id, StormSocketIOOperationType::Index type, std::size_t size = 0);
 
+    // Sends anything the connection is holding back to coalesce with later writes
+    void Flush(StormSocketConnectionId id);
+
   private:
 
-    StormSocketConnectionId AllocateConnection(StormSocketFrontend * frontend, uint32_t remote_ip, uint16_t remote_port, bool for_connect, const void * init_data);
+    StormSocketConnectionId AllocateConnection(StormSocketFrontend * frontend, const StormSocketIPAddress & remote_addr, uint16_t remote_port, bool for_connect, const void * init_data);
     void FreeConnectionSlot(StormSocketConnectionId id);
 
 #ifndef _INCLUDEOS
@@ -189,7 +249,17 @@ namespace StormSockets
 #endif
 
     void BootstrapConnection(StormSocketConnectionId connection_id, StormSocketConnectionBase & connection, void * ssl_config_ptr);
+#ifndef _INCLUDEOS
+    void PrepareToConnect(StormSocketConnectionId id, const std::vector<StormSocketIPAddress> & addrs, uint16_t port);
+    void StartConnectAttempt(std::shared_ptr<ConnectAttempt> attempt);
+    void ConnectAttemptComplete(std::shared_ptr<ConnectAttempt> attempt, std::size_t index, const asio::error_code & ec);
+    void ResolveHost(const std::string & host, StormDnsResolveCallback callback);
+#else
     void PrepareToConnect(StormSocketConnectionId id, uint32_t addr, uint16_t port);
+#endif
+
+    void ArmKeepalive(StormSocketConnectionId id, int interval_ms);
+    void KeepaliveTimerExpired(StormSocketConnectionId id, int interval_ms);
 
     void FinalizeConnectToHost(StormSocketConnectionId id);
     void ConnectFailed(StormSocketConnectionId id);
@@ -198,12 +268,30 @@ namespace StormSockets
     bool ProcessReceivedData(StormSocketConnectionId connection_id, bool recv_failure);
     void PrepareToRecv(StormSocketConnectionId connection_id);
     void TryProcessReceivedData(StormSocketConnectionId connection_id, bool recv_failure);
+    void RepostReceivedData(StormSocketConnectionId connection_id, bool recv_failure);
 
 #ifndef _INCLUDEOS
     void IOThreadMain();
     void SendThreadMain(int thread_index);
+    void ProcessQueuePacketBatch(StormSocketIOOperation & op);
+#endif
+    void ProcessQueuePacket(StormSocketConnectionId connection_id);
+    bool DequeueOutgoingPacket(StormSocketConnectionId connection_id, StormMessageWriter & writer);
+    void BeginOutgoingPacket(StormSocketConnectionBase & connection, StormMessageWriter & writer, int lane);
+    void LinkPacketSequence(StormMessageWriter * writers, int num_writers);
+    void ReferenceSequence(StormMessageWriter & writer, int amount);
+    StormMessageWriter GetSequencePacket(StormFixedBlockHandle packet_handle);
+    void FreeSequencePackets(StormFixedBlockHandle packet_handle);
+    void StagePendingPackets(StormSocketConnectionId connection_id, bool flush);
+    void ProcessQueueFile(StormSocketConnectionId connection_id, StormFixedBlockHandle file_block_handle);
+    void ProcessQueueControl(StormSocketConnectionId connection_id, int buffer_index);
+    StormFixedBlockHandle CreatePendingSendBlocks(StormMessageWriter & writer, StormFixedBlockHandle & last_block_handle);
+    void TransmitConnectionPackets(StormSocketConnectionId connection_id, bool flush = false);
+#ifndef _INCLUDEOS
+    void ArmFlushTimer(StormSocketConnectionId connection_id);
+    bool TransmitFileBlock(StormSocketConnectionId connection_id);
+    bool ExpandFileBlock(StormSocketConnectionId connection_id);
 #endif
-    void TransmitConnectionPackets(StormSocketConnectionId connection_id);
 
     StormFixedBlockHandle ReleasePendingSendBlock(StormFixedBlockHandle send_block_handle, StormPendingSendBlock * send_block);
     void ReleaseSendQueue(StormSocketConnectionId connection_id, int connection_gen);
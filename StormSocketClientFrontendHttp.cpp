@@ -1,8 +1,11 @@
 
 #include "StormSocketClientFrontendHttp.h"
 #include "StormSocketConnectionHttp.h"
+#include "StormHeaderNames.h"
 #include "StormSocketLog.h"
 
+#include <algorithm>
+
 namespace StormSockets
 {
   StormSocketClientFrontendHttp::StormSocketClientFrontendHttp(const StormSocketClientFrontendHttpSettings & settings, StormSocketBackend * backend) :
@@ -10,6 +13,10 @@ namespace StormSockets
     m_ConnectionAllocator(sizeof(StormSocketClientConnectionHttp) * settings.MaxConnections, sizeof(StormSocketClientConnectionHttp), false),
     m_SSLData(std::make_unique<StormSocketClientSSLData[]>(kDefaultSSLConfigs))
   {
+    m_MaxConnectionsPerHost = settings.MaxConnectionsPerHost;
+    m_MaxIdleConnectionsPerHost = settings.MaxIdleConnectionsPerHost;
+    m_PoolIdleTimeout = settings.PoolIdleTimeout;
+
     for (int index = 0; index < kDefaultSSLConfigs; ++index)
     {
       InitClientSSL(m_SSLData[index], backend);
@@ -18,6 +25,20 @@ namespace StormSockets
 
   StormSocketClientFrontendHttp::~StormSocketClientFrontendHttp()
   {
+    {
+      // Dropped first so that closing the connections doesn't open new ones for them
+      StormLockGuard<StormMutex> lock(m_PoolLock);
+      for (auto & pool : m_Pools)
+      {
+        for (auto & request : pool.second.m_Waiting)
+        {
+          m_Backend->FreeOutgoingHttpRequest(request.m_RequestWriter);
+        }
+
+        pool.second.m_Waiting.clear();
+      }
+    }
+
     CleanupAllConnections();
     for (int index = 0; index < kDefaultSSLConfigs; ++index)
     {
@@ -27,7 +48,244 @@ namespace StormSockets
 
   StormSocketConnectionId StormSocketClientFrontendHttp::RequestConnect(const char * ip_addr, int port, const StormSocketClientFrontendHttpRequestData & request_data)
   {
-    return m_Backend->RequestConnect(this, ip_addr, port, &request_data);
+    return DispatchRequest(ip_addr, port, request_data);
+  }
+
+  StormSocketConnectionId StormSocketClientFrontendHttp::DispatchRequest(const char * host, int port, const StormSocketClientFrontendHttpRequestData & request_data)
+  {
+    if (m_MaxConnectionsPerHost <= 0)
+    {
+      return m_Backend->RequestConnect(this, host, port, &request_data);
+    }
+
+    std::string pool_key = std::string(host) + ":" + std::to_string(port) + (request_data.m_UseSSL ? "s" : "");
+    StormSocketConnectionId idle_id = StormSocketConnectionId::InvalidConnectionId;
+
+    {
+      StormLockGuard<StormMutex> lock(m_PoolLock);
+      auto & pool = m_Pools[pool_key];
+
+      while (pool.m_Idle.size() > 0)
+      {
+        auto connection_id = pool.m_Idle.back();
+        pool.m_Idle.pop_back();
+
+        // Skip connections the server already closed, cleanup takes them out of the pool
+        if (IsReusable(connection_id))
+        {
+          auto & http_connection = GetHttpConnection(GetConnection(connection_id).m_FrontendId);
+          http_connection.m_Busy = true;
+          http_connection.m_CompleteResponse = false;
+          http_connection.m_RequestTag = request_data.m_RequestTag;
+
+          idle_id = connection_id;
+          break;
+        }
+      }
+
+      if (idle_id == StormSocketConnectionId::InvalidConnectionId && (int)pool.m_Connections.size() + pool.m_Connecting >= m_MaxConnectionsPerHost)
+      {
+        // Whichever connection finishes first picks this up, so no single slow response holds it back
+        StormHttpRequestWriter writer = request_data.m_RequestWriter;
+        m_Backend->ReferenceOutgoingHttpRequest(writer);
+        pool.m_Waiting.push_back({ writer, request_data.m_RequestTag });
+        return StormSocketConnectionId::InvalidConnectionId;
+      }
+
+      if (idle_id == StormSocketConnectionId::InvalidConnectionId)
+      {
+        // InitConnection moves this over to the connection list
+        pool.m_Connecting++;
+        pool.m_Host = host;
+        pool.m_Port = port;
+        pool.m_UseSSL = request_data.m_UseSSL;
+      }
+    }
+
+    if (idle_id != StormSocketConnectionId::InvalidConnectionId)
+    {
+      StormHttpRequestWriter writer = request_data.m_RequestWriter;
+      m_Backend->SendHttpRequestToConnection(writer, idle_id);
+      return idle_id;
+    }
+
+    StormSocketClientFrontendHttpRequestData pooled_request_data = request_data;
+    pooled_request_data.m_PoolKey = pool_key.c_str();
+
+    auto connection_id = m_Backend->RequestConnect(this, host, port, &pooled_request_data);
+    if (connection_id == StormSocketConnectionId::InvalidConnectionId)
+    {
+      StormLockGuard<StormMutex> lock(m_PoolLock);
+      m_Pools[pool_key].m_Connecting--;
+    }
+
+    return connection_id;
+  }
+
+  void StormSocketClientFrontendHttp::ConnectWaiting(std::string pool_key)
+  {
+    std::optional<StormSocketClientHttpWaitingRequest> waiting_request;
+    std::string host;
+    int port;
+    bool use_ssl;
+
+    {
+      StormLockGuard<StormMutex> lock(m_PoolLock);
+      auto itr = m_Pools.find(pool_key);
+      if (itr == m_Pools.end())
+      {
+        return;
+      }
+
+      auto & pool = itr->second;
+      if (pool.m_Waiting.size() == 0 || (int)pool.m_Connections.size() + pool.m_Connecting >= m_MaxConnectionsPerHost)
+      {
+        return;
+      }
+
+      waiting_request = pool.m_Waiting.front();
+      pool.m_Waiting.pop_front();
+      pool.m_Connecting++;
+
+      host = pool.m_Host;
+      port = pool.m_Port;
+      use_ssl = pool.m_UseSSL;
+    }
+
+    StormSocketClientFrontendHttpRequestData request_data{ waiting_request->m_RequestWriter, use_ssl };
+    request_data.m_PoolKey = pool_key.c_str();
+    request_data.m_RequestTag = waiting_request->m_RequestTag;
+
+    auto connection_id = m_Backend->RequestConnect(this, host.c_str(), port, &request_data);
+    if (connection_id != StormSocketConnectionId::InvalidConnectionId)
+    {
+      // The connection took its own reference
+      m_Backend->FreeOutgoingHttpRequest(waiting_request->m_RequestWriter);
+      return;
+    }
+
+    StormLockGuard<StormMutex> lock(m_PoolLock);
+    auto & pool = m_Pools[pool_key];
+    pool.m_Connecting--;
+
+    if (pool.m_Connections.size() > 0 || pool.m_Connecting > 0)
+    {
+      // Still has a place in line for the connections that are left
+      pool.m_Waiting.push_front(*waiting_request);
+      return;
+    }
+
+    StormSocketLog("Could not connect for %d waiting requests\n", (int)pool.m_Waiting.size() + 1);
+    m_Backend->FreeOutgoingHttpRequest(waiting_request->m_RequestWriter);
+    for (auto & request : pool.m_Waiting)
+    {
+      m_Backend->FreeOutgoingHttpRequest(request.m_RequestWriter);
+    }
+
+    m_Pools.erase(pool_key);
+  }
+
+  bool StormSocketClientFrontendHttp::IsReusable(StormSocketConnectionId connection_id)
+  {
+    if (m_Backend->ConnectionIdValid(connection_id) == false)
+    {
+      return false;
+    }
+
+    auto & connection = GetConnection(connection_id);
+    return (connection.m_DisconnectFlags & (StormSocketDisconnectFlags::kTerminateFlags | StormSocketDisconnectFlags::kSignalClose)) == 0 &&
+      connection.m_FailedConnection == false;
+  }
+
+  void StormSocketClientFrontendHttp::ReleaseToPool(StormSocketConnectionId connection_id, StormSocketClientConnectionHttp & http_connection)
+  {
+    std::optional<StormSocketClientHttpWaitingRequest> next_request;
+    bool close = false;
+
+    {
+      StormLockGuard<StormMutex> lock(m_PoolLock);
+      auto & pool = m_Pools[http_connection.m_PoolKey];
+
+      if (http_connection.m_KeepAlive == false)
+      {
+        // Waiting requests stay with the host, and a new connection is opened for them below
+        RemoveFromPool(connection_id, http_connection);
+        close = true;
+      }
+      else if (pool.m_Waiting.size() > 0)
+      {
+        next_request = pool.m_Waiting.front();
+        pool.m_Waiting.pop_front();
+        http_connection.m_CompleteResponse = false;
+        http_connection.m_RequestTag = next_request->m_RequestTag;
+      }
+      else
+      {
+        http_connection.m_Busy = false;
+        http_connection.m_IdleSince = GetTimeMs();
+
+        if ((int)pool.m_Idle.size() >= m_MaxIdleConnectionsPerHost)
+        {
+          RemoveFromPool(connection_id, http_connection);
+          close = true;
+        }
+        else
+        {
+          pool.m_Idle.push_back(connection_id);
+        }
+      }
+    }
+
+    if (close)
+    {
+      ForceDisconnect(connection_id);
+      ConnectWaiting(http_connection.m_PoolKey);
+    }
+
+    if (next_request)
+    {
+      m_Backend->SendHttpRequestToConnection(next_request->m_RequestWriter, connection_id);
+      m_Backend->FreeOutgoingHttpRequest(next_request->m_RequestWriter);
+    }
+  }
+
+  void StormSocketClientFrontendHttp::RemoveFromPool(StormSocketConnectionId connection_id, StormSocketClientConnectionHttp & http_connection)
+  {
+    auto itr = m_Pools.find(http_connection.m_PoolKey);
+    if (itr == m_Pools.end())
+    {
+      return;
+    }
+
+    auto & pool = itr->second;
+    auto matches = [&](const StormSocketConnectionId & id) { return id.m_Index.Raw == connection_id.m_Index.Raw; };
+
+    pool.m_Connections.erase(std::remove_if(pool.m_Connections.begin(), pool.m_Connections.end(), matches), pool.m_Connections.end());
+    pool.m_Idle.erase(std::remove_if(pool.m_Idle.begin(), pool.m_Idle.end(), matches), pool.m_Idle.end());
+
+    if (pool.m_Connections.size() == 0 && pool.m_Connecting == 0 && pool.m_Waiting.size() == 0)
+    {
+      m_Pools.erase(itr);
+    }
+  }
+
+  bool StormSocketClientFrontendHttp::KeepaliveTick(StormSocketConnectionId connection_id, StormSocketFrontendConnectionId frontend_id)
+  {
+    auto & http_connection = GetHttpConnection(frontend_id);
+
+    {
+      StormLockGuard<StormMutex> lock(m_PoolLock);
+      int64_t now = GetTimeMs();
+      if (http_connection.m_Busy || now - http_connection.m_IdleSince < m_PoolIdleTimeout)
+      {
+        return true;
+      }
+
+      RemoveFromPool(connection_id, http_connection);
+    }
+
+    ForceDisconnect(connection_id);
+    return false;
   }
 
   StormSocketConnectionId StormSocketClientFrontendHttp::RequestConnect(const StormURI & uri, const void * body, int body_len, const void * headers, int header_len)
@@ -52,7 +310,7 @@ namespace StormSockets
       }
     }
 
-    auto connection_id = m_Backend->RequestConnect(this, uri.m_Host.c_str(), port, &request_data);
+    auto connection_id = DispatchRequest(uri.m_Host.c_str(), port, request_data);
     m_Backend->FreeOutgoingHttpRequest(request_data.m_RequestWriter);
 
     return connection_id;
@@ -79,7 +337,7 @@ namespace StormSockets
       }
     }
 
-    auto connection_id = m_Backend->RequestConnect(this, uri.m_Host.c_str(), port, &request_data);
+    auto connection_id = DispatchRequest(uri.m_Host.c_str(), port, request_data);
     m_Backend->FreeOutgoingHttpRequest(request_data.m_RequestWriter);
 
     return connection_id;
@@ -158,8 +416,20 @@ namespace StormSockets
     auto & http_connection = GetHttpConnection(frontend_id);
     http_connection.m_RequestWriter = request_data->m_RequestWriter;
     http_connection.m_UseSSL = request_data->m_UseSSL;
+    http_connection.m_RequestTag = request_data->m_RequestTag;
 
     m_Backend->ReferenceOutgoingHttpRequest(*http_connection.m_RequestWriter);
+
+    if (request_data->m_PoolKey)
+    {
+      http_connection.m_Pooled = true;
+      http_connection.m_PoolKey = request_data->m_PoolKey;
+
+      StormLockGuard<StormMutex> lock(m_PoolLock);
+      auto & pool = m_Pools[http_connection.m_PoolKey];
+      pool.m_Connecting--;
+      pool.m_Connections.push_back(connection_id);
+    }
   }
 
   void StormSocketClientFrontendHttp::CleanupConnection([[maybe_unused]] StormSocketConnectionId connection_id, StormSocketFrontendConnectionId frontend_id)
@@ -171,6 +441,17 @@ namespace StormSockets
       m_Backend->FreeOutgoingHttpRequest(*http_connection.m_RequestWriter);
       http_connection.m_RequestWriter = {};
     }
+
+    if (http_connection.m_Pooled)
+    {
+      {
+        StormLockGuard<StormMutex> lock(m_PoolLock);
+        RemoveFromPool(connection_id, http_connection);
+      }
+
+      // A replacement picks up anything that was waiting on this connection to free up
+      ConnectWaiting(http_connection.m_PoolKey);
+    }
   }
 
   void StormSocketClientFrontendHttp::QueueDisconnectEvent(StormSocketConnectionId connection_id, StormSocketFrontendConnectionId frontend_id)
@@ -228,7 +509,8 @@ namespace StormSockets
 
         int full_data_len = 0;
         bool got_header = false;
-        StormMessageReaderCursor cur_header = header_reader.AdvanceToNextHeader(full_data_len, got_header);
+        int name_length = -1;
+        StormMessageReaderCursor cur_header = header_reader.AdvanceToNextHeader(full_data_len, got_header, name_length);
 
         ProfileScope prof(ProfilerCategory::kProcHeaders);
         while (got_header)
@@ -255,22 +537,34 @@ namespace StormSockets
           }
           else
           {
-            int header_val;
-            int header_val_lowercase;
-
-            m_HeaderValues.ReadInitialVal(cur_header, header_val, header_val_lowercase);
-            if (m_HeaderValues.MatchExact(cur_header, header_val_lowercase, StormHttpHeaderType::ChunkedEncoding))
-            {
-              http_connection.m_Chunked = true;
-            }
-            else if (m_HeaderValues.Match(cur_header, header_val_lowercase, StormHttpHeaderType::ContentLength))
+            switch (StormClassifyHeaderName(cur_header, name_length))
             {
+            case StormHeaderName::TransferEncoding:
+              if (m_HeaderValues.FindCSLValue(cur_header, StormHttpHeaderType::Chunked))
+              {
+                http_connection.m_Chunked = true;
+              }
+              break;
+            case StormHeaderName::ContentLength:
               if (cur_header.ReadNumber(http_connection.m_BodyLength) == false)
               {
                 StormSocketLog("Got invalid content length\n");
                 ForceDisconnect(connection_id);
                 return true;
               }
+              break;
+            case StormHeaderName::Connection:
+              if (m_HeaderValues.FindCSLValue(cur_header, StormHttpHeaderType::ConnectionClose))
+              {
+                http_connection.m_KeepAlive = false;
+              }
+              else if (m_HeaderValues.FindCSLValue(cur_header, StormHttpHeaderType::ConnectionKeepAlive))
+              {
+                http_connection.m_KeepAlive = true;
+              }
+              break;
+            default:
+              break;
             }
           }
 
@@ -279,39 +573,44 @@ namespace StormSockets
           if (got_terminator)
           {
             m_Backend->SetHandshakeComplete(connection_id);
+            if (http_connection.m_Pooled && m_PoolIdleTimeout > 0 && http_connection.m_IdleTimerStarted == false)
+            {
+              // Takes over from the handshake timeout
+              m_Backend->StartKeepalive(connection_id, std::max(m_PoolIdleTimeout / 2, 1));
+              http_connection.m_IdleTimerStarted = true;
+            }
+
+            bool no_body = (http_connection.m_ResponseCode >= 100 && http_connection.m_ResponseCode <= 199) || 
+              http_connection.m_ResponseCode == 204 || http_connection.m_ResponseCode == 304;
+
             if (http_connection.m_Chunked)
             {
               http_connection.m_State = StormSocketClientConnectionHttpState::ReadingChunkSize;
             }
+            else if (http_connection.m_BodyLength == 0 || (http_connection.m_BodyLength < 0 && no_body))
+            {
+              http_connection.m_State = StormSocketClientConnectionHttpState::Complete;
+            }
+            else if (http_connection.m_BodyLength > 0 && BodyLengthAllowed(http_connection, http_connection.m_BodyLength) == false)
+            {
+              StormSocketLog("Response body too large\n");
+              ForceDisconnect(connection_id);
+              return true;
+            }
             else
             {
-              if (http_connection.m_BodyLength == 0)
-              {
-                if (CompleteBody(connection_id, http_connection) == false)
-                {
-                  return false;
-                }
-              }
-              else 
+              if (http_connection.m_BodyLength < 0)
               {
-                if (http_connection.m_BodyLength < 0)
-                {
-                  if ((http_connection.m_ResponseCode >= 100 && http_connection.m_ResponseCode <= 199) || http_connection.m_ResponseCode == 204 || http_connection.m_ResponseCode == 304)
-                  {
-                    if (CompleteBody(connection_id, http_connection) == false)
-                    {
-                      return false;
-                    }
-                  }
-                }
-
-                http_connection.m_State = StormSocketClientConnectionHttpState::ReadingBody;
+                // The body runs until the server closes the connection
+                http_connection.m_KeepAlive = false;
               }
+
+              http_connection.m_State = StormSocketClientConnectionHttpState::ReadingBody;
             }
             break;
           }
 
-          cur_header = header_reader.AdvanceToNextHeader(full_data_len, got_header);
+          cur_header = header_reader.AdvanceToNextHeader(full_data_len, got_header, name_length);
         }
 
         if (http_connection.m_State == StormSocketClientConnectionHttpState::ReadingHeaders)
@@ -320,7 +619,16 @@ namespace StormSockets
         }
       }
 
-      return ProcessHttpData(connection, http_connection, connection_id);
+      if (ProcessHttpData(connection, http_connection, connection_id) == false)
+      {
+        return false;
+      }
+
+      // A pooled connection can already have the next response waiting
+      if (http_connection.m_State != StormSocketClientConnectionHttpState::ReadingHeaders)
+      {
+        return true;
+      }
     }
   }
 
@@ -331,12 +639,17 @@ namespace StormSockets
 
     m_HeaderValues.ReadInitialVal(status_line, header_val, header_val_lowercase);
 
-    if (m_HeaderValues.Match(status_line, header_val, StormHttpHeaderType::HttpVer) == false)
+    if (m_HeaderValues.Match(status_line, header_val, StormHttpHeaderType::HttpVer))
     {
-      if (m_HeaderValues.Match(status_line, header_val, StormHttpHeaderType::HttpVer1) == false)
-      {
-        return false;
-      }
+      http_connection.m_KeepAlive = true;
+    }
+    else if (m_HeaderValues.Match(status_line, header_val, StormHttpHeaderType::HttpVer1))
+    {
+      http_connection.m_KeepAlive = false;
+    }
+    else
+    {
+      return false;
     }
 
     if (status_line.ReadByte() != ' ')
@@ -401,11 +714,14 @@ namespace StormSockets
           http_connection.m_ResponseCode);
     }
 
+    http_connection.m_BodyReader->m_RequestTag = http_connection.m_RequestTag;
+
     StormSocketEventInfo data_message;
     data_message.ConnectionId = connection_id;
     data_message.GetHttpResponseReader() = *http_connection.m_BodyReader;
     data_message.Type = StormSocketEventType::Data;
     data_message.RemoteIP = connection.m_RemoteIP;
+    data_message.RemoteAddress = connection.m_RemoteAddress;
     data_message.RemotePort = connection.m_RemotePort;
 
     if (m_EventQueue.Enqueue(data_message) == false)
@@ -419,10 +735,39 @@ namespace StormSockets
     }
 
     http_connection.m_CompleteResponse = true;
-    ForceDisconnect(connection_id);
+
+    if (http_connection.m_Pooled == false)
+    {
+      ForceDisconnect(connection_id);
+      return true;
+    }
+
+    bool keep_alive = http_connection.m_KeepAlive;
+    ResetResponse(http_connection);
+    http_connection.m_KeepAlive = keep_alive;
+
+    ReleaseToPool(connection_id, http_connection);
     return true;
   }
 
+  void StormSocketClientFrontendHttp::ResetResponse(StormSocketClientConnectionHttp & http_connection)
+  {
+    http_connection.m_State = StormSocketClientConnectionHttpState::ReadingHeaders;
+    http_connection.m_Chunked = false;
+    http_connection.m_BodyReceived = 0;
+    http_connection.m_TotalLength = 0;
+    http_connection.m_BodyLength = -1;
+    http_connection.m_ChunkSize = 0;
+    http_connection.m_RecievedLength = 0;
+    http_connection.m_Headers.reset();
+
+    http_connection.m_GotStatusLine = false;
+    http_connection.m_ResponseCode = 0;
+    http_connection.m_StatusLine.reset();
+    http_connection.m_ResponsePhrase.reset();
+    http_connection.m_BodyReader.reset();
+  }
+
 
   void StormSocketClientFrontendHttp::SendClosePacket([[maybe_unused]] StormSocketConnectionId connection_id, 
     [[maybe_unused]] StormSocketFrontendConnectionId frontend_id)
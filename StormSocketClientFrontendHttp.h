@@ -7,9 +7,34 @@
 #include "StormSocketRequest.h"
 #include "StormUrlUtil.h"
 #include "StormSha1.h"
+#include "StormMutex.h"
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
 
 namespace StormSockets
 {
+  struct StormSocketClientHttpWaitingRequest
+  {
+    StormHttpRequestWriter m_RequestWriter;
+    uint64_t m_RequestTag;
+  };
+
+  struct StormSocketClientHttpPool
+  {
+    std::vector<StormSocketConnectionId> m_Connections;
+    std::vector<StormSocketConnectionId> m_Idle;
+    int m_Connecting = 0;
+
+    // Requests that found every connection busy, sent by whichever connection frees up first
+    std::deque<StormSocketClientHttpWaitingRequest> m_Waiting;
+    std::string m_Host;
+    int m_Port = 0;
+    bool m_UseSSL = false;
+  };
+
   class StormSocketClientFrontendHttp : public StormSocketFrontendHttpBase
   {
   protected:
@@ -17,6 +42,13 @@ namespace StormSockets
     std::unique_ptr<StormSocketClientSSLData[]> m_SSLData;
 
     StormHttpHeaderValues m_HeaderValues;
+
+    int m_MaxConnectionsPerHost;
+    int m_MaxIdleConnectionsPerHost;
+    int m_PoolIdleTimeout;
+
+    StormMutex m_PoolLock;
+    std::map<std::string, StormSocketClientHttpPool> m_Pools;
   public:
 
     StormSocketClientFrontendHttp(const StormSocketClientFrontendHttpSettings & settings, StormSocketBackend * backend);
@@ -49,6 +81,14 @@ namespace StormSockets
 
     bool ProcessData(StormSocketConnectionId connection_id, StormSocketFrontendConnectionId frontend_id) override;
     bool ParseStatusLine(StormMessageReaderCursor & status_line, StormSocketClientConnectionHttp & http_connection);
+    void ResetResponse(StormSocketClientConnectionHttp & http_connection);
+
+    StormSocketConnectionId DispatchRequest(const char * host, int port, const StormSocketClientFrontendHttpRequestData & request_data);
+    bool IsReusable(StormSocketConnectionId connection_id);
+    void ReleaseToPool(StormSocketConnectionId connection_id, StormSocketClientConnectionHttp & http_connection);
+    void RemoveFromPool(StormSocketConnectionId connection_id, StormSocketClientConnectionHttp & http_connection);
+    void ConnectWaiting(std::string pool_key);
+    bool KeepaliveTick(StormSocketConnectionId connection_id, StormSocketFrontendConnectionId frontend_id) override;
 
     void ConnectionEstablishComplete(StormSocketConnectionId connection_id, StormSocketFrontendConnectionId frontend_id) override;
 
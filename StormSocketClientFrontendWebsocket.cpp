@@ -1,5 +1,6 @@
 
 #include "StormSocketClientFrontendWebsocket.h"
+#include "StormHeaderNames.h"
 
 #include <random>
 #include <chrono>
@@ -100,12 +101,12 @@ namespace StormSockets
     [[maybe_unused]] StormSocketFrontendConnectionId frontend_id)
   {
     auto & ws_connection = GetWSConnection(frontend_id);
-    StormSocketFrontendWebsocketBase::CleanupWebsocketConnection(ws_connection);
+    StormSocketFrontendWebsocketBase::CleanupWebsocketConnection(connection_id, ws_connection);
 
     if (ws_connection.m_State == StormSocketServerConnectionWebsocketState::SendHandshakeResponse ||
       ws_connection.m_State == StormSocketServerConnectionWebsocketState::SendPong)
     {
-      FreeOutgoingPacket(ws_connection.m_PendingWriter);
+      m_Backend->FreeOutgoingPacket(ws_connection.m_PendingWriter);
     }
   }
 
@@ -136,7 +137,8 @@ namespace StormSockets
 
         int full_data_len = 0;
         bool got_header = false;
-        StormMessageReaderCursor cur_header = header_reader.AdvanceToNextHeader(full_data_len, got_header);
+        int name_length = -1;
+        StormMessageReaderCursor cur_header = header_reader.AdvanceToNextHeader(full_data_len, got_header, name_length);
 
         if (!got_header)
         {
@@ -150,7 +152,7 @@ namespace StormSockets
           {
             ws_connection.m_GotHeaderTerminator = true;
           }
-          else
+          else if (name_length < 0)
           {
             int header_val;
             int header_val_lowercase;
@@ -162,72 +164,74 @@ namespace StormSockets
             {
               ws_connection.m_GotStatusLineHeader = true;
             }
-            else if (ws_connection.m_GotWebsocketHeader == false &&
-              m_HeaderValues.MatchExact(cur_header, header_val_lowercase, StormWebsocketHeaderType::WebsocketHeader))
-            {
-              ws_connection.m_GotWebsocketHeader = true;
-            }
-            else if (ws_connection.m_GotConnectionUpgradeHeader == false &&
-              m_HeaderValues.Match(cur_header, header_val_lowercase, StormWebsocketHeaderType::ConnectionUpdgradeHeader))
+          }
+          else
+          {
+            switch (StormClassifyHeaderName(cur_header, name_length))
             {
+            case StormHeaderName::Upgrade:
+              if (m_HeaderValues.FindCSLValue(cur_header, StormWebsocketHeaderType::UpgradeWebsocket))
+              {
+                ws_connection.m_GotWebsocketHeader = true;
+              }
+              break;
+            case StormHeaderName::Connection:
               if (m_HeaderValues.FindCSLValue(cur_header, StormWebsocketHeaderType::UpdgradePart))
               {
                 ws_connection.m_GotConnectionUpgradeHeader = true;
               }
-            }
-            else if (ws_connection.m_Protocol.size() > 0 && ws_connection.m_GotWebsocketProtoHeader == false &&
-              m_HeaderValues.Match(cur_header, header_val_lowercase, StormWebsocketHeaderType::WebsocketProtoResponseHeader))
-            {
-              uint32_t hash = cur_header.HashRemainingData(false);
+              break;
+            case StormHeaderName::SecWebsocketProtocol:
+              if (ws_connection.m_Protocol.size() > 0 && ws_connection.m_GotWebsocketProtoHeader == false)
+              {
+                uint32_t hash = cur_header.HashRemainingData(false);
 
-              auto str_itr = ws_connection.m_Protocol.begin();
+                auto str_itr = ws_connection.m_Protocol.begin();
 
-              bool found_hash = false;
+                bool found_hash = false;
 
-              while(true)
-              {
-                // Skip initial whitespace
-                while (*str_itr == ' ')
+                while(true)
                 {
-                  ++str_itr;
-                  if (str_itr == ws_connection.m_Protocol.end())
+                  // Skip initial whitespace
+                  while (*str_itr == ' ')
                   {
-                    break;
+                    ++str_itr;
+                    if (str_itr == ws_connection.m_Protocol.end())
+                    {
+                      break;
+                    }
                   }
-                }
 
-                uint32_t test_hash = crc32begin();
-                while (str_itr != ws_connection.m_Protocol.end())
-                {
-                  char c = *str_itr;
-                  ++str_itr;
+                  uint32_t test_hash = crc32begin();
+                  while (str_itr != ws_connection.m_Protocol.end())
+                  {
+                    char c = *str_itr;
+                    ++str_itr;
 
-                  if (c == ',')
+                    if (c == ',')
+                    {
+                      break;
+                    }
+
+                    test_hash = crc32additive(test_hash, tolower(c));
+                  }
+
+                  test_hash = crc32end(test_hash);
+                  if (hash == test_hash)
                   {
+                    found_hash = true;
                     break;
                   }
-
-                  test_hash = crc32additive(test_hash, tolower(c));
                 }
 
-                test_hash = crc32end(test_hash);
-                if (hash == test_hash)
+                if (found_hash)
                 {
-                  found_hash = true;
-                  break;
+                  ws_connection.m_GotWebsocketProtoHeader = true;
                 }
               }
-
-              if (found_hash)
-              {
-                ws_connection.m_GotWebsocketProtoHeader = true;
-              }
-            }
-            else if (ws_connection.m_GotWebsocketKeyHeader == false &&
-              m_HeaderValues.Match(cur_header, header_val_lowercase, StormWebsocketHeaderType::WebsocketAcceptHeader))
-            {
-              cur_header.SkipWhiteSpace();
-              if (cur_header.GetRemainingLength() >= 28)
+              break;
+            case StormHeaderName::SecWebsocketAccept:
+              if (ws_connection.m_GotWebsocketKeyHeader == false && cur_header.GetRemainingLength() >= 28)
               {
                 bool matched = true;
                 for (int index = 0; index < 28; index++)
@@ -244,6 +248,12 @@ namespace StormSockets
                   ws_connection.m_GotWebsocketKeyHeader = true;
                 }
               }
+              break;
+            case StormHeaderName::SecWebsocketExtensions:
+              StormWebsocketDeflateReadHeader(cur_header, ws_connection.m_ExtensionHeader);
+              break;
+            default:
+              break;
             }
           }
 
@@ -253,14 +263,35 @@ namespace StormSockets
           if (ws_connection.m_GotHeaderTerminator)
           {
             m_Backend->SetHandshakeComplete(connection_id);
+            StartKeepalive(connection_id);
+
+            // The server can only accept an extension we offered, and we drop the reserved context if it declined
+            bool extensions_valid = true;
+            if (ws_connection.m_ExtensionHeader.size() > 0)
+            {
+              StormWebsocketDeflateParams deflate_params;
+              extensions_valid = ws_connection.m_OfferedDeflate &&
+                StormWebsocketDeflateParseResponse(ws_connection.m_ExtensionHeader, m_DeflateSettings, deflate_params) &&
+                ReconfigureDeflateContext(ws_connection, deflate_params);
+            }
+            else
+            {
+              ReleaseDeflateContext(connection_id, ws_connection);
+            }
 
             // Check to see if the connection is a valid websocket request
             if (ws_connection.m_GotStatusLineHeader &&
               ws_connection.m_GotWebsocketHeader &&
               ws_connection.m_GotConnectionUpgradeHeader &&
               ws_connection.m_GotWebsocketKeyHeader &&
-              (ws_connection.m_Protocol.size() == 0 || ws_connection.m_GotWebsocketProtoHeader))
+              (ws_connection.m_Protocol.size() == 0 || ws_connection.m_GotWebsocketProtoHeader) &&
+              extensions_valid)
             {
+              if (ws_connection.m_DeflateContext != nullptr)
+              {
+                EnableDeflateContext(connection_id, ws_connection);
+              }
+
               ws_connection.m_State = StormSocketServerConnectionWebsocketState::ReadHeaderAndApplyMask;
               QueueHandshakeCompleteEvent(connection_id, frontend_id);
             }
@@ -272,7 +303,7 @@ namespace StormSockets
             break;
           }
 
-          cur_header = header_reader.AdvanceToNextHeader(full_data_len, got_header);
+          cur_header = header_reader.AdvanceToNextHeader(full_data_len, got_header, name_length);
         }
 
         if (ws_connection.m_State == StormSocketServerConnectionWebsocketState::HandShake)
@@ -355,15 +386,32 @@ namespace StormSockets
       writer.WriteByteBlock(ws_connection.m_Protocol.c_str(), 0, ws_connection.m_Protocol.size());
     }
 
+    // Reserve a compression context up front so an accepted offer can't fail for lack of one
+    if (m_UsePerMessageDeflate && AllocateDeflateContext(ws_connection, m_DeflateSettings))
+    {
+      std::string offer = StormWebsocketDeflateCreateOffer(m_DeflateSettings);
+      writer.WriteByteBlock("\r\nSec-WebSocket-Extensions: ", 0, 28);
+      writer.WriteByteBlock(offer.c_str(), 0, offer.size());
+      ws_connection.m_OfferedDeflate = true;
+    }
+
     writer.WriteByteBlock("\r\n\r\n", 0, 4);
 
     SendPacketToConnectionBlocking(writer, connection_id);
   }
 
-  void StormSocketClientFrontendWebsocket::SendClosePacket(StormSocketConnectionId connection_id, [[maybe_unused]] StormSocketFrontendConnectionId frontend_id)
+  void StormSocketClientFrontendWebsocket::SendClosePacket(StormSocketConnectionId connection_id, StormSocketFrontendConnectionId frontend_id)
   {
     // Send a disconnect packet
     StormWebsocketMessageWriter disconnect_writer = CreateOutgoingPacket(StormWebsocketOp::Close, true);
+
+    auto & ws_connection = GetWSConnection(frontend_id);
+    if (ws_connection.m_CloseCode != 0)
+    {
+      disconnect_writer.WriteByte((uint8_t)(ws_connection.m_CloseCode >> 8));
+      disconnect_writer.WriteByte((uint8_t)ws_connection.m_CloseCode);
+    }
+
     disconnect_writer.CreateHeaderAndApplyMask((int)StormWebsocketOp::Close, true, 0);
     SendPacketToConnection(disconnect_writer, connection_id);
     FreeOutgoingPacket(disconnect_writer);
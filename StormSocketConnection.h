@@ -4,6 +4,9 @@
 #include "StormSocketBuffer.h"
 #include "StormMessageWriter.h"
 #include "StormWebsocketMessageReader.h"
+#include "StormSocketServerTypes.h"
+
+#include <deque>
 
 #ifndef DISABLE_MBED
 #include <mbedtls/ssl.h>
@@ -47,6 +50,10 @@ namespace StormSockets
 
   using StormSocketFrontendConnectionId = StormFixedBlockHandle;
 
+  // Enough for a websocket control frame header plus the largest allowed control payload
+  static const int kControlBufferSize = 136;
+  static const int kControlBufferCount = 2;
+
   class StormSocketFrontend;
 
   struct StormSocketConnectionBase
@@ -54,6 +61,7 @@ namespace StormSockets
     std::atomic_bool m_Used = false;
     unsigned int m_RemoteIP = 0;
     unsigned short m_RemotePort = 0;
+    StormSocketIPAddress m_RemoteAddress;
     StormSocketFrontend * m_Frontend = nullptr;
     StormSocketFrontendConnectionId m_FrontendId = InvalidBlockHandle;
 
@@ -69,10 +77,41 @@ namespace StormSockets
     int m_SlotIndex = 0;
     std::atomic_int m_RecvCriticalSection;
 
+    // The frontend can ask for reads to stop being armed until it catches up. Once the last read is processed the
+    // connection is parked, and resuming it has to start the next read
+    StormMutex m_RecvPauseLock;
+    bool m_RecvPauseRequested;
+    bool m_RecvParked;
+    bool m_RecvResumed;
+
     StormFixedBlockHandle m_PendingSendBlockStart;
     StormFixedBlockHandle m_PendingSendBlockCur;
+    StormFixedBlockHandle m_PendingSendBlockInFlight;
     std::atomic_bool m_Transmitting;
 
+    // Packets taken from the priority lanes that haven't gone out yet, and what each lane has left of its weight this round.
+    // m_LockedLane is the only lane that can be taken from while a multi packet message is partially staged, or -1
+    int m_StagedPackets;
+    int m_LaneCredits[StormSocketSendPriority::Count];
+    int m_LockedLane;
+
+    // The rest of a packet sequence that's partly staged, it holds the locked lane until it's done
+    StormFixedBlockHandle m_SequenceNext;
+
+    // Data packets taken from the High lane while looking for control frames, sent in order once the locked lane is released
+    std::deque<StormMessageWriter> m_DeferredPackets;
+
+    // Send thread only: how long small writes can be held for in microseconds, and the flush timer's state
+    int m_CoalesceWindow;
+    int m_CoalesceBytes;
+    bool m_FlushTimerArmed;
+    bool m_FlushDue;
+
+    // Control frames are written here instead of into a writer, a buffer is in use while its ref count is non zero
+    uint8_t m_ControlBuffers[kControlBufferCount][kControlBufferSize];
+    int m_ControlBufferLength[kControlBufferCount];
+    std::atomic_int m_ControlBufferRefs[kControlBufferCount];
+
     SSLContext m_SSLContext = {};
 
 #ifndef DISABLE_MBED
@@ -4,6 +4,13 @@
 #include "StormHttpResponseReader.h"
 #include "StormMessageReaderCursor.h"
 #include "StormMessageHeaderReader.h"
+#include "StormHttpRequestReader.h"
+#include "StormHttpResponseWriter.h"
+#include "StormMutex.h"
+
+#include <atomic>
+#include <deque>
+#include <string>
 
 namespace StormSockets
 {
@@ -14,7 +21,8 @@ namespace StormSockets
       ReadingHeaders,
       ReadingChunkSize,
       ReadingChunk,
-      ReadingBody
+      ReadingBody,
+      Complete,
     };
   }
 
@@ -22,10 +30,12 @@ namespace StormSockets
   {
     StormSocketClientConnectionHttpState::Index m_State = StormSocketClientConnectionHttpState::ReadingHeaders;
     bool m_Chunked = false;
+    bool m_StreamBody = false;
     int m_TotalLength = 0;
-    int m_BodyLength = -1;
-    int m_ChunkSize = 0;
-    int m_RecievedLength = 0;
+    int64_t m_BodyLength = -1;
+    int64_t m_ChunkSize = 0;
+    int64_t m_RecievedLength = 0;
+    int64_t m_BodyReceived = 0;
 
     std::optional<StormMessageHeaderReader> m_Headers;
   };
@@ -44,15 +54,55 @@ namespace StormSockets
     std::optional<StormMessageReaderCursor> m_StatusLine;
     std::optional<StormMessageReaderCursor> m_ResponsePhrase;
     std::optional<StormHttpResponseReader> m_BodyReader;
+
+    // Set by the IO thread while parsing, read under the pool lock when picking a connection to queue behind
+    std::atomic_bool m_KeepAlive = { true };
+
+    // Pooled connections go back to their host's pool after each response.  The rest is guarded by the frontend's pool lock
+    bool m_Pooled = false;
+    bool m_IdleTimerStarted = false;
+    bool m_Busy = true;
+    int64_t m_IdleSince = 0;
+    std::string m_PoolKey;
+    uint64_t m_RequestTag = 0;
   };
 
+  static const int kMaxPipelinedRequests = 16;
+
   struct StormSocketServerConnectionHttp : public StormHttpConnectionBase
   {
     bool m_GotRequestLine = false;
     bool m_CompleteRequest = false;
+    bool m_KeepAlive = true;
+    bool m_StopReading = false;
+    bool m_IdleTimerStarted = false;
+    bool m_BodyStreamStarted = false;
+    bool m_Http10 = false;
+    bool m_GotTransferEncoding = false;
 
     std::optional<StormMessageReaderCursor> m_RequestMethod;
     std::optional<StormMessageReaderCursor> m_RequestURI;
     std::optional<StormHttpRequestReader> m_BodyReader;
+    StormFixedBlockHandle m_HeaderIndex = InvalidBlockHandle;
+
+    // Requests are numbered as they're parsed.  Responses that arrive ahead of an earlier request's are held until it's answered
+    StormMutex m_ResponseMutex;
+    uint32_t m_NextRequestIndex = 0;
+    uint32_t m_QueuedRequestIndex = 0; // One past the last request handed to the user, guarded by the response mutex
+    std::atomic<uint32_t> m_NextResponseIndex = { 0 };
+    std::atomic<uint32_t> m_CloseRequestIndex = { UINT32_MAX };
+    std::optional<StormHttpResponseWriter> m_HeldResponses[kMaxPipelinedRequests];
+
+    // The oldest unanswered request's response is still being streamed, later responses are held until it ends
+    bool m_StreamingResponse = false;
+    bool m_StreamChunked = false;
+    bool m_StreamCloseDelimited = false;
+    int64_t m_StreamRemaining = 0;
+
+    std::atomic<int64_t> m_LastActivity = { 0 };
+    std::atomic<int> m_PendingBodyChunks = { 0 };
+
+    // Reading stopped because too many requests or body chunks are outstanding, whoever brings it back under the limit resumes it
+    std::atomic_bool m_ReadPaused = { false };
   };
 }
@@ -1,10 +1,15 @@
 #pragma once
 
 #include "StormSocketConnection.h"
+#include "StormUtf8Validator.h"
+
+#include <string>
 
 
 namespace StormSockets
 {
+  class StormWebsocketDeflateContext;
+
   namespace StormSocketServerConnectionWebsocketState
   {
     enum Index
@@ -15,6 +20,7 @@ namespace StormSockets
       HandleContinuations,
       HandleIncomingPacket,
       SendPong,
+      StreamFrame,
     };
   }
 
@@ -31,6 +37,26 @@ namespace StormSockets
 
     int m_PendingReaderFullPacketLen = 0;
     bool m_ReaderValid = false;
+
+    StormWebsocketDeflateContext * m_DeflateContext = nullptr;
+    bool m_InflatingMessage = false;
+    int64_t m_InflatedLength = 0;
+
+    // Sent in the close frame when the connection is failed locally, 0 sends it without a status
+    uint16_t m_CloseCode = 0;
+
+    bool m_ValidatingText = false;
+    bool m_DeferringText = false;
+    StormUtf8ValidatorState m_Utf8State;
+
+    // Large frames being delivered in chunks as they arrive
+    uint64_t m_StreamRemaining = 0;
+    uint32_t m_StreamMask = 0;
+    int m_StreamHeaderLength = 0;
+    bool m_StreamFin = false;
+    bool m_StreamChunkReady = false;
+    StormSocketWebsocketDataType::Index m_StreamDataType = StormSocketWebsocketDataType::Binary;
+    std::string m_ExtensionHeader;
   };
 
   struct StormSocketServerConnectionWebSocket : public StormWebsocketConnectionBase
@@ -54,6 +80,7 @@ namespace StormSockets
     std::string m_Origin;
 
     std::string m_SecKeyHash;
+    bool m_OfferedDeflate = false;
 
     bool m_GotStatusLineHeader = false;
     bool m_GotWebsocketHeader = false;
@@ -36,6 +36,12 @@ namespace StormSockets
 
     virtual bool ProcessData(StormSocketConnectionId connection_id, StormSocketFrontendConnectionId frontend_id) = 0;
     virtual void ConnectionEstablishComplete(StormSocketConnectionId connection_id, StormSocketFrontendConnectionId frontend_id) = 0;
+
+    // Called from the keepalive timer started with StormSocketBackend::StartKeepalive, return false to stop the timer
+    virtual bool KeepaliveTick(StormSocketConnectionId connection_id, StormSocketFrontendConnectionId frontend_id) = 0;
+
+    virtual int GetCoalesceWindow() = 0;
+    virtual int GetCoalesceBytes() = 0;
   };
 }
 
@@ -23,6 +23,8 @@ namespace StormSockets
     m_EventSemaphore(settings.EventSemaphore)
   {
     m_MaxConnections = settings.MaxConnections;
+    m_CoalesceWindow = settings.CoalesceWindow;
+    m_CoalesceBytes = settings.CoalesceBytes;
 
     m_FixedBlockSize = backend->GetFixedBlockSize();
 
@@ -39,14 +41,24 @@ namespace StormSockets
     return false;
   }
 
-  bool StormSocketFrontendBase::SendPacketToConnection(StormMessageWriter & writer, StormSocketConnectionId id)
+  bool StormSocketFrontendBase::SendPacketToConnection(StormMessageWriter & writer, StormSocketConnectionId id, StormSocketSendPriority::Index priority)
   {
-    return m_Backend->SendPacketToConnection(writer, id);
+    return m_Backend->SendPacketToConnection(writer, id, priority);
   }
 
-  void StormSocketFrontendBase::SendPacketToConnectionBlocking(StormMessageWriter & writer, StormSocketConnectionId id)
+  void StormSocketFrontendBase::SendPacketToConnectionBlocking(StormMessageWriter & writer, StormSocketConnectionId id, StormSocketSendPriority::Index priority)
   {
-    m_Backend->SendPacketToConnectionBlocking(writer, id);
+    m_Backend->SendPacketToConnectionBlocking(writer, id, priority);
+  }
+
+  void StormSocketFrontendBase::Flush(StormSocketConnectionId id)
+  {
+    m_Backend->Flush(id);
+  }
+
+  int StormSocketFrontendBase::Broadcast(StormMessageWriter & writer, const StormSocketConnectionId * ids, int num_ids)
+  {
+    return m_Backend->Broadcast(writer, ids, num_ids);
   }
 
   void StormSocketFrontendBase::FreeOutgoingPacket(StormMessageWriter & writer)
@@ -272,6 +284,7 @@ namespace StormSockets
     connect_message.Type = StormSocketEventType::ClientConnected;
     connect_message.RemoteIP = remote_ip;
     connect_message.RemotePort = remote_port;
+    connect_message.RemoteAddress = GetConnection(connection_id).m_RemoteAddress;
     while (m_EventQueue.Enqueue(connect_message) == false)
     {
 #ifndef _INCLUDEOS
@@ -294,6 +307,7 @@ namespace StormSockets
     connect_message.ConnectionId = connection_id;
     connect_message.Type = StormSocketEventType::ClientHandShakeCompleted;
     connect_message.RemoteIP = connection.m_RemoteIP;
+    connect_message.RemoteAddress = connection.m_RemoteAddress;
     connect_message.RemotePort = connection.m_RemotePort;
     while (m_EventQueue.Enqueue(connect_message) == false)
     {
@@ -316,6 +330,7 @@ namespace StormSockets
     disconnect_message.ConnectionId = connection_id;
     disconnect_message.Type = StormSocketEventType::Disconnected;
     disconnect_message.RemoteIP = connection.m_RemoteIP;
+    disconnect_message.RemoteAddress = connection.m_RemoteAddress;
     disconnect_message.RemotePort = connection.m_RemotePort;
 
     while (m_EventQueue.Enqueue(disconnect_message) == false)
@@ -336,6 +351,21 @@ namespace StormSockets
     QueueHandshakeCompleteEvent(connection_id, frontend_id);
   }
 
+  bool StormSocketFrontendBase::KeepaliveTick([[maybe_unused]] StormSocketConnectionId connection_id, [[maybe_unused]] StormSocketFrontendConnectionId frontend_id)
+  {
+    return false;
+  }
+
+  int StormSocketFrontendBase::GetCoalesceWindow()
+  {
+    return m_CoalesceWindow;
+  }
+
+  int StormSocketFrontendBase::GetCoalesceBytes()
+  {
+    return m_CoalesceBytes;
+  }
+
   StormSocketConnectionBase & StormSocketFrontendBase::GetConnection(int index)
   {
     return m_Backend->GetConnection(index);
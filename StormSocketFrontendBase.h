@@ -56,6 +56,8 @@ namespace StormSockets
 
     int m_FixedBlockSize;
 		int m_MaxConnections;
+    int m_CoalesceWindow;
+    int m_CoalesceBytes;
 
 		// Queue that stores event data which is consumed by external code.  Events tell the user there was a connect or disconnect or new packet
 		StormMessageQueue<StormSocketEventInfo> m_EventQueue;
@@ -72,8 +74,12 @@ namespace StormSockets
 
 		bool GetEvent(StormSocketEventInfo & message);
 
-		bool SendPacketToConnection(StormMessageWriter & writer, StormSocketConnectionId id);
-		void SendPacketToConnectionBlocking(StormMessageWriter & writer, StormSocketConnectionId id);
+		bool SendPacketToConnection(StormMessageWriter & writer, StormSocketConnectionId id,
+      StormSocketSendPriority::Index priority = StormSocketSendPriority::Normal);
+		void SendPacketToConnectionBlocking(StormMessageWriter & writer, StormSocketConnectionId id,
+      StormSocketSendPriority::Index priority = StormSocketSendPriority::Normal);
+    void Flush(StormSocketConnectionId id);
+		int Broadcast(StormMessageWriter & writer, const StormSocketConnectionId * ids, int num_ids);
 		void FreeOutgoingPacket(StormMessageWriter & writer);
 
 		void FinalizeConnection(StormSocketConnectionId id);
@@ -97,6 +103,9 @@ namespace StormSockets
     void QueueHandshakeCompleteEvent(StormSocketConnectionId connection_id, StormSocketFrontendConnectionId frontend_id);
     void QueueDisconnectEvent(StormSocketConnectionId connection_id, StormSocketFrontendConnectionId frontend_id);
     void ConnectionEstablishComplete(StormSocketConnectionId connection_id, StormSocketFrontendConnectionId frontend_id);
+    bool KeepaliveTick(StormSocketConnectionId connection_id, StormSocketFrontendConnectionId frontend_id) override;
+    int GetCoalesceWindow() override;
+    int GetCoalesceBytes() override;
     StormSocketConnectionBase & GetConnection(int index);
 	};
 }
\ No newline at end of file
@@ -2,10 +2,15 @@
 #include "StormSocketFrontendHttpBase.h"
 #include "StormSocketLog.h"
 
+#include <algorithm>
+#include <chrono>
+#include <climits>
+
 namespace StormSockets
 {
   StormSocketFrontendHttpBase::StormSocketFrontendHttpBase(const StormSocketFrontendHttpSettings & settings, StormSocketBackend * backend) :
-    StormSocketFrontendBase(settings, backend)
+    StormSocketFrontendBase(settings, backend),
+    m_MaxBodySize(settings.MaxBodySize)
   {
 
   }
@@ -32,10 +37,23 @@ namespace StormSockets
             return true;
           }
 
+          if (BodyLengthAllowed(http_connection, http_connection.m_ChunkSize) == false)
+          {
+            StormSocketLog("Body too large\n");
+            ForceDisconnect(connection_id);
+            return true;
+          }
+
+          http_connection.m_BodyReceived += http_connection.m_ChunkSize;
+          http_connection.m_RecievedLength = 0;
           DiscardParsedData(connection_id, http_connection, full_data_len);
-          void * parse_block = m_Allocator.ResolveHandle(connection.m_ParseBlock);
 
-          AddBodyBlock(connection_id, http_connection, parse_block, http_connection.m_ChunkSize, connection.m_ParseOffset);
+          if (http_connection.m_StreamBody == false)
+          {
+            void * parse_block = m_Allocator.ResolveHandle(connection.m_ParseBlock);
+            AddBodyBlock(connection_id, http_connection, parse_block, (int)http_connection.m_ChunkSize, connection.m_ParseOffset);
+          }
+
           http_connection.m_State = StormSocketClientConnectionHttpState::ReadingChunk;
         }
         else
@@ -47,17 +65,40 @@ namespace StormSockets
       if (http_connection.m_State == StormSocketClientConnectionHttpState::ReadingChunk)
       {
         ProfileScope prof(ProfilerCategory::kProcChunk);
-        if (connection.m_UnparsedDataLength >= http_connection.m_ChunkSize + 2)
+        if (http_connection.m_StreamBody)
         {
-          if (http_connection.m_ChunkSize == 0)
+          int64_t remaining = http_connection.m_ChunkSize - http_connection.m_RecievedLength;
+          if (remaining > 0)
           {
-            if (CompleteBody(connection_id, http_connection) == false)
+            int length = (int)std::min<int64_t>(connection.m_UnparsedDataLength, remaining);
+            if (StreamBody(connection, http_connection, connection_id, length) == false)
             {
               return false;
             }
 
+            http_connection.m_RecievedLength += length;
+            if (length < remaining)
+            {
+              return true;
+            }
+          }
+
+          if (connection.m_UnparsedDataLength < 2)
+          {
             return true;
           }
+
+          DiscardParsedData(connection_id, http_connection, 2);
+          http_connection.m_State = http_connection.m_ChunkSize == 0 ?
+            StormSocketClientConnectionHttpState::Complete : StormSocketClientConnectionHttpState::ReadingChunkSize;
+        }
+        else if (connection.m_UnparsedDataLength >= http_connection.m_ChunkSize + 2)
+        {
+          if (http_connection.m_ChunkSize == 0)
+          {
+            DiscardParsedData(connection_id, http_connection, 2);
+            http_connection.m_State = StormSocketClientConnectionHttpState::Complete;
+          }
           else
           {
             http_connection.m_State = StormSocketClientConnectionHttpState::ReadingChunkSize;
@@ -72,30 +113,84 @@ namespace StormSockets
 
       if (http_connection.m_State == StormSocketClientConnectionHttpState::ReadingBody)
       {
-        if (http_connection.m_BodyLength > 0 && connection.m_UnparsedDataLength >= http_connection.m_BodyLength)
+        if (http_connection.m_StreamBody)
         {
-          void * parse_block = m_Allocator.ResolveHandle(connection.m_ParseBlock);
-
-          AddBodyBlock(connection_id, http_connection, parse_block, http_connection.m_BodyLength, connection.m_ParseOffset);
-          if (CompleteBody(connection_id, http_connection) == false)
+          int length = (int)std::min<int64_t>(connection.m_UnparsedDataLength, http_connection.m_BodyLength - http_connection.m_RecievedLength);
+          if (StreamBody(connection, http_connection, connection_id, length) == false)
           {
             return false;
           }
 
-          return true;
+          http_connection.m_RecievedLength += length;
+          if (http_connection.m_RecievedLength < http_connection.m_BodyLength)
+          {
+            return true;
+          }
+
+          http_connection.m_State = StormSocketClientConnectionHttpState::Complete;
+        }
+        else if (http_connection.m_BodyLength > 0 && connection.m_UnparsedDataLength >= http_connection.m_BodyLength)
+        {
+          void * parse_block = m_Allocator.ResolveHandle(connection.m_ParseBlock);
+
+          AddBodyBlock(connection_id, http_connection, parse_block, (int)http_connection.m_BodyLength, connection.m_ParseOffset);
+
+          // The body is part of the message, so whatever comes after it starts the next one
+          DiscardParsedData(connection_id, http_connection, (int)http_connection.m_BodyLength);
+          http_connection.m_State = StormSocketClientConnectionHttpState::Complete;
         }
         else
         {
           return true;
         }
       }
+
+      if (http_connection.m_State == StormSocketClientConnectionHttpState::Complete)
+      {
+        // Stays in this state if the event queue is full, so the retry only delivers the message
+        return CompleteBody(connection_id, http_connection);
+      }
     }
   }
 
+  bool StormSocketFrontendHttpBase::BodyLengthAllowed(StormHttpConnectionBase & http_connection, int64_t length)
+  {
+    if (m_MaxBodySize > 0 && http_connection.m_BodyReceived + length > m_MaxBodySize)
+    {
+      return false;
+    }
+
+    // Buffered bodies are addressed with int lengths
+    if (http_connection.m_StreamBody == false && length > INT_MAX - http_connection.m_TotalLength - 2)
+    {
+      return false;
+    }
+
+    return true;
+  }
+
+  bool StormSocketFrontendHttpBase::StreamBody(StormSocketConnectionBase & connection, StormHttpConnectionBase & http_connection, StormSocketConnectionId connection_id, int length)
+  {
+    void * parse_block = m_Allocator.ResolveHandle(connection.m_ParseBlock);
+    if (StreamBodyData(connection_id, http_connection, parse_block, length, connection.m_ParseOffset, false) == false)
+    {
+      return false;
+    }
+
+    // Everything parsed so far now belongs to the event that was just delivered
+    m_Backend->DiscardParserData(connection_id, length);
+    http_connection.m_TotalLength = 0;
+    return true;
+  }
+
   void StormSocketFrontendHttpBase::DiscardParsedData(StormSocketConnectionId connection_id, StormHttpConnectionBase & http_connection, int amount)
   {
     http_connection.m_TotalLength += amount;
     m_Backend->DiscardParserData(connection_id, amount);
   }
 
+  int64_t StormSocketFrontendHttpBase::GetTimeMs()
+  {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
 }
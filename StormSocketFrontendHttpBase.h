@@ -9,13 +9,25 @@ namespace StormSockets
   {
   protected:
 
+    int64_t m_MaxBodySize;
+
     StormSocketFrontendHttpBase(const StormSocketFrontendHttpSettings & settings, StormSocketBackend * backend);
     bool ProcessHttpData(StormSocketConnectionBase & connection, StormHttpConnectionBase & http_connection, StormSocketConnectionId connection_id);
 
     virtual void AddBodyBlock(StormSocketConnectionId connection_id, StormHttpConnectionBase & http_connection, void * chunk_ptr, int chunk_len, int read_offset) = 0;
     virtual bool CompleteBody(StormSocketConnectionId connection_id, StormHttpConnectionBase & http_connection) = 0;
 
+    // Hands off body data as it arrives when m_StreamBody is set.  Returning false stops reading and the data is offered again later
+    virtual bool StreamBodyData([[maybe_unused]] StormSocketConnectionId connection_id, [[maybe_unused]] StormHttpConnectionBase & http_connection,
+      [[maybe_unused]] void * chunk_ptr, [[maybe_unused]] int chunk_len, [[maybe_unused]] int read_offset, [[maybe_unused]] bool last_chunk) { return true; }
+
+    bool BodyLengthAllowed(StormHttpConnectionBase & http_connection, int64_t length);
+    bool StreamBody(StormSocketConnectionBase & connection, StormHttpConnectionBase & http_connection, StormSocketConnectionId connection_id, int length);
+
     void DiscardParsedData(StormSocketConnectionId connection_id, StormHttpConnectionBase & http_connection, int amount);
 
+    // Steady clock time in milliseconds, for idle and activity tracking
+    static int64_t GetTimeMs();
+
   };
 }
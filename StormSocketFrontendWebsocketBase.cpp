@@ -1,7 +1,11 @@
 
 #include "StormSocketFrontendWebsocketBase.h"
+#include "StormWebsocketMask.h"
 
 #include <stdexcept>
+#include <algorithm>
+#include <vector>
+#include <chrono>
 
 namespace StormSockets
 {
@@ -12,6 +16,48 @@ namespace StormSockets
     m_UseMasking = settings.UseMasking;
     m_ContinuationMode = settings.ContinuationMode;
     m_MaxPacketSize = settings.MaxPacketSize;
+    m_MaxContiguousPayloadSize = settings.MaxContiguousPayloadSize;
+    m_Utf8Validation = settings.Utf8Validation;
+    m_DeferUnmask = settings.DeferUnmask;
+    m_StreamingThreshold = settings.StreamingThreshold;
+    m_MaxFrameSize = settings.MaxFrameSize;
+
+    m_KeepaliveInterval = settings.KeepaliveInterval;
+    m_KeepaliveTimeout = settings.KeepaliveTimeout > 0 ? settings.KeepaliveTimeout : settings.KeepaliveInterval;
+    if (m_KeepaliveInterval > 0)
+    {
+      m_KeepaliveSlots = std::make_unique<KeepaliveSlot[]>(backend->GetMaxConnections());
+    }
+
+#ifndef DISABLE_ZLIB
+    m_UsePerMessageDeflate = settings.UsePerMessageDeflate;
+#else
+    m_UsePerMessageDeflate = false;
+#endif
+
+    m_DeflateSettings.m_LocalNoContextTakeover = settings.DeflateLocalNoContextTakeover;
+    m_DeflateSettings.m_RemoteNoContextTakeover = settings.DeflateRemoteNoContextTakeover;
+    m_DeflateSettings.m_LocalMaxWindowBits = std::min(std::max(settings.DeflateMaxWindowBits, 9), 15);
+    m_DeflateMinMessageSize = settings.DeflateMinMessageSize;
+    m_DeflateMaxMessageSize = settings.DeflateMaxMessageSize;
+
+#ifndef DISABLE_ZLIB
+    if (m_UsePerMessageDeflate)
+    {
+      int max_contexts = settings.DeflateMaxContexts > 0 ? settings.DeflateMaxContexts : settings.MaxConnections;
+      m_DeflatePool = std::make_unique<StormWebsocketDeflatePool>(max_contexts, settings.DeflateMemLevel);
+      m_DeflateSlots = std::make_unique<DeflateSlot[]>(backend->GetMaxConnections());
+
+      if (m_DeflateSettings.m_LocalNoContextTakeover)
+      {
+        m_SharedDeflateContext = std::make_unique<StormWebsocketDeflateContext>();
+        if (m_SharedDeflateContext->Init(m_DeflateSettings, settings.DeflateMemLevel) == false)
+        {
+          throw std::runtime_error("Failed to initialize deflate context");
+        }
+      }
+    }
+#endif
   }
 
   StormWebsocketMessageWriter StormSocketFrontendWebsocketBase::CreateOutgoingPacket(StormSocketWebsocketDataType::Index type, bool final)
@@ -45,6 +91,9 @@ namespace StormSockets
     writer.SaveHeaderRoom();
     writer.m_Mode = mode;
     writer.m_Final = final;
+    writer.m_Compressed = false;
+    writer.m_SharedCompressionDone = false;
+    writer.m_HasCompressedWriter = false;
     return writer;
   }
 
@@ -61,10 +110,666 @@ namespace StormSockets
     m_Backend->DiscardReaderData(reader.m_ConnectionId, reader.m_PacketDataLen);
   }
 
+  bool StormSocketFrontendWebsocketBase::IsCompressible(StormWebsocketMessageWriter & writer)
+  {
+    return writer.m_Final && (writer.m_Mode == StormWebsocketOp::BinaryFrame || writer.m_Mode == StormWebsocketOp::TextFrame) &&
+      writer.GetPayloadLength() >= m_DeflateMinMessageSize;
+  }
+
+  bool StormSocketFrontendWebsocketBase::CompressShared(StormWebsocketMessageWriter & writer)
+  {
+#ifndef DISABLE_ZLIB
+    StormLockGuard<StormMutex> lock(m_SharedDeflateMutex);
+    if (writer.m_SharedCompressionDone)
+    {
+      return writer.m_HasCompressedWriter;
+    }
+
+    writer.m_SharedCompressionDone = true;
+
+    StormWebsocketMessageWriter compressed_writer = CreateOutgoingPacket(writer.m_Mode, true);
+    compressed_writer.m_Compressed = true;
+
+    bool success = true;
+    writer.ForEachPayloadSegment([&](const void * data, int length)
+    {
+      success = success && m_SharedDeflateContext->Compress(data, length, compressed_writer);
+    });
+
+    success = success && m_SharedDeflateContext->FinishMessage(compressed_writer);
+    if (success == false)
+    {
+      m_SharedDeflateContext->ResetCompressor();
+    }
+
+    // Each message stands alone, so incompressible data can just go out as is
+    if (success && compressed_writer.GetLength() < writer.GetPayloadLength())
+    {
+      compressed_writer.CreateHeaderAndApplyMask((int)compressed_writer.m_Mode, true, m_UseMasking ? rand() : 0);
+      writer.m_CompressedWriter = compressed_writer;
+      writer.m_HasCompressedWriter = true;
+    }
+    else
+    {
+      FreeOutgoingPacket(compressed_writer);
+    }
+
+    return writer.m_HasCompressedWriter;
+#else
+    return false;
+#endif
+  }
+
+  StormWebsocketMessageWriter StormSocketFrontendWebsocketBase::GetSharedCompressedWriter(StormWebsocketMessageWriter & writer)
+  {
+    StormWebsocketMessageWriter compressed_writer(writer.m_CompressedWriter);
+    compressed_writer.m_Mode = writer.m_Mode;
+    compressed_writer.m_Final = true;
+    compressed_writer.m_Compressed = true;
+    compressed_writer.m_HasCompressedWriter = false;
+    return compressed_writer;
+  }
+
+  bool StormSocketFrontendWebsocketBase::NeedsFragmenting(StormWebsocketMessageWriter & writer)
+  {
+    return m_MaxFrameSize > 0 && writer.m_Final && (writer.m_Mode == StormWebsocketOp::BinaryFrame || writer.m_Mode == StormWebsocketOp::TextFrame) &&
+      writer.GetPayloadLength() > m_MaxFrameSize;
+  }
+
+  void StormSocketFrontendWebsocketBase::CreateFragments(StormWebsocketMessageWriter & writer, std::vector<StormMessageWriter> & fragments)
+  {
+    int payload_length = writer.GetPayloadLength();
+    int offset = 0;
+
+    while (offset < payload_length)
+    {
+      // Only the first frame carries the opcode and the compression bit
+      bool first = offset == 0;
+      StormWebsocketMessageWriter fragment = CreateOutgoingPacket(first ? writer.m_Mode : StormWebsocketOp::Continuation, false);
+      fragment.m_Compressed = first && writer.m_Compressed;
+
+      // Each fragment only holds its frame header, the payload goes out straight from the original message
+      int fragment_length = std::min(m_MaxFrameSize, payload_length - offset);
+      m_Backend->SetPacketSlice(fragment, writer, StormWebsocketMessageWriter::WebsocketMaxHeaderSize + offset, fragment_length);
+      offset += fragment_length;
+
+      fragment.CreateHeaderAndApplyMask((int)fragment.m_Mode, offset == payload_length, m_UseMasking ? rand() : 0);
+      fragments.push_back(fragment);
+    }
+  }
+
+  bool StormSocketFrontendWebsocketBase::SendFrames(StormWebsocketMessageWriter & writer, StormSocketConnectionId id, StormSocketSendPriority::Index priority,
+    bool blocking)
+  {
+    if (NeedsFragmenting(writer) == false)
+    {
+      // Data frames of a fragmented message can't have other messages between them
+      writer.m_ControlFrame = writer.m_Mode == StormWebsocketOp::Ping || writer.m_Mode == StormWebsocketOp::Pong || writer.m_Mode == StormWebsocketOp::Close;
+      writer.m_HoldsLane = writer.m_Final == false && writer.m_ControlFrame == false;
+
+      if (blocking)
+      {
+        m_Backend->SendPacketToConnectionBlocking(writer, id, priority);
+        return true;
+      }
+
+      return m_Backend->SendPacketToConnection(writer, id, priority);
+    }
+
+    static thread_local std::vector<StormMessageWriter> fragments;
+    fragments.clear();
+
+    CreateFragments(writer, fragments);
+
+    bool result = true;
+    if (blocking)
+    {
+      m_Backend->SendPacketSequenceToConnectionBlocking(fragments.data(), (int)fragments.size(), id, priority);
+    }
+    else
+    {
+      result = m_Backend->SendPacketSequenceToConnection(fragments.data(), (int)fragments.size(), id, priority);
+    }
+
+    for (auto & fragment : fragments)
+    {
+      m_Backend->FreeOutgoingPacket(fragment);
+    }
+
+    return result;
+  }
+
+  int StormSocketFrontendWebsocketBase::BroadcastFrames(StormWebsocketMessageWriter & writer, const StormSocketConnectionId * ids, int num_ids)
+  {
+    if (NeedsFragmenting(writer) == false)
+    {
+      return m_Backend->Broadcast(writer, ids, num_ids);
+    }
+
+    // The frames are built once and shared by every connection
+    static thread_local std::vector<StormMessageWriter> fragments;
+    fragments.clear();
+
+    CreateFragments(writer, fragments);
+
+    // Connections whose lane is full miss the message instead of holding up the rest
+    int num_sent = m_Backend->BroadcastSequence(fragments.data(), (int)fragments.size(), ids, num_ids);
+
+    for (auto & fragment : fragments)
+    {
+      m_Backend->FreeOutgoingPacket(fragment);
+    }
+
+    return num_sent;
+  }
+
+  bool StormSocketFrontendWebsocketBase::SendPacketToConnection(StormWebsocketMessageWriter & writer, StormSocketConnectionId id,
+    StormSocketSendPriority::Index priority)
+  {
+    return SendWebsocketMessage(writer, id, priority, false);
+  }
+
+  void StormSocketFrontendWebsocketBase::SendPacketToConnectionBlocking(StormWebsocketMessageWriter & writer, StormSocketConnectionId id,
+    StormSocketSendPriority::Index priority)
+  {
+    SendWebsocketMessage(writer, id, priority, true);
+  }
+
+  bool StormSocketFrontendWebsocketBase::SendWebsocketMessage(StormWebsocketMessageWriter & writer, StormSocketConnectionId id,
+    StormSocketSendPriority::Index priority, bool blocking)
+  {
+#ifndef DISABLE_ZLIB
+    if (m_DeflateSlots && IsCompressible(writer))
+    {
+      auto & slot = m_DeflateSlots[id.GetIndex()];
+      StormLockGuard<StormMutex> lock(slot.m_Mutex);
+
+      if (slot.m_Context != nullptr && slot.m_ConnectionGen == id.GetGen())
+      {
+        if (slot.m_UseSharedCompression)
+        {
+          if (CompressShared(writer))
+          {
+            StormWebsocketMessageWriter compressed_writer = GetSharedCompressedWriter(writer);
+            return SendFrames(compressed_writer, id, priority, blocking);
+          }
+
+          return SendFrames(writer, id, priority, blocking);
+        }
+
+        StormWebsocketMessageWriter compressed_writer = CreateOutgoingPacket(writer.m_Mode, true);
+        compressed_writer.m_Compressed = true;
+
+        bool success = true;
+        writer.ForEachPayloadSegment([&](const void * data, int length)
+        {
+          success = success && slot.m_Context->Compress(data, length, compressed_writer);
+        });
+
+        if (success == false || slot.m_Context->FinishMessage(compressed_writer) == false)
+        {
+          // The peer never sees the partial output, so start the next message fresh and send this one as is
+          FreeOutgoingPacket(compressed_writer);
+          slot.m_Context->ResetCompressor();
+          return SendFrames(writer, id, priority, blocking);
+        }
+
+        FinalizeOutgoingPacket(compressed_writer);
+
+        // With context takeover the peer has to see messages in the order they were compressed
+        if (slot.m_Context->GetParams().m_LocalNoContextTakeover == false)
+        {
+          priority = StormSocketSendPriority::Normal;
+        }
+
+        bool result = SendFrames(compressed_writer, id, priority, blocking);
+        if (result == false)
+        {
+          // The peer never sees this message, so the next one must not refer back to it
+          slot.m_Context->ResetCompressor();
+        }
+
+        FreeOutgoingPacket(compressed_writer);
+        return result;
+      }
+    }
+#endif
+
+    return SendFrames(writer, id, priority, blocking);
+  }
+
+  int StormSocketFrontendWebsocketBase::Broadcast(StormWebsocketMessageWriter & writer, const StormSocketConnectionId * ids, int num_ids)
+  {
+#ifndef DISABLE_ZLIB
+    if (m_DeflateSlots && IsCompressible(writer))
+    {
+      static thread_local std::vector<StormSocketConnectionId> shared_ids;
+      static thread_local std::vector<StormSocketConnectionId> plain_ids;
+      shared_ids.clear();
+      plain_ids.clear();
+
+      int num_sent = 0;
+      for (int index = 0; index < num_ids; ++index)
+      {
+        StormSocketConnectionId id = ids[index];
+        bool use_shared = false;
+        bool use_connection = false;
+
+        {
+          auto & slot = m_DeflateSlots[id.GetIndex()];
+          StormLockGuard<StormMutex> lock(slot.m_Mutex);
+
+          if (slot.m_Context != nullptr && slot.m_ConnectionGen == id.GetGen())
+          {
+            use_shared = slot.m_UseSharedCompression;
+            use_connection = slot.m_UseSharedCompression == false;
+          }
+        }
+
+        if (use_shared)
+        {
+          shared_ids.push_back(id);
+        }
+        else if (use_connection)
+        {
+          // Context takeover needs a separate deflate pass for each connection
+          num_sent += SendPacketToConnection(writer, id) ? 1 : 0;
+        }
+        else
+        {
+          plain_ids.push_back(id);
+        }
+      }
+
+      if (shared_ids.size() > 0)
+      {
+        if (CompressShared(writer))
+        {
+          StormWebsocketMessageWriter compressed_writer = GetSharedCompressedWriter(writer);
+          num_sent += BroadcastFrames(compressed_writer, shared_ids.data(), (int)shared_ids.size());
+        }
+        else
+        {
+          num_sent += BroadcastFrames(writer, shared_ids.data(), (int)shared_ids.size());
+        }
+      }
+
+      if (plain_ids.size() > 0)
+      {
+        num_sent += BroadcastFrames(writer, plain_ids.data(), (int)plain_ids.size());
+      }
+
+      return num_sent;
+    }
+#endif
+
+    return BroadcastFrames(writer, ids, num_ids);
+  }
+
+  void StormSocketFrontendWebsocketBase::FreeOutgoingPacket(StormWebsocketMessageWriter & writer)
+  {
+    if (writer.m_HasCompressedWriter)
+    {
+      m_Backend->FreeOutgoingPacket(writer.m_CompressedWriter);
+      writer.m_HasCompressedWriter = false;
+    }
+
+    m_Backend->FreeOutgoingPacket(writer);
+  }
+
+  bool StormSocketFrontendWebsocketBase::AllocateDeflateContext([[maybe_unused]] StormWebsocketConnectionBase & ws_connection,
+    [[maybe_unused]] const StormWebsocketDeflateParams & params)
+  {
+#ifndef DISABLE_ZLIB
+    ws_connection.m_DeflateContext = m_DeflatePool->Allocate(params);
+    return ws_connection.m_DeflateContext != nullptr;
+#else
+    return false;
+#endif
+  }
+
+  bool StormSocketFrontendWebsocketBase::ReconfigureDeflateContext([[maybe_unused]] StormWebsocketConnectionBase & ws_connection,
+    [[maybe_unused]] const StormWebsocketDeflateParams & params)
+  {
+#ifndef DISABLE_ZLIB
+    return m_DeflatePool->Reconfigure(ws_connection.m_DeflateContext, params);
+#else
+    return false;
+#endif
+  }
+
+  void StormSocketFrontendWebsocketBase::EnableDeflateContext([[maybe_unused]] StormSocketConnectionId connection_id,
+    [[maybe_unused]] StormWebsocketConnectionBase & ws_connection)
+  {
+#ifndef DISABLE_ZLIB
+    auto & slot = m_DeflateSlots[connection_id.GetIndex()];
+    StormLockGuard<StormMutex> lock(slot.m_Mutex);
+
+    slot.m_Context = ws_connection.m_DeflateContext;
+    slot.m_ConnectionGen = connection_id.GetGen();
+
+    const StormWebsocketDeflateParams & params = ws_connection.m_DeflateContext->GetParams();
+    slot.m_UseSharedCompression = m_SharedDeflateContext && params.m_LocalNoContextTakeover &&
+      params.m_LocalMaxWindowBits >= m_DeflateSettings.m_LocalMaxWindowBits;
+#endif
+  }
+
+  void StormSocketFrontendWebsocketBase::ReleaseDeflateContext([[maybe_unused]] StormSocketConnectionId connection_id,
+    [[maybe_unused]] StormWebsocketConnectionBase & ws_connection)
+  {
+#ifndef DISABLE_ZLIB
+    if (ws_connection.m_DeflateContext == nullptr)
+    {
+      return;
+    }
+
+    {
+      auto & slot = m_DeflateSlots[connection_id.GetIndex()];
+      StormLockGuard<StormMutex> lock(slot.m_Mutex);
+
+      if (slot.m_Context == ws_connection.m_DeflateContext)
+      {
+        slot.m_Context = nullptr;
+      }
+    }
+
+    m_DeflatePool->Free(ws_connection.m_DeflateContext);
+    ws_connection.m_DeflateContext = nullptr;
+#endif
+  }
+
+  bool StormSocketFrontendWebsocketBase::InflateFrame([[maybe_unused]] StormWebsocketConnectionBase & ws_connection,
+    [[maybe_unused]] StormWebsocketMessageReader & reader, [[maybe_unused]] void * cur_block, [[maybe_unused]] int read_offset,
+    [[maybe_unused]] int length, [[maybe_unused]] bool fin)
+  {
+#ifndef DISABLE_ZLIB
+    StormWebsocketDeflateContext * context = ws_connection.m_DeflateContext;
+    StormWebsocketInflateOutput output;
+
+    // The limit covers the whole message, so each frame gets what the earlier ones left
+    int max_length = m_DeflateMaxMessageSize > 0 ? (int)(m_DeflateMaxMessageSize - ws_connection.m_InflatedLength) : -1;
+
+    bool success = true;
+    while (success && length > 0 && cur_block != NULL)
+    {
+      int segment_length = std::min(m_FixedBlockSize - read_offset, length);
+      success = context->Decompress(Marshal::MemOffset(cur_block, read_offset), segment_length, m_Allocator, output, max_length);
+      length -= segment_length;
+
+      cur_block = m_Allocator.GetNextBlock(cur_block);
+      read_offset = 0;
+    }
+
+    if (success && fin)
+    {
+      success = context->FinishDecompress(m_Allocator, output, max_length);
+    }
+
+    ws_connection.m_InflatedLength += output.m_Length;
+
+    if (output.m_StartBlock == InvalidBlockHandle)
+    {
+      output.m_StartBlock = m_Allocator.AllocateBlock(StormFixedBlockType::BlockMem);
+    }
+
+    // The reader now points at the inflated copy and frees it along with the reader chain
+    reader.m_PacketInfo->m_CurBlock = m_Allocator.ResolveHandle(output.m_StartBlock);
+    reader.m_PacketInfo->m_ReadOffset = 0;
+    reader.m_PacketInfo->m_DataLength = output.m_Length;
+    reader.m_PacketInfo->m_OwnedBlocks = output.m_StartBlock;
+    reader.m_FullDataLen = output.m_Length;
+
+    return success;
+#else
+    return false;
+#endif
+  }
+
+  static int64_t GetKeepaliveTime()
+  {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  int StormSocketFrontendWebsocketBase::GetConnectionRtt(StormSocketConnectionId id)
+  {
+    if (m_KeepaliveSlots == nullptr || m_Backend->ConnectionIdValid(id) == false)
+    {
+      return -1;
+    }
+
+    return m_KeepaliveSlots[id.GetIndex()].m_SmoothedRtt;
+  }
+
+  void StormSocketFrontendWebsocketBase::StartKeepalive(StormSocketConnectionId connection_id)
+  {
+    if (m_KeepaliveInterval <= 0)
+    {
+      return;
+    }
+
+    auto & slot = m_KeepaliveSlots[connection_id.GetIndex()];
+    slot.m_PingSentTime = 0;
+    slot.m_SmoothedRtt = -1;
+
+    m_Backend->StartKeepalive(connection_id, m_KeepaliveInterval);
+  }
+
+  bool StormSocketFrontendWebsocketBase::KeepaliveTick(StormSocketConnectionId connection_id, [[maybe_unused]] StormSocketFrontendConnectionId frontend_id)
+  {
+    if (m_KeepaliveInterval <= 0)
+    {
+      return false;
+    }
+
+    auto & slot = m_KeepaliveSlots[connection_id.GetIndex()];
+    int64_t now = GetKeepaliveTime();
+    int64_t sent_time = slot.m_PingSentTime;
+
+    if (sent_time != 0)
+    {
+      if (now - sent_time >= (int64_t)m_KeepaliveTimeout * 1000)
+      {
+        ForceDisconnect(connection_id);
+        return false;
+      }
+
+      return true;
+    }
+
+    uint32_t sequence = slot.m_PingSequence.fetch_add(1) + 1;
+    slot.m_PingSentTime = now;
+
+    int control_buffer_index = 0;
+    uint8_t * control_buffer = (uint8_t *)m_Backend->ReserveControlBuffer(connection_id, control_buffer_index);
+    if (control_buffer != nullptr)
+    {
+      control_buffer[0] = 0x80 | StormWebsocketOp::Ping;
+      control_buffer[1] = sizeof(sequence);
+      memcpy(control_buffer + 2, &sequence, sizeof(sequence));
+
+      m_Backend->SendControlBuffer(connection_id, control_buffer_index, 2 + sizeof(sequence));
+    }
+    else
+    {
+      StormWebsocketMessageWriter writer = CreateOutgoingPacket(StormWebsocketOp::Ping, true);
+      writer.WriteInt32(sequence);
+      FinalizeOutgoingPacket(writer);
+
+      SendPacketToConnection(writer, connection_id, StormSocketSendPriority::High);
+      FreeOutgoingPacket(writer);
+    }
+
+    return true;
+  }
+
+  bool StormSocketFrontendWebsocketBase::ProcessKeepalivePong(StormWebsocketMessageReader & reader)
+  {
+    if (m_KeepaliveInterval <= 0 || reader.m_FullDataLen != sizeof(uint32_t))
+    {
+      return false;
+    }
+
+    auto & slot = m_KeepaliveSlots[reader.m_ConnectionId.GetIndex()];
+    int64_t sent_time = slot.m_PingSentTime;
+    if (sent_time == 0)
+    {
+      return false;
+    }
+
+    // Peek at the payload so that pongs that aren't ours still get delivered intact
+    void * cur_block = reader.m_PacketInfo->m_CurBlock;
+    int read_offset = reader.m_PacketInfo->m_ReadOffset;
+    int data_length = reader.m_PacketInfo->m_DataLength;
+
+    uint32_t sequence;
+    reader.ReadByteBlock(&sequence, sizeof(sequence));
+
+    reader.m_PacketInfo->m_CurBlock = cur_block;
+    reader.m_PacketInfo->m_ReadOffset = read_offset;
+    reader.m_PacketInfo->m_DataLength = data_length;
+
+    if (sequence != slot.m_PingSequence || slot.m_PingSentTime.compare_exchange_strong(sent_time, 0) == false)
+    {
+      return false;
+    }
+
+    // Same smoothing factor as TCP's SRTT
+    int rtt = (int)std::min<int64_t>(GetKeepaliveTime() - sent_time, INT32_MAX);
+    int smoothed_rtt = slot.m_SmoothedRtt;
+    slot.m_SmoothedRtt = smoothed_rtt < 0 ? rtt : smoothed_rtt + (rtt - smoothed_rtt) / 8;
+    return true;
+  }
+
+  bool StormSocketFrontendWebsocketBase::ValidateTextFrame(StormWebsocketConnectionBase & ws_connection, StormWebsocketMessageReader & reader, bool fin)
+  {
+    // Walk the (unmasked and inflated) payload without consuming it
+    void * cur_block = reader.m_PacketInfo->m_CurBlock;
+    int read_offset = reader.m_PacketInfo->m_ReadOffset;
+    int data_length = reader.m_PacketInfo->m_DataLength;
+
+    while (data_length > 0 && cur_block != NULL)
+    {
+      int segment_length = std::min(m_FixedBlockSize - read_offset, data_length);
+      if (StormUtf8Validate(Marshal::MemOffset(cur_block, read_offset), segment_length, ws_connection.m_Utf8State) == false)
+      {
+        return false;
+      }
+
+      data_length -= segment_length;
+
+      cur_block = m_Allocator.GetNextBlock(cur_block);
+      read_offset = 0;
+    }
+
+    return fin == false || StormUtf8Complete(ws_connection.m_Utf8State);
+  }
+
   bool StormSocketFrontendWebsocketBase::ProcessWebsocketData(StormSocketConnectionBase & connection, StormWebsocketConnectionBase & ws_connection, StormSocketConnectionId connection_id)
   {
     while (true)
     {
+      if (ws_connection.m_State == StormSocketServerConnectionWebsocketState::StreamFrame)
+      {
+        if (ws_connection.m_StreamChunkReady == false)
+        {
+          StormMessageHeaderReader cur_header(&m_Allocator, m_Allocator.ResolveHandle(connection.m_ParseBlock), connection.m_UnparsedDataLength, connection.m_ParseOffset);
+
+          // Wait for at least a full block unless that's all that's left
+          int available = (int)std::min<uint64_t>(ws_connection.m_StreamRemaining, cur_header.GetRemainingLength());
+          if ((uint64_t)available < std::min<uint64_t>(ws_connection.m_StreamRemaining, m_FixedBlockSize))
+          {
+            return true;
+          }
+
+          bool last_chunk = (uint64_t)available == ws_connection.m_StreamRemaining;
+          bool fin = last_chunk && ws_connection.m_StreamFin;
+
+          StormFixedBlockHandle cur_block_handle = m_Allocator.GetHandleForBlock(cur_header.m_CurBlock);
+          StormWebsocketMessageReader reader(&m_Allocator, &m_MessageReaders, cur_block_handle, available, cur_header.m_ReadOffset, connection_id, m_FixedBlockSize);
+          reader.m_PacketDataLen = available + ws_connection.m_StreamHeaderLength;
+          reader.m_FullDataLen = available;
+          reader.m_DataType = ws_connection.m_StreamDataType;
+          reader.m_FinalInSequence = fin;
+          reader.m_MaxContiguousPayloadSize = m_MaxContiguousPayloadSize;
+
+          if (ws_connection.m_StreamMask != 0)
+          {
+            void * cur_block = cur_header.m_CurBlock;
+            int read_offset = cur_header.m_ReadOffset;
+            int data_length = available;
+
+            while (data_length > 0 && cur_block != NULL)
+            {
+              int segment_length = std::min(m_FixedBlockSize - read_offset, data_length);
+              ws_connection.m_StreamMask = StormWebsocketApplyMask(Marshal::MemOffset(cur_block, read_offset), segment_length, ws_connection.m_StreamMask);
+              data_length -= segment_length;
+
+              cur_block = m_Allocator.GetNextBlock(cur_block);
+              read_offset = 0;
+            }
+          }
+
+          if (ws_connection.m_ValidatingText)
+          {
+            if (ValidateTextFrame(ws_connection, reader, fin) == false)
+            {
+              if (m_Utf8Validation == StormSocketUtf8ValidationMode::ValidateAndClose)
+              {
+                reader.FreeChain();
+                m_Backend->SignalCloseThread(connection_id);
+                return true;
+              }
+
+              reader.m_Utf8Valid = false;
+            }
+
+            if (fin)
+            {
+              ws_connection.m_ValidatingText = false;
+            }
+          }
+
+          ws_connection.m_PendingReader = reader;
+          ws_connection.m_StreamChunkReady = true;
+        }
+
+        // Send this to the main thread
+        StormSocketEventInfo data_message;
+        data_message.GetWebsocketReader() = ws_connection.m_PendingReader;
+        data_message.ConnectionId = connection_id;
+        data_message.Type = StormSocketEventType::Data;
+        data_message.RemoteIP = connection.m_RemoteIP;
+        data_message.RemoteAddress = connection.m_RemoteAddress;
+        data_message.RemotePort = connection.m_RemotePort;
+
+        if (m_EventQueue.Enqueue(data_message) == false)
+        {
+          return false;
+        }
+
+        if (m_EventSemaphore)
+        {
+          m_EventSemaphore->Release();
+        }
+
+        connection.m_PacketsRecved.fetch_add(1);
+
+        int chunk_length = ws_connection.m_PendingReader.m_FullDataLen;
+        m_Backend->DiscardParserData(connection_id, chunk_length);
+
+        ws_connection.m_StreamRemaining -= chunk_length;
+        ws_connection.m_StreamHeaderLength = 0;
+        ws_connection.m_StreamDataType = StormSocketWebsocketDataType::Continuation;
+        ws_connection.m_StreamChunkReady = false;
+
+        if (ws_connection.m_StreamRemaining == 0)
+        {
+          ws_connection.m_State = StormSocketServerConnectionWebsocketState::ReadHeaderAndApplyMask;
+        }
+
+        continue;
+      }
+
       if (ws_connection.m_State == StormSocketServerConnectionWebsocketState::ReadHeaderAndApplyMask)
       {
         StormMessageHeaderReader cur_header(&m_Allocator, m_Allocator.ResolveHandle(connection.m_ParseBlock), connection.m_UnparsedDataLength, connection.m_ParseOffset);
@@ -77,7 +782,9 @@ namespace StormSockets
         uint8_t len1 = cur_header.ReadByte();
         int header_len = 2;
 
-        if ((opdata & 0x70) != 0) // Reserved bits must be zero
+        // Reserved bits must be zero, except for RSV1 which marks a compressed message when permessage-deflate is in use
+        bool compressed = (opdata & 0x40) != 0;
+        if ((opdata & 0x30) != 0 || (compressed && ws_connection.m_DeflateContext == nullptr))
         {
           m_Backend->SignalCloseThread(connection_id);
           return true;
@@ -86,6 +793,12 @@ namespace StormSockets
         bool fin = (opdata & 0x80) != 0;
         int opcode = opdata & 0x0F;
 
+        if (compressed && opcode != StormWebsocketOp::BinaryFrame && opcode != StormWebsocketOp::TextFrame)
+        {
+          m_Backend->SignalCloseThread(connection_id);
+          return true;
+        }
+
         bool mask_enabled = (len1 & 0x80) != 0;
 
         // Figure out how much data is in the packet
@@ -125,6 +838,44 @@ namespace StormSockets
           header_len += 4;
         }
 
+        bool is_data = opcode == StormWebsocketOp::BinaryFrame || opcode == StormWebsocketOp::TextFrame || opcode == StormWebsocketOp::Continuation;
+        bool inflating = compressed || (opcode == StormWebsocketOp::Continuation && ws_connection.m_InflatingMessage);
+
+        // Large frames get handed over as they arrive, unless they have to be inflated or combined with earlier fragments
+        if (m_StreamingThreshold > 0 && len > (uint64_t)m_StreamingThreshold && is_data && inflating == false && ws_connection.m_ReaderValid == false)
+        {
+          if ((opcode == StormWebsocketOp::Continuation) != ws_connection.m_InContinuation)
+          {
+            m_Backend->SignalCloseThread(connection_id);
+            return true;
+          }
+
+          if (opcode == StormWebsocketOp::Continuation)
+          {
+            ws_connection.m_StreamDataType = StormSocketWebsocketDataType::Continuation;
+          }
+          else
+          {
+            ws_connection.m_StreamDataType = opcode == StormWebsocketOp::TextFrame ? StormSocketWebsocketDataType::Text : StormSocketWebsocketDataType::Binary;
+            ws_connection.m_InflatingMessage = false;
+            ws_connection.m_DeferringText = false;
+            ws_connection.m_ValidatingText = opcode == StormWebsocketOp::TextFrame && m_Utf8Validation != StormSocketUtf8ValidationMode::Off;
+            ws_connection.m_Utf8State = {};
+          }
+
+          ws_connection.m_InContinuation = !fin;
+          ws_connection.m_StreamRemaining = len;
+          ws_connection.m_StreamMask = mask;
+          ws_connection.m_StreamHeaderLength = header_len;
+          ws_connection.m_StreamFin = fin;
+          ws_connection.m_StreamChunkReady = false;
+
+          // The first chunk's reader gives the header back to the receive buffer
+          m_Backend->DiscardParserData(connection_id, header_len);
+          ws_connection.m_State = StormSocketServerConnectionWebsocketState::StreamFrame;
+          continue;
+        }
+
         if ((uint64_t)cur_header.GetRemainingLength() < len)
         {
           return true;
@@ -159,6 +910,11 @@ namespace StormSockets
             m_Backend->SignalCloseThread(connection_id);
             return true;
           }
+
+          ws_connection.m_InflatingMessage = compressed;
+          ws_connection.m_InflatedLength = 0;
+          ws_connection.m_ValidatingText = false;
+          ws_connection.m_DeferringText = false;
           break;
         case StormWebsocketOp::TextFrame:
           if (ws_connection.m_InContinuation == true)
@@ -168,6 +924,19 @@ namespace StormSockets
           }
 
           data_type = StormSocketWebsocketDataType::Text;
+          ws_connection.m_InflatingMessage = compressed;
+          ws_connection.m_InflatedLength = 0;
+          ws_connection.m_ValidatingText = m_Utf8Validation != StormSocketUtf8ValidationMode::Off;
+          ws_connection.m_Utf8State = {};
+
+          // The reader can only carry validation across fragments when they're delivered as one message
+          ws_connection.m_DeferringText = m_DeferUnmask && m_Utf8Validation == StormSocketUtf8ValidationMode::Validate && compressed == false &&
+            (fin || m_ContinuationMode == StormSocketContinuationMode::Combine);
+
+          if (ws_connection.m_DeferringText)
+          {
+            ws_connection.m_ValidatingText = false;
+          }
           break;
         case StormWebsocketOp::Pong:
           if (!fin || len > 125)
@@ -209,43 +978,75 @@ namespace StormSockets
         reader.m_FullDataLen = (int)len;
         reader.m_DataType = data_type;
         reader.m_FinalInSequence = fin;
+        reader.m_MaxContiguousPayloadSize = m_MaxContiguousPayloadSize;
 
-        if (mask != 0)
+        if (m_DeferUnmask && is_data && ws_connection.m_InflatingMessage == false && ws_connection.m_ValidatingText == false)
+        {
+          // Leave the payload for the reader to unmask when it's consumed
+          reader.m_PacketInfo->m_Mask = mask;
+          reader.m_PacketInfo->m_Deferred = mask != 0 || ws_connection.m_DeferringText;
+          reader.m_Utf8Pending = ws_connection.m_DeferringText;
+        }
+        else if (mask != 0)
         {
           // Apply the mask
           void * cur_block = cur_header.m_CurBlock;
           int read_offset = cur_header.m_ReadOffset;
           int data_length = (int)len;
 
-          do
+          while (data_length > 0 && cur_block != NULL)
           {
-            if (data_length >= 4 && read_offset + 4 <= m_FixedBlockSize)
-            {
-              int val = Marshal::ReadInt32(cur_block, read_offset);
-              val ^= (int)mask;
+            int segment_length = std::min(m_FixedBlockSize - read_offset, data_length);
+            mask = StormWebsocketApplyMask(Marshal::MemOffset(cur_block, read_offset), segment_length, mask);
+            data_length -= segment_length;
+
+            cur_block = m_Allocator.GetNextBlock(cur_block);
+            read_offset = 0;
+          }
+        }
 
-              Marshal::WriteInt32(cur_block, read_offset, val);
-              read_offset += 4;
-              data_length -= 4;
+        if (ws_connection.m_InflatingMessage && is_data)
+        {
+          if (InflateFrame(ws_connection, reader, cur_header.m_CurBlock, cur_header.m_ReadOffset, (int)len, fin) == false)
+          {
+            reader.FreeChain();
+            if (m_DeflateMaxMessageSize > 0 && ws_connection.m_InflatedLength > m_DeflateMaxMessageSize)
+            {
+              // Message too big
+              ws_connection.m_CloseCode = 1009;
+              ForceDisconnect(connection_id);
             }
-            else if (data_length > 0 && read_offset != m_FixedBlockSize)
+            else
             {
-              int val = Marshal::ReadByte(cur_block, read_offset);
-              val ^= (int)mask;
-
-              Marshal::WriteByte(cur_block, read_offset, (uint8_t)val);
-              read_offset += 1;
-              data_length -= 1;
-
-              mask = (mask << 24) | (mask >> 8);
+              m_Backend->SignalCloseThread(connection_id);
             }
+            return true;
+          }
+
+          if (fin)
+          {
+            ws_connection.m_InflatingMessage = false;
+          }
+        }
 
-            if (read_offset == m_FixedBlockSize)
+        if (ws_connection.m_ValidatingText && (op == StormWebsocketOp::TextFrame || op == StormWebsocketOp::Continuation))
+        {
+          if (ValidateTextFrame(ws_connection, reader, fin) == false)
+          {
+            if (m_Utf8Validation == StormSocketUtf8ValidationMode::ValidateAndClose)
             {
-              cur_block = m_Allocator.GetNextBlock(cur_block);
-              read_offset = 0;
+              reader.FreeChain();
+              m_Backend->SignalCloseThread(connection_id);
+              return true;
             }
-          } while (data_length > 0 && cur_block != NULL);
+
+            reader.m_Utf8Valid = false;
+          }
+
+          if (fin)
+          {
+            ws_connection.m_ValidatingText = false;
+          }
         }
 
         if (op == StormWebsocketOp::Close)
@@ -288,6 +1089,7 @@ namespace StormSockets
               data_message.ConnectionId = connection_id;
               data_message.Type = StormSocketEventType::Data;
               data_message.RemoteIP = connection.m_RemoteIP;
+              data_message.RemoteAddress = connection.m_RemoteAddress;
               data_message.RemotePort = connection.m_RemotePort;
 
               if (m_EventQueue.Enqueue(data_message) == false)
@@ -312,6 +1114,7 @@ namespace StormSockets
               if (m_ContinuationMode == StormSocketContinuationMode::Combine)
               {
                 ws_connection.m_InitialReader.AddLength(reader.m_FullDataLen);
+                ws_connection.m_InitialReader.m_Utf8Valid &= reader.m_Utf8Valid;
               }
             }
           }
@@ -331,25 +1134,25 @@ namespace StormSockets
         StormWebsocketMessageReader reader = ws_connection.m_PendingReader;
         if (reader.m_DataType == StormSocketWebsocketDataType::Ping)
         {
-          // Reply with a pong
-          StormWebsocketMessageWriter writer = CreateOutgoingPacket(StormWebsocketOp::Pong, true);
-
-          // Copy data from the recv'd message to the output message
+          // Reply with a pong, written straight into one of the connection's control buffers when one is free
           int length = (int)reader.m_FullDataLen;
-          while (length > 0)
+          int control_buffer_index = 0;
+          uint8_t * control_buffer = (uint8_t *)m_Backend->ReserveControlBuffer(connection_id, control_buffer_index);
+
+          StormWebsocketMessageWriter writer;
+          if (control_buffer != nullptr)
           {
-            if (length >= 4)
-            {
-              int val = reader.ReadInt32();
-              writer.WriteInt32(val);
-              length -= 4;
-            }
-            else
-            {
-              uint8_t val = reader.ReadByte();
-              writer.WriteByte(val);
-              length -= 1;
-            }
+            control_buffer[0] = 0x80 | StormWebsocketOp::Pong;
+            control_buffer[1] = (uint8_t)length;
+            reader.ReadByteBlock(control_buffer + 2, length);
+          }
+          else
+          {
+            uint8_t payload[125];
+            reader.ReadByteBlock(payload, length);
+
+            writer = CreateOutgoingPacket(StormWebsocketOp::Pong, true);
+            writer.WriteByteBlock(payload, 0, length);
           }
 
           // Release the reader
@@ -365,14 +1168,38 @@ namespace StormSockets
           }
 
           // Send the message
-          writer.CreateHeaderAndApplyMask((int)StormWebsocketOp::Pong, true, rand());
+          if (control_buffer != nullptr)
+          {
+            m_Backend->SendControlBuffer(connection_id, control_buffer_index, length + 2);
+            ws_connection.m_State = StormSocketServerConnectionWebsocketState::ReadHeaderAndApplyMask;
+          }
+          else
+          {
+            writer.CreateHeaderAndApplyMask((int)StormWebsocketOp::Pong, true, rand());
 
-          ws_connection.m_PendingWriter = writer;
-          ws_connection.m_State = StormSocketServerConnectionWebsocketState::SendPong;
+            ws_connection.m_PendingWriter = writer;
+            ws_connection.m_State = StormSocketServerConnectionWebsocketState::SendPong;
+          }
 
           // Advance past this packet to check if another packet is in the buffer
           m_Backend->DiscardParserData(connection_id, ws_connection.m_PendingReaderFullPacketLen);
         }
+        else if (reader.m_DataType == StormSocketWebsocketDataType::Pong && ProcessKeepalivePong(reader))
+        {
+          // Answer to one of our keepalive pings, don't bother the user with it
+          if (ws_connection.m_ReaderValid)
+          {
+            ws_connection.m_InitialReader.m_PacketDataLen += reader.m_PacketDataLen;
+            reader.FreeChain();
+          }
+          else
+          {
+            FreeIncomingPacket(reader);
+          }
+
+          m_Backend->DiscardParserData(connection_id, ws_connection.m_PendingReaderFullPacketLen);
+          ws_connection.m_State = StormSocketServerConnectionWebsocketState::ReadHeaderAndApplyMask;
+        }
         else if (reader.m_DataType == StormSocketWebsocketDataType::Pong)
         {
           // Send this to the main thread
@@ -381,6 +1208,7 @@ namespace StormSockets
           data_message.ConnectionId = connection_id;
           data_message.Type = StormSocketEventType::Data;
           data_message.RemoteIP = connection.m_RemoteIP;
+          data_message.RemoteAddress = connection.m_RemoteAddress;
           data_message.RemotePort = connection.m_RemotePort;
 
           if (m_EventQueue.Enqueue(data_message) == false)
@@ -413,6 +1241,7 @@ namespace StormSockets
             data_message.ConnectionId = connection_id;
             data_message.Type = StormSocketEventType::Data;
             data_message.RemoteIP = connection.m_RemoteIP;
+            data_message.RemoteAddress = connection.m_RemoteAddress;
             data_message.RemotePort = connection.m_RemotePort;
 
             if (m_EventQueue.Enqueue(data_message) == false)
@@ -437,7 +1266,7 @@ namespace StormSockets
       if (ws_connection.m_State == StormSocketServerConnectionWebsocketState::SendPong)
       {
         StormMessageWriter writer = ws_connection.m_PendingWriter;
-        if (SendPacketToConnection(writer, connection_id) == false)
+        if (SendPacketToConnection(writer, connection_id, StormSocketSendPriority::High) == false)
         {
           return false;
         }
@@ -447,17 +1276,19 @@ namespace StormSockets
     }
   }
 
-  void StormSocketFrontendWebsocketBase::CleanupWebsocketConnection(StormWebsocketConnectionBase & ws_connection)
+  void StormSocketFrontendWebsocketBase::CleanupWebsocketConnection(StormSocketConnectionId connection_id, StormWebsocketConnectionBase & ws_connection)
   {
     if (ws_connection.m_ReaderValid)
     {
       ws_connection.m_InitialReader.FreeChain();
     }
 
-    if (ws_connection.m_State == StormSocketServerConnectionWebsocketState::HandleContinuations)
+    if (ws_connection.m_State == StormSocketServerConnectionWebsocketState::HandleContinuations ||
+      (ws_connection.m_State == StormSocketServerConnectionWebsocketState::StreamFrame && ws_connection.m_StreamChunkReady))
     {
       FreeIncomingPacket(ws_connection.m_PendingReader);
     }
 
+    ReleaseDeflateContext(connection_id, ws_connection);
   }
 }
@@ -4,6 +4,10 @@
 #include "StormSocketConnectionWebsocket.h"
 #include "StormWebsocketMessageWriter.h"
 #include "StormWebsocketMessageReader.h"
+#include "StormWebsocketDeflate.h"
+
+#include <atomic>
+#include <vector>
 
 namespace StormSockets
 {
@@ -14,6 +18,47 @@ namespace StormSockets
     bool m_UseMasking;
     StormSocketContinuationMode::Index m_ContinuationMode;
     int m_MaxPacketSize;
+    int m_MaxContiguousPayloadSize;
+    StormSocketUtf8ValidationMode::Index m_Utf8Validation;
+    bool m_DeferUnmask;
+    int m_StreamingThreshold;
+    int m_MaxFrameSize;
+
+    int m_KeepaliveInterval;
+    int m_KeepaliveTimeout;
+
+    // Keepalive state indexed by backend connection, shared between the keepalive timer, the IO thread and GetConnectionRtt
+    struct KeepaliveSlot
+    {
+      std::atomic<uint32_t> m_PingSequence = { 0 };
+      std::atomic<int64_t> m_PingSentTime = { 0 }; // Microseconds, 0 when there's no ping waiting on a pong
+      std::atomic<int> m_SmoothedRtt = { -1 };
+    };
+
+    std::unique_ptr<KeepaliveSlot[]> m_KeepaliveSlots;
+
+    bool m_UsePerMessageDeflate;
+    StormWebsocketDeflateParams m_DeflateSettings;
+    int m_DeflateMinMessageSize;
+    int m_DeflateMaxMessageSize;
+
+#ifndef DISABLE_ZLIB
+    // Compression contexts indexed by backend connection, so that user threads can look them up from a connection id
+    struct DeflateSlot
+    {
+      StormMutex m_Mutex;
+      StormWebsocketDeflateContext * m_Context = nullptr;
+      int m_ConnectionGen = 0;
+      bool m_UseSharedCompression = false;
+    };
+
+    std::unique_ptr<StormWebsocketDeflatePool> m_DeflatePool;
+    std::unique_ptr<DeflateSlot[]> m_DeflateSlots;
+
+    // Without context takeover every message is compressed on its own, so one copy can go to every connection
+    StormMutex m_SharedDeflateMutex;
+    std::unique_ptr<StormWebsocketDeflateContext> m_SharedDeflateContext;
+#endif
 
   public:
 
@@ -23,11 +68,45 @@ namespace StormSockets
     void FinalizeOutgoingPacket(StormWebsocketMessageWriter & writer);
     void FreeIncomingPacket(StormWebsocketMessageReader & reader);
 
+    using StormSocketFrontendBase::SendPacketToConnection;
+    using StormSocketFrontendBase::SendPacketToConnectionBlocking;
+    using StormSocketFrontendBase::Broadcast;
+
+    bool SendPacketToConnection(StormWebsocketMessageWriter & writer, StormSocketConnectionId id,
+      StormSocketSendPriority::Index priority = StormSocketSendPriority::Normal);
+    void SendPacketToConnectionBlocking(StormWebsocketMessageWriter & writer, StormSocketConnectionId id,
+      StormSocketSendPriority::Index priority = StormSocketSendPriority::Normal);
+    int Broadcast(StormWebsocketMessageWriter & writer, const StormSocketConnectionId * ids, int num_ids);
+    void FreeOutgoingPacket(StormWebsocketMessageWriter & writer);
+
+    // Smoothed round trip time of keepalive pings in microseconds, or -1 before the first pong
+    int GetConnectionRtt(StormSocketConnectionId id);
+
   protected:
 
+    void StartKeepalive(StormSocketConnectionId connection_id);
+    bool KeepaliveTick(StormSocketConnectionId connection_id, StormSocketFrontendConnectionId frontend_id) override;
+    bool ProcessKeepalivePong(StormWebsocketMessageReader & reader);
+
     StormWebsocketMessageWriter CreateOutgoingPacket(StormWebsocketOp::Index mode, bool final);
     bool ProcessWebsocketData(StormSocketConnectionBase & connection, StormWebsocketConnectionBase & ws_connection, StormSocketConnectionId connection_id);
 
-    void CleanupWebsocketConnection(StormWebsocketConnectionBase & ws_connection);
+    bool AllocateDeflateContext(StormWebsocketConnectionBase & ws_connection, const StormWebsocketDeflateParams & params);
+    bool ReconfigureDeflateContext(StormWebsocketConnectionBase & ws_connection, const StormWebsocketDeflateParams & params);
+    void EnableDeflateContext(StormSocketConnectionId connection_id, StormWebsocketConnectionBase & ws_connection);
+    void ReleaseDeflateContext(StormSocketConnectionId connection_id, StormWebsocketConnectionBase & ws_connection);
+    bool IsCompressible(StormWebsocketMessageWriter & writer);
+    bool CompressShared(StormWebsocketMessageWriter & writer);
+    StormWebsocketMessageWriter GetSharedCompressedWriter(StormWebsocketMessageWriter & writer);
+
+    bool NeedsFragmenting(StormWebsocketMessageWriter & writer);
+    void CreateFragments(StormWebsocketMessageWriter & writer, std::vector<StormMessageWriter> & fragments);
+    bool SendWebsocketMessage(StormWebsocketMessageWriter & writer, StormSocketConnectionId id, StormSocketSendPriority::Index priority, bool blocking);
+    bool SendFrames(StormWebsocketMessageWriter & writer, StormSocketConnectionId id, StormSocketSendPriority::Index priority, bool blocking);
+    int BroadcastFrames(StormWebsocketMessageWriter & writer, const StormSocketConnectionId * ids, int num_ids);
+    bool InflateFrame(StormWebsocketConnectionBase & ws_connection, StormWebsocketMessageReader & reader, void * cur_block, int read_offset, int length, bool fin);
+    bool ValidateTextFrame(StormWebsocketConnectionBase & ws_connection, StormWebsocketMessageReader & reader, bool fin);
+
+    void CleanupWebsocketConnection(StormSocketConnectionId connection_id, StormWebsocketConnectionBase & ws_connection);
   };
 }
@@ -2,6 +2,7 @@
 
 #include "StormSocketConnectionId.h"
 #include "StormMessageWriter.h"
+#include "StormFixedBlockAllocator.h"
 
 namespace StormSockets
 {
@@ -13,6 +14,10 @@ namespace StormSockets
       FreePacket,
       ClearQueue,
       Close,
+      QueuePacketBatch,
+      QueueFile,
+      QueueControl,
+      Flush,
     };
   }
 
@@ -21,6 +26,12 @@ namespace StormSockets
     StormSocketIOOperationType::Index m_Type;
     StormSocketConnectionId m_ConnectionId;
     int m_Size;
+
+    // For batched operations, a chain of blocks holding m_Size connection ids
+    StormFixedBlockHandle m_BatchBlock;
+
+    // For file sends, the chain of pending send blocks to append to the connection
+    StormFixedBlockHandle m_SendBlock;
   };
 
   struct StormSocketFreeQueueElement
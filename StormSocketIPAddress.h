@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+namespace StormSockets
+{
+  struct StormSocketIPAddress
+  {
+    bool m_IsV6 = false;
+    uint32_t m_V4 = 0; // Host byte order, same as RemoteIP
+    uint8_t m_V6[16] = {};
+  };
+
+  inline StormSocketIPAddress StormSocketIPv4Address(uint32_t addr)
+  {
+    StormSocketIPAddress address;
+    address.m_V4 = addr;
+    return address;
+  }
+}
@@ -8,6 +8,10 @@ namespace StormSockets
   {
     StormHttpRequestWriter m_RequestWriter;
     bool m_UseSSL;
+    const char * m_PoolKey = nullptr;
+
+    // Handed back by GetRequestTag on the response, which is how pooled requests that waited for a connection are matched up
+    uint64_t m_RequestTag = 0;
   };
 
   struct StormSocketClientFrontendWebsocketRequestData
@@ -1,5 +1,6 @@
 
 #include "StormSocketServerFrontendHttp.h"
+#include "StormHeaderNames.h"
 
 #include <hash/Hash.h>
 
@@ -11,6 +12,13 @@ namespace StormSockets
     m_SSLData(std::make_unique<StormSocketServerSSLData[]>(kDefaultSSLConfigs)),
     m_HeaderValues()
   {
+    m_KeepAlive = settings.KeepAlive;
+    m_MaxPipelinedRequests = std::min(std::max(settings.MaxPipelinedRequests, 1), kMaxPipelinedRequests);
+    m_IdleTimeout = settings.IdleTimeout;
+    m_Router = settings.Router;
+    m_StreamRequestBodies = settings.StreamRequestBodies;
+    m_MaxPendingBodyChunks = std::max(settings.MaxPendingBodyChunks, 1);
+
     for (int index = 0; index < kDefaultSSLConfigs; ++index)
     {
       m_UseSSL = InitServerSSL(settings.SSLSettings, m_SSLData[index]);
@@ -51,9 +59,215 @@ namespace StormSockets
     writer.FinalizeHeaders(write_content_length);
   }
 
-  void StormSocketServerFrontendHttp::SendResponse(StormSocketConnectionId connection_id, StormHttpResponseWriter & writer)
+  bool StormSocketServerFrontendHttp::SendResponse(StormSocketConnectionId connection_id, StormHttpResponseWriter & writer)
+  {
+    if (m_Backend->ConnectionIdValid(connection_id) == false)
+    {
+      return false;
+    }
+
+    auto & http_connection = GetHttpConnection(GetConnection(connection_id).m_FrontendId);
+    StormLockGuard<StormMutex> lock(http_connection.m_ResponseMutex);
+
+    uint32_t request_index = http_connection.m_NextResponseIndex + (http_connection.m_StreamingResponse ? 1 : 0);
+    while (request_index != http_connection.m_QueuedRequestIndex && http_connection.m_HeldResponses[request_index % kMaxPipelinedRequests])
+    {
+      request_index++;
+    }
+
+    return SendResponseInOrder(connection_id, http_connection, request_index, writer);
+  }
+
+  bool StormSocketServerFrontendHttp::SendResponse(StormHttpRequestReader & request, StormHttpResponseWriter & writer)
+  {
+    if (m_Backend->ConnectionIdValid(request.m_ConnectionId) == false)
+    {
+      return false;
+    }
+
+    auto & http_connection = GetHttpConnection(GetConnection(request.m_ConnectionId).m_FrontendId);
+    StormLockGuard<StormMutex> lock(http_connection.m_ResponseMutex);
+
+    return SendResponseInOrder(request.m_ConnectionId, http_connection, request.m_RequestIndex, writer);
+  }
+
+  bool StormSocketServerFrontendHttp::SendResponseInOrder(StormSocketConnectionId connection_id, StormSocketServerConnectionHttp & http_connection,
+    uint32_t request_index, StormHttpResponseWriter & writer)
   {
+    uint32_t next_index = http_connection.m_NextResponseIndex;
+
+    // Only requests the user has seen and nobody has answered yet, wrapping included
+    if (request_index - next_index >= http_connection.m_QueuedRequestIndex - next_index)
+    {
+      return false;
+    }
+
+    if (request_index != next_index || http_connection.m_StreamingResponse)
+    {
+      auto & held_response = http_connection.m_HeldResponses[request_index % kMaxPipelinedRequests];
+      if (held_response)
+      {
+        return false;
+      }
+
+      // The caller frees its copy as usual, so take a reference for the held one
+      m_Backend->ReferenceOutgoingHttpResponse(writer);
+      held_response = writer;
+      return true;
+    }
+
     m_Backend->SendHttpResponseToConnection(writer, connection_id);
+    SendHeldResponses(connection_id, http_connection, next_index + 1);
+    return true;
+  }
+
+  void StormSocketServerFrontendHttp::SendHeldResponses(StormSocketConnectionId connection_id, StormSocketServerConnectionHttp & http_connection, uint32_t next_index)
+  {
+    while (next_index != http_connection.m_CloseRequestIndex + 1)
+    {
+      auto & held_response = http_connection.m_HeldResponses[next_index % kMaxPipelinedRequests];
+      if (!held_response)
+      {
+        break;
+      }
+
+      m_Backend->SendHttpResponseToConnection(*held_response, connection_id);
+      m_Backend->FreeOutgoingHttpResponse(*held_response);
+      held_response.reset();
+      next_index++;
+    }
+
+    http_connection.m_NextResponseIndex = next_index;
+    http_connection.m_LastActivity = GetTimeMs();
+
+    if (next_index == http_connection.m_CloseRequestIndex + 1)
+    {
+      // The response to the last request goes out ahead of the close
+      ForceDisconnect(connection_id);
+      return;
+    }
+
+    ResumeReading(connection_id, http_connection);
+  }
+
+  bool StormSocketServerFrontendHttp::BeginResponseStream(StormHttpRequestReader & request, StormHttpResponseWriter & writer, int64_t content_length)
+  {
+    if (m_Backend->ConnectionIdValid(request.m_ConnectionId) == false)
+    {
+      return false;
+    }
+
+    auto & http_connection = GetHttpConnection(GetConnection(request.m_ConnectionId).m_FrontendId);
+    StormLockGuard<StormMutex> lock(http_connection.m_ResponseMutex);
+
+    if (http_connection.m_StreamingResponse || request.m_RequestIndex != http_connection.m_NextResponseIndex)
+    {
+      return false;
+    }
+
+    // The buffered part of the body can't already be longer than the whole thing
+    if (content_length >= 0 && writer.GetBodyWriter().GetLength() > content_length)
+    {
+      return false;
+    }
+
+    writer.FinalizeStreamHeaders(content_length, request.m_Http10 == false);
+    m_Backend->SendHttpResponseToConnection(writer, request.m_ConnectionId);
+
+    http_connection.m_StreamingResponse = true;
+    http_connection.m_StreamChunked = writer.IsChunked();
+    http_connection.m_StreamCloseDelimited = writer.IsCloseDelimited();
+    http_connection.m_StreamRemaining = content_length >= 0 ? content_length - writer.GetBodyWriter().GetLength() : 0;
+    http_connection.m_LastActivity = GetTimeMs();
+    return true;
+  }
+
+  bool StormSocketServerFrontendHttp::SendResponseChunk(StormSocketConnectionId connection_id, const void * data, int length)
+  {
+    if (m_Backend->ConnectionIdValid(connection_id) == false)
+    {
+      return false;
+    }
+
+    auto & http_connection = GetHttpConnection(GetConnection(connection_id).m_FrontendId);
+    StormLockGuard<StormMutex> lock(http_connection.m_ResponseMutex);
+
+    bool fixed_length = http_connection.m_StreamChunked == false && http_connection.m_StreamCloseDelimited == false;
+    if (http_connection.m_StreamingResponse == false || (fixed_length && length > http_connection.m_StreamRemaining))
+    {
+      return false;
+    }
+
+    // An empty chunk would end a chunked body
+    if (length <= 0)
+    {
+      return true;
+    }
+
+    StormMessageWriter chunk = m_Backend->CreateWriter();
+    if (http_connection.m_StreamChunked)
+    {
+      StormHttpResponseWriter::WriteChunk(chunk, data, length);
+    }
+    else
+    {
+      chunk.WriteByteBlock(data, 0, length);
+    }
+
+    bool sent = m_Backend->SendPacketToConnection(chunk, connection_id);
+    m_Backend->FreeOutgoingPacket(chunk);
+
+    if (sent)
+    {
+      if (fixed_length)
+      {
+        http_connection.m_StreamRemaining -= length;
+      }
+
+      http_connection.m_LastActivity = GetTimeMs();
+    }
+
+    return sent;
+  }
+
+  void StormSocketServerFrontendHttp::EndResponseStream(StormSocketConnectionId connection_id)
+  {
+    if (m_Backend->ConnectionIdValid(connection_id) == false)
+    {
+      return;
+    }
+
+    auto & http_connection = GetHttpConnection(GetConnection(connection_id).m_FrontendId);
+    StormLockGuard<StormMutex> lock(http_connection.m_ResponseMutex);
+
+    if (http_connection.m_StreamingResponse == false)
+    {
+      return;
+    }
+
+    http_connection.m_StreamingResponse = false;
+
+    if (http_connection.m_StreamChunked)
+    {
+      StormMessageWriter last_chunk = m_Backend->CreateWriter();
+      StormHttpResponseWriter::WriteLastChunk(last_chunk);
+      m_Backend->SendPacketToConnectionBlocking(last_chunk, connection_id);
+      m_Backend->FreeOutgoingPacket(last_chunk);
+    }
+    else if (http_connection.m_StreamCloseDelimited)
+    {
+      // Closing the connection is what ends the body
+      ForceDisconnect(connection_id);
+      return;
+    }
+    else if (http_connection.m_StreamRemaining > 0)
+    {
+      // The client has no other way to tell the body was cut short
+      ForceDisconnect(connection_id);
+      return;
+    }
+
+    SendHeldResponses(connection_id, http_connection, http_connection.m_NextResponseIndex + 1);
   }
 
   void StormSocketServerFrontendHttp::FreeOutgoingResponse(StormHttpResponseWriter & writer)
@@ -65,12 +279,18 @@ namespace StormSockets
   {
     reader.FreeChain();
     m_Backend->DiscardReaderData(reader.m_ConnectionId, reader.m_FullDataLen);
+
+    if (reader.m_BodyChunk && m_Backend->ConnectionIdValid(reader.m_ConnectionId))
+    {
+      auto & http_connection = GetHttpConnection(GetConnection(reader.m_ConnectionId).m_FrontendId);
+      http_connection.m_PendingBodyChunks.fetch_sub(1);
+      ResumeReading(reader.m_ConnectionId, http_connection);
+    }
   }
 
   StormSocketServerConnectionHttp & StormSocketServerFrontendHttp::GetHttpConnection(StormSocketFrontendConnectionId id)
   {
     StormSocketServerConnectionHttp * ptr = (StormSocketServerConnectionHttp *)m_ConnectionAllocator.ResolveHandle(id);
-    new (ptr) StormSocketServerConnectionHttp();
     return *ptr;
   }
 
@@ -82,6 +302,9 @@ namespace StormSockets
       return InvalidFrontendId;
     }
 
+    StormSocketServerConnectionHttp * ptr = (StormSocketServerConnectionHttp *)m_ConnectionAllocator.ResolveHandle(handle);
+    new (ptr) StormSocketServerConnectionHttp();
+
     return handle;
   }
 
@@ -102,7 +325,30 @@ namespace StormSockets
   void StormSocketServerFrontendHttp::CleanupConnection([[maybe_unused]] StormSocketConnectionId connection_id, 
     [[maybe_unused]] StormSocketFrontendConnectionId frontend_id)
   {
-    //auto & http_connection = GetHttpConnection(frontend_id);
+    auto & http_connection = GetHttpConnection(frontend_id);
+
+    // A request that never made it to the user
+    if (http_connection.m_BodyReader)
+    {
+      http_connection.m_BodyReader->FreeChain();
+      http_connection.m_BodyReader.reset();
+    }
+
+    if (http_connection.m_HeaderIndex != InvalidBlockHandle)
+    {
+      m_Allocator.FreeBlock(http_connection.m_HeaderIndex, StormFixedBlockType::Custom);
+      http_connection.m_HeaderIndex = InvalidBlockHandle;
+    }
+
+    StormLockGuard<StormMutex> lock(http_connection.m_ResponseMutex);
+    for (auto & held_response : http_connection.m_HeldResponses)
+    {
+      if (held_response)
+      {
+        m_Backend->FreeOutgoingHttpResponse(*held_response);
+        held_response.reset();
+      }
+    }
   }
 
   bool StormSocketServerFrontendHttp::ProcessData(StormSocketConnectionId connection_id, StormSocketFrontendConnectionId frontend_id)
@@ -126,6 +372,13 @@ namespace StormSockets
         connection.m_ParseBlock = connection.m_RecvBuffer.m_BlockStart;
       }
 
+      // Nothing after a request that closes the connection gets answered
+      if (http_connection.m_StopReading)
+      {
+        m_Backend->DiscardParserData(connection_id, connection.m_UnparsedDataLength);
+        return true;
+      }
+
       if (http_connection.m_State == StormSocketClientConnectionHttpState::ReadingHeaders)
       {
         if (connection.m_UnparsedDataLength == 0)
@@ -133,11 +386,26 @@ namespace StormSockets
           return true;
         }
 
+        http_connection.m_LastActivity = GetTimeMs();
+
+        // Stop reading until the user catches up, sending a response picks it back up
+        if (http_connection.m_NextRequestIndex - http_connection.m_NextResponseIndex >= (uint32_t)m_MaxPipelinedRequests)
+        {
+          PauseReading(connection_id, http_connection);
+          if (http_connection.m_NextRequestIndex - http_connection.m_NextResponseIndex >= (uint32_t)m_MaxPipelinedRequests)
+          {
+            return true;
+          }
+
+          ResumeReading(connection_id, http_connection);
+        }
+
         StormMessageHeaderReader header_reader(&m_Allocator, m_Allocator.ResolveHandle(connection.m_ParseBlock), connection.m_UnparsedDataLength, connection.m_ParseOffset);
 
         int full_data_len = 0;
         bool got_header = false;
-        StormMessageReaderCursor cur_header = header_reader.AdvanceToNextHeader(full_data_len, got_header);
+        int name_length = -1;
+        StormMessageReaderCursor cur_header = header_reader.AdvanceToNextHeader(full_data_len, got_header, name_length);
 
         ProfileScope prof(ProfilerCategory::kProcHeaders);
         while (got_header)
@@ -163,21 +431,49 @@ namespace StormSockets
           }
           else
           {
-            int header_val;
-            int header_val_lowercase;
+            IndexHeader(http_connection, cur_header, name_length);
 
-            m_HeaderValues.ReadInitialVal(cur_header, header_val, header_val_lowercase);
-            if (m_HeaderValues.MatchExact(cur_header, header_val_lowercase, StormHttpHeaderType::ChunkedEncoding))
+            switch (StormClassifyHeaderName(cur_header, name_length))
             {
-              http_connection.m_Chunked = true;
-            }
-            else if (m_HeaderValues.MatchExact(cur_header, header_val_lowercase, StormHttpHeaderType::ContentLength))
+            case StormHeaderName::TransferEncoding:
+              // Framing the body two different ways lets a proxy in front of us split requests differently
+              if (http_connection.m_BodyLength >= 0)
+              {
+                ForceDisconnect(connection_id);
+                return true;
+              }
+
+              http_connection.m_GotTransferEncoding = true;
+              if (m_HeaderValues.FindCSLValue(cur_header, StormHttpHeaderType::Chunked))
+              {
+                http_connection.m_Chunked = true;
+              }
+              break;
+            case StormHeaderName::ContentLength:
             {
-              if (cur_header.ReadNumber(http_connection.m_BodyLength) == false)
+              int64_t body_length;
+              if (http_connection.m_GotTransferEncoding || cur_header.ReadNumber(body_length) == false ||
+                (http_connection.m_BodyLength >= 0 && body_length != http_connection.m_BodyLength))
               {
                 ForceDisconnect(connection_id);
                 return true;
               }
+
+              http_connection.m_BodyLength = body_length;
+              break;
+            }
+            case StormHeaderName::Connection:
+              if (m_HeaderValues.FindCSLValue(cur_header, StormHttpHeaderType::ConnectionClose))
+              {
+                http_connection.m_KeepAlive = false;
+              }
+              else if (m_HeaderValues.FindCSLValue(cur_header, StormHttpHeaderType::ConnectionKeepAlive))
+              {
+                http_connection.m_KeepAlive = m_KeepAlive;
+              }
+              break;
+            default:
+              break;
             }
           }
 
@@ -186,28 +482,37 @@ namespace StormSockets
           if (got_terminator)
           {
             m_Backend->SetHandshakeComplete(connection_id);
+            if (m_IdleTimeout > 0 && http_connection.m_IdleTimerStarted == false)
+            {
+              // Takes over from the handshake timeout
+              m_Backend->StartKeepalive(connection_id, std::max(m_IdleTimeout / 2, 1));
+              http_connection.m_IdleTimerStarted = true;
+            }
+
+            http_connection.m_StreamBody = m_StreamRequestBodies && (http_connection.m_Chunked || http_connection.m_BodyLength > 0);
+
             if (http_connection.m_Chunked)
             {
               http_connection.m_State = StormSocketClientConnectionHttpState::ReadingChunkSize;
             }
+            else if (http_connection.m_BodyLength <= 0)
+            {
+              // Requests without a length don't have a body
+              http_connection.m_State = StormSocketClientConnectionHttpState::Complete;
+            }
+            else if (BodyLengthAllowed(http_connection, http_connection.m_BodyLength) == false)
+            {
+              ForceDisconnect(connection_id);
+              return true;
+            }
             else
             {
-              if (http_connection.m_BodyLength == 0)
-              {
-                if (CompleteBody(connection_id, http_connection) == false)
-                {
-                  return false;
-                }
-              }
-              else
-              {
-                http_connection.m_State = StormSocketClientConnectionHttpState::ReadingBody;
-              }
+              http_connection.m_State = StormSocketClientConnectionHttpState::ReadingBody;
             }
             break;
           }
 
-          cur_header = header_reader.AdvanceToNextHeader(full_data_len, got_header);
+          cur_header = header_reader.AdvanceToNextHeader(full_data_len, got_header, name_length);
         }
 
         if (http_connection.m_State == StormSocketClientConnectionHttpState::ReadingHeaders)
@@ -216,10 +521,34 @@ namespace StormSockets
         }
       }
 
-      return ProcessHttpData(connection, http_connection, connection_id);
+      if (ProcessHttpData(connection, http_connection, connection_id) == false)
+      {
+        // A paused connection is picked back up by the consumer instead of being retried
+        return http_connection.m_ReadPaused;
+      }
+
+      // Go around again for the next pipelined request
+      if (http_connection.m_State != StormSocketClientConnectionHttpState::ReadingHeaders)
+      {
+        return true;
+      }
     }
   }
 
+  bool StormSocketServerFrontendHttp::KeepaliveTick(StormSocketConnectionId connection_id, StormSocketFrontendConnectionId frontend_id)
+  {
+    auto & http_connection = GetHttpConnection(frontend_id);
+
+    int64_t now = GetTimeMs();
+    if (http_connection.m_NextRequestIndex == http_connection.m_NextResponseIndex && now - http_connection.m_LastActivity >= m_IdleTimeout)
+    {
+      ForceDisconnect(connection_id);
+      return false;
+    }
+
+    return true;
+  }
+
   static const uint32_t get_hash = crc32("GET");
   static const uint32_t head_hash = crc32("HEAD");
   static const uint32_t delete_hash = crc32("DELETE");
@@ -286,7 +615,18 @@ namespace StormSockets
     }
 
     m_HeaderValues.ReadInitialVal(request_line, header_val, header_val_lowercase);
-    if (m_HeaderValues.Match(request_line, header_val, StormHttpHeaderType::HttpVer) == false)
+    if (m_HeaderValues.Match(request_line, header_val, StormHttpHeaderType::HttpVer))
+    {
+      http_connection.m_KeepAlive = m_KeepAlive;
+      http_connection.m_Http10 = false;
+    }
+    else if (m_HeaderValues.Match(request_line, header_val, StormHttpHeaderType::HttpVer1))
+    {
+      // HTTP/1.0 only keeps the connection if it asks to
+      http_connection.m_KeepAlive = false;
+      http_connection.m_Http10 = true;
+    }
+    else
     {
       return false;
     }
@@ -306,31 +646,140 @@ namespace StormSockets
     {
       http_connection.m_BodyReader =
         StormHttpRequestReader(chunk_ptr, chunk_len, read_offset, connection_id, &m_Allocator, &m_MessageReaders,
-          *http_connection.m_RequestMethod, *http_connection.m_RequestURI, *http_connection.m_Headers);
+          *http_connection.m_RequestMethod, *http_connection.m_RequestURI, *http_connection.m_Headers, http_connection.m_HeaderIndex);
+      http_connection.m_HeaderIndex = InvalidBlockHandle;
     }
   }
 
   bool StormSocketServerFrontendHttp::CompleteBody(StormSocketConnectionId connection_id, StormHttpConnectionBase & http_connection_base)
   {
     StormSocketServerConnectionHttp & http_connection = (StormSocketServerConnectionHttp &)http_connection_base;
-    auto & connection = GetConnection(connection_id);
 
-    if (http_connection.m_BodyReader)
+    if (http_connection.m_StreamBody)
     {
-      http_connection.m_BodyReader->FinalizeFullDataLength(http_connection.m_TotalLength);
+      if (StreamBodyData(connection_id, http_connection, nullptr, 0, 0, true) == false)
+      {
+        return false;
+      }
+
+      FinishRequest(http_connection);
+      return true;
     }
-    else
+
+    if (!http_connection.m_BodyReader)
     {
       http_connection.m_BodyReader =
         StormHttpRequestReader(nullptr, 0, 0, connection_id, &m_Allocator, &m_MessageReaders,
-          *http_connection.m_RequestMethod, *http_connection.m_RequestURI, *http_connection.m_Headers);
+          *http_connection.m_RequestMethod, *http_connection.m_RequestURI, *http_connection.m_Headers, http_connection.m_HeaderIndex);
+      http_connection.m_HeaderIndex = InvalidBlockHandle;
+    }
+
+    // Freeing the request releases everything it was parsed from, headers included
+    http_connection.m_BodyReader->FinalizeFullDataLength(http_connection.m_TotalLength);
+    http_connection.m_BodyReader->m_RequestIndex = http_connection.m_NextRequestIndex;
+    http_connection.m_BodyReader->m_Http10 = http_connection.m_Http10;
+
+    StormHttpRequestReader request = *http_connection.m_BodyReader;
+    StormHttpRouteParams route_params;
+    const StormHttpRouteHandler * route_handler = nullptr;
+
+    if (m_Router && m_Router->HasIOThreadRoutes())
+    {
+      route_handler = m_Router->FindRoute(request, StormHttpRouteDispatch::IOThread, route_params);
+    }
+
+    // The user can answer as soon as the event is queued, so the request has to be answerable before then
+    MarkRequestQueued(http_connection);
+
+    if (route_handler == nullptr && QueueRequestEvent(connection_id, request, StormSocketEventType::Data) == false)
+    {
+      return false;
+    }
+
+    FinishRequest(http_connection);
+
+    // Run last so the connection is ready for the next request if the handler responds right away
+    if (route_handler)
+    {
+      (*route_handler)(request, route_params);
+      FreeIncomingRequest(request);
     }
 
+    return true;
+  }
+
+  bool StormSocketServerFrontendHttp::StreamBodyData(StormSocketConnectionId connection_id, StormHttpConnectionBase & http_connection_base,
+    void * chunk_ptr, int chunk_len, int read_offset, bool last_chunk)
+  {
+    StormSocketServerConnectionHttp & http_connection = (StormSocketServerConnectionHttp &)http_connection_base;
+
+    if (http_connection.m_BodyStreamStarted == false)
+    {
+      StormHttpRequestReader request(nullptr, 0, 0, connection_id, &m_Allocator, &m_MessageReaders,
+        *http_connection.m_RequestMethod, *http_connection.m_RequestURI, *http_connection.m_Headers, http_connection.m_HeaderIndex);
+      request.FinalizeFullDataLength(http_connection.m_TotalLength);
+      request.m_RequestIndex = http_connection.m_NextRequestIndex;
+      request.m_StreamedBody = true;
+      request.m_Http10 = http_connection.m_Http10;
+
+      MarkRequestQueued(http_connection);
+      if (QueueRequestEvent(connection_id, request, StormSocketEventType::Data) == false)
+      {
+        request.m_HeaderIndex = InvalidBlockHandle;
+        request.FreeChain();
+        return false;
+      }
+
+      http_connection.m_HeaderIndex = InvalidBlockHandle;
+      http_connection.m_BodyStreamStarted = true;
+      http_connection.m_TotalLength = 0;
+    }
+
+    if (chunk_len == 0 && last_chunk == false)
+    {
+      return true;
+    }
+
+    // The consumer is behind, stop reading until it frees some chunks
+    if (http_connection.m_PendingBodyChunks >= m_MaxPendingBodyChunks)
+    {
+      PauseReading(connection_id, http_connection);
+      if (http_connection.m_PendingBodyChunks >= m_MaxPendingBodyChunks)
+      {
+        return false;
+      }
+
+      ResumeReading(connection_id, http_connection);
+    }
+
+    StormHttpRequestReader chunk(chunk_ptr, chunk_len, read_offset, connection_id, &m_Allocator, &m_MessageReaders,
+      *http_connection.m_RequestMethod, *http_connection.m_RequestURI, *http_connection.m_Headers);
+    chunk.FinalizeFullDataLength(http_connection.m_TotalLength + chunk_len);
+    chunk.m_RequestIndex = http_connection.m_NextRequestIndex;
+    chunk.m_StreamedBody = true;
+    chunk.m_BodyChunk = true;
+    chunk.m_LastChunk = last_chunk;
+
+    if (QueueRequestEvent(connection_id, chunk, StormSocketEventType::BodyChunk) == false)
+    {
+      chunk.FreeChain();
+      return false;
+    }
+
+    http_connection.m_PendingBodyChunks.fetch_add(1);
+    return true;
+  }
+
+  bool StormSocketServerFrontendHttp::QueueRequestEvent(StormSocketConnectionId connection_id, StormHttpRequestReader & request, StormSocketEventType::Index type)
+  {
+    auto & connection = GetConnection(connection_id);
+
     StormSocketEventInfo data_message;
     data_message.ConnectionId = connection_id;
-    data_message.GetHttpRequestReader() = *http_connection.m_BodyReader;
-    data_message.Type = StormSocketEventType::Data;
+    data_message.GetHttpRequestReader() = request;
+    data_message.Type = type;
     data_message.RemoteIP = connection.m_RemoteIP;
+    data_message.RemoteAddress = connection.m_RemoteAddress;
     data_message.RemotePort = connection.m_RemotePort;
 
     if (m_EventQueue.Enqueue(data_message) == false)
@@ -343,10 +792,91 @@ namespace StormSockets
       m_EventSemaphore->Release();
     }
 
-    http_connection.m_CompleteRequest = true;
     return true;
   }
 
+  void StormSocketServerFrontendHttp::MarkRequestQueued(StormSocketServerConnectionHttp & http_connection)
+  {
+    StormLockGuard<StormMutex> lock(http_connection.m_ResponseMutex);
+    http_connection.m_QueuedRequestIndex = http_connection.m_NextRequestIndex + 1;
+
+    if (http_connection.m_KeepAlive == false)
+    {
+      http_connection.m_CloseRequestIndex = http_connection.m_NextRequestIndex;
+    }
+  }
+
+  void StormSocketServerFrontendHttp::FinishRequest(StormSocketServerConnectionHttp & http_connection)
+  {
+    http_connection.m_CompleteRequest = true;
+
+    if (http_connection.m_KeepAlive == false)
+    {
+      http_connection.m_StopReading = true;
+    }
+
+    http_connection.m_NextRequestIndex++;
+    ResetRequest(http_connection);
+  }
+
+  void StormSocketServerFrontendHttp::PauseReading(StormSocketConnectionId connection_id, StormSocketServerConnectionHttp & http_connection)
+  {
+    // Set before the caller checks its limit again, so a resume in between isn't missed
+    http_connection.m_ReadPaused = true;
+    m_Backend->PauseReceive(connection_id);
+  }
+
+  void StormSocketServerFrontendHttp::ResumeReading(StormSocketConnectionId connection_id, StormSocketServerConnectionHttp & http_connection)
+  {
+    if (http_connection.m_ReadPaused.exchange(false))
+    {
+      m_Backend->ResumeReceive(connection_id);
+    }
+  }
+
+  void StormSocketServerFrontendHttp::IndexHeader(StormSocketServerConnectionHttp & http_connection, const StormMessageReaderCursor & header, int name_length)
+  {
+    if (http_connection.m_HeaderIndex == InvalidBlockHandle)
+    {
+      if (m_Allocator.GetBlockSize() < (int)sizeof(StormHttpHeaderIndex))
+      {
+        return;
+      }
+
+      http_connection.m_HeaderIndex = m_Allocator.AllocateBlock(StormFixedBlockType::Custom);
+      if (http_connection.m_HeaderIndex == InvalidBlockHandle)
+      {
+        return;
+      }
+
+      ((StormHttpHeaderIndex *)m_Allocator.ResolveHandle(http_connection.m_HeaderIndex))->Init();
+    }
+
+    StormHttpHeaderIndex * index = (StormHttpHeaderIndex *)m_Allocator.ResolveHandle(http_connection.m_HeaderIndex);
+    index->AddHeader(header, name_length);
+  }
+
+  void StormSocketServerFrontendHttp::ResetRequest(StormSocketServerConnectionHttp & http_connection)
+  {
+    http_connection.m_State = StormSocketClientConnectionHttpState::ReadingHeaders;
+    http_connection.m_Chunked = false;
+    http_connection.m_StreamBody = false;
+    http_connection.m_BodyStreamStarted = false;
+    http_connection.m_BodyReceived = 0;
+    http_connection.m_TotalLength = 0;
+    http_connection.m_BodyLength = -1;
+    http_connection.m_ChunkSize = 0;
+    http_connection.m_RecievedLength = 0;
+    http_connection.m_Headers.reset();
+
+    http_connection.m_GotRequestLine = false;
+    http_connection.m_Http10 = false;
+    http_connection.m_GotTransferEncoding = false;
+    http_connection.m_RequestMethod.reset();
+    http_connection.m_RequestURI.reset();
+    http_connection.m_BodyReader.reset();
+  }
+
 
   void StormSocketServerFrontendHttp::SendClosePacket([[maybe_unused]] StormSocketConnectionId connection_id, 
     [[maybe_unused]] StormSocketFrontendConnectionId frontend_id)
@@ -19,6 +19,15 @@ namespace StormSockets
 
     StormHttpHeaderValues m_HeaderValues;
 
+    bool m_KeepAlive;
+    int m_MaxPipelinedRequests;
+    int m_IdleTimeout;
+
+    StormHttpRouter * m_Router;
+
+    bool m_StreamRequestBodies;
+    int m_MaxPendingBodyChunks;
+
   public:
 
     StormSocketServerFrontendHttp(const StormSocketServerFrontendHttpSettings & settings, StormSocketBackend * backend);
@@ -31,7 +40,23 @@ namespace StormSockets
 
     StormHttpResponseWriter CreateOutgoingResponse(int response_code, const char * response_phrase);
     void FinalizeOutgoingResponse(StormHttpResponseWriter & writer, bool write_content_length);
-    void SendResponse(StormSocketConnectionId connection_id, StormHttpResponseWriter & writer);
+    // Answers the oldest request on the connection that doesn't have a response yet.  Fails if every request has one
+    bool SendResponse(StormSocketConnectionId connection_id, StormHttpResponseWriter & writer);
+
+    // Answers a specific request, the response is held back until every earlier request on the connection has been answered.
+    // Fails if the request was already answered
+    bool SendResponse(StormHttpRequestReader & request, StormHttpResponseWriter & writer);
+
+    // Sends the headers right away and leaves the response open for SendResponseChunk until EndResponseStream.  Only the oldest
+    // request without a response can be streamed.  A negative content_length streams with chunked encoding, which also suits
+    // long lived responses like server-sent events.  HTTP/1.0 clients get a body that ends when the connection closes instead.
+    // Fails if the writer already holds more body than content_length.  The writer is finalized here and freed by the caller as usual
+    bool BeginResponseStream(StormHttpRequestReader & request, StormHttpResponseWriter & writer, int64_t content_length = -1);
+
+    // Returns false if the connection's send queue is full, or the data would run past the content length
+    bool SendResponseChunk(StormSocketConnectionId connection_id, const void * data, int length);
+    void EndResponseStream(StormSocketConnectionId connection_id);
+
     void FreeOutgoingResponse(StormHttpResponseWriter & writer);
     void FreeIncomingRequest(StormHttpRequestReader & reader);
 
@@ -46,9 +71,21 @@ namespace StormSockets
     void CleanupConnection(StormSocketConnectionId connection_id, StormSocketFrontendConnectionId frontend_id);
     bool ProcessData(StormSocketConnectionId connection_id, StormSocketFrontendConnectionId frontend_id);
     bool ParseRequestLine(StormMessageReaderCursor & request_line, StormSocketServerConnectionHttp & http_connection);
+    void ResetRequest(StormSocketServerConnectionHttp & http_connection);
+    void IndexHeader(StormSocketServerConnectionHttp & http_connection, const StormMessageReaderCursor & header, int name_length);
+    bool SendResponseInOrder(StormSocketConnectionId connection_id, StormSocketServerConnectionHttp & http_connection,
+      uint32_t request_index, StormHttpResponseWriter & writer);
+    void SendHeldResponses(StormSocketConnectionId connection_id, StormSocketServerConnectionHttp & http_connection, uint32_t next_index);
+    bool KeepaliveTick(StormSocketConnectionId connection_id, StormSocketFrontendConnectionId frontend_id) override;
 
     void AddBodyBlock(StormSocketConnectionId connection_id, StormHttpConnectionBase & http_connection, void * chunk_ptr, int chunk_len, int read_offset);
     bool CompleteBody(StormSocketConnectionId connection_id, StormHttpConnectionBase & http_connection);
+    bool StreamBodyData(StormSocketConnectionId connection_id, StormHttpConnectionBase & http_connection, void * chunk_ptr, int chunk_len, int read_offset, bool last_chunk);
+    bool QueueRequestEvent(StormSocketConnectionId connection_id, StormHttpRequestReader & request, StormSocketEventType::Index type);
+    void MarkRequestQueued(StormSocketServerConnectionHttp & http_connection);
+    void FinishRequest(StormSocketServerConnectionHttp & http_connection);
+    void PauseReading(StormSocketConnectionId connection_id, StormSocketServerConnectionHttp & http_connection);
+    void ResumeReading(StormSocketConnectionId connection_id, StormSocketServerConnectionHttp & http_connection);
 
     void SendClosePacket(StormSocketConnectionId connection_id, StormSocketFrontendConnectionId frontend_id);
     void ConnectionEstablishComplete([[maybe_unused]] StormSocketConnectionId connection_id, [[maybe_unused]] StormSocketFrontendConnectionId frontend_id) { }
@@ -1,5 +1,6 @@
 
 #include "StormSocketServerFrontendWebsocket.h"
+#include "StormHeaderNames.h"
 
 namespace StormSockets
 {
@@ -87,13 +88,13 @@ namespace StormSockets
     [[maybe_unused]] StormSocketFrontendConnectionId frontend_id)
   {
     auto & ws_connection = GetWSConnection(frontend_id);
-    StormSocketFrontendWebsocketBase::CleanupWebsocketConnection(ws_connection);
+    StormSocketFrontendWebsocketBase::CleanupWebsocketConnection(connection_id, ws_connection);
 
     if (ws_connection.m_State == StormSocketServerConnectionWebsocketState::HandShake ||
         ws_connection.m_State == StormSocketServerConnectionWebsocketState::SendHandshakeResponse ||
         ws_connection.m_State == StormSocketServerConnectionWebsocketState::SendPong)
     {
-      FreeOutgoingPacket(ws_connection.m_PendingWriter);
+      m_Backend->FreeOutgoingPacket(ws_connection.m_PendingWriter);
     }
   }
 
@@ -124,7 +125,8 @@ namespace StormSockets
 
         int full_data_len = 0;
         bool got_header = false;
-        StormMessageReaderCursor cur_header = header_reader.AdvanceToNextHeader(full_data_len, got_header);
+        int name_length = -1;
+        StormMessageReaderCursor cur_header = header_reader.AdvanceToNextHeader(full_data_len, got_header, name_length);
 
         if (!got_header)
         {
@@ -138,7 +140,7 @@ namespace StormSockets
           {
             ws_connection.m_GotHeaderTerminator = true;
           }
-          else
+          else if (name_length < 0)
           {
             int header_val;
             int header_val_lowercase;
@@ -150,34 +152,53 @@ namespace StormSockets
             {
               ws_connection.m_GotGetHeader = true;
             }
-            else if (ws_connection.m_GotWebsocketHeader == false &&
-              m_HeaderValues.MatchExact(cur_header, header_val_lowercase, StormWebsocketHeaderType::WebsocketHeader))
-            {
-              ws_connection.m_GotWebsocketHeader = true;
-            }
-            else if (ws_connection.m_GotConnectionUpgradeHeader == false &&
-              m_HeaderValues.Match(cur_header, header_val_lowercase, StormWebsocketHeaderType::ConnectionUpdgradeHeader))
+          }
+          else
+          {
+            switch (StormClassifyHeaderName(cur_header, name_length))
             {
+            case StormHeaderName::Upgrade:
+              if (m_HeaderValues.FindCSLValue(cur_header, StormWebsocketHeaderType::UpgradeWebsocket))
+              {
+                ws_connection.m_GotWebsocketHeader = true;
+              }
+              break;
+            case StormHeaderName::Connection:
               if (m_HeaderValues.FindCSLValue(cur_header, StormWebsocketHeaderType::UpdgradePart))
               {
                 ws_connection.m_GotConnectionUpgradeHeader = true;
               }
-            }
-            else if (ws_connection.m_GotWebsocketVerHeader == false &&
-              m_HeaderValues.MatchExact(cur_header, header_val_lowercase, StormWebsocketHeaderType::WebsocketVerHeader))
-            {
-              ws_connection.m_GotWebsocketVerHeader = true;
-            }
-            else if (m_HasProtocol && ws_connection.m_GotWebsocketProtoHeader == false &&
-              m_HeaderValues.Match(cur_header, header_val_lowercase, StormWebsocketHeaderType::WebsocketProtoHeader))
-            {
-              ws_connection.m_GotWebsocketProtoHeader = true;
-            }
-            else if (ws_connection.m_GotWebsocketKeyHeader == false &&
-              m_HeaderValues.Match(cur_header, header_val_lowercase, StormWebsocketHeaderType::WebsocketKeyHeader))
-            {
-              StormSha1::CalcHash(cur_header, ws_connection.m_PendingWriter);
-              ws_connection.m_GotWebsocketKeyHeader = true;
+              break;
+            case StormHeaderName::SecWebsocketVersion:
+              {
+                int version;
+                if (cur_header.ReadNumber(version) && version == 13)
+                {
+                  ws_connection.m_GotWebsocketVerHeader = true;
+                }
+              }
+              break;
+            case StormHeaderName::SecWebsocketProtocol:
+              if (m_HasProtocol && m_HeaderValues.FindCSLValue(cur_header, StormWebsocketHeaderType::Protocol))
+              {
+                ws_connection.m_GotWebsocketProtoHeader = true;
+              }
+              break;
+            case StormHeaderName::SecWebsocketKey:
+              if (ws_connection.m_GotWebsocketKeyHeader == false)
+              {
+                StormSha1::CalcHash(cur_header, ws_connection.m_PendingWriter);
+                ws_connection.m_GotWebsocketKeyHeader = true;
+              }
+              break;
+            case StormHeaderName::SecWebsocketExtensions:
+              if (m_UsePerMessageDeflate)
+              {
+                StormWebsocketDeflateReadHeader(cur_header, ws_connection.m_ExtensionHeader);
+              }
+              break;
+            default:
+              break;
             }
           }
 
@@ -194,10 +215,25 @@ namespace StormSockets
               ws_connection.m_GotWebsocketKeyHeader &&
               (m_HasProtocol == false || ws_connection.m_GotWebsocketProtoHeader))
             {
+              StormWebsocketDeflateParams deflate_params;
+              std::string deflate_response;
+
+              if (ws_connection.m_ExtensionHeader.size() > 0 &&
+                StormWebsocketDeflateAcceptOffer(ws_connection.m_ExtensionHeader, m_DeflateSettings, deflate_params, deflate_response) &&
+                AllocateDeflateContext(ws_connection, deflate_params))
+              {
+                ws_connection.m_PendingWriter.WriteString("\r\nSec-WebSocket-Extensions: ");
+                ws_connection.m_PendingWriter.WriteString(deflate_response.c_str());
+                EnableDeflateContext(connection_id, ws_connection);
+              }
+
+              ws_connection.m_ExtensionHeader.clear();
+
               m_HeaderValues.WriteHeader(ws_connection.m_PendingWriter, StormWebsocketHeaderType::ResponseTerminator);
               ws_connection.m_State = StormSocketServerConnectionWebsocketState::SendHandshakeResponse;
 
               m_Backend->SetHandshakeComplete(connection_id);
+              StartKeepalive(connection_id);
             }
             else
             {
@@ -214,7 +250,7 @@ namespace StormSockets
             break;
           }
 
-          cur_header = header_reader.AdvanceToNextHeader(full_data_len, got_header);
+          cur_header = header_reader.AdvanceToNextHeader(full_data_len, got_header, name_length);
         }
 
         if (ws_connection.m_State == StormSocketServerConnectionWebsocketState::HandShake)
@@ -239,10 +275,18 @@ namespace StormSockets
   }
 
   void StormSocketServerFrontendWebsocket::SendClosePacket(StormSocketConnectionId connection_id, 
-    [[maybe_unused]] StormSocketFrontendConnectionId frontend_id)
+    StormSocketFrontendConnectionId frontend_id)
   {
     // Send a disconnect packet
     StormWebsocketMessageWriter disconnect_writer = CreateOutgoingPacket(StormWebsocketOp::Close, true);
+
+    auto & ws_connection = GetWSConnection(frontend_id);
+    if (ws_connection.m_CloseCode != 0)
+    {
+      disconnect_writer.WriteByte((uint8_t)(ws_connection.m_CloseCode >> 8));
+      disconnect_writer.WriteByte((uint8_t)ws_connection.m_CloseCode);
+    }
+
     disconnect_writer.CreateHeaderAndApplyMask((int)StormWebsocketOp::Close, true, 0);
     SendPacketToConnection(disconnect_writer, connection_id);
     FreeOutgoingPacket(disconnect_writer);
@@ -4,7 +4,10 @@
 #include "StormWebsocketMessageReader.h"
 #include "StormHttpResponseReader.h"
 #include "StormHttpRequestReader.h"
+#include "StormHttpRouter.h"
 #include "StormSemaphore.h"
+#include "StormDnsCache.h"
+#include "StormSocketIPAddress.h"
 
 #include <thread>
 #include <algorithm>
@@ -19,6 +22,7 @@ namespace StormSockets
       ClientHandShakeCompleted,
       Disconnected,
       Data,
+      BodyChunk,
     };
   }
 
@@ -32,13 +36,35 @@ namespace StormSockets
     };
   }
 
+  namespace StormSocketUtf8ValidationMode
+  {
+    enum Index
+    {
+      Off,
+      Validate,
+      ValidateAndClose,
+    };
+  }
+
+  namespace StormSocketSendPriority
+  {
+    enum Index
+    {
+      High,
+      Normal,
+      Bulk,
+      Count,
+    };
+  }
+
   struct StormSocketEventInfo
   {
     StormSocketEventType::Index Type;
     StormSocketConnectionId ConnectionId;
 
-    uint32_t RemoteIP;
+    uint32_t RemoteIP; // Zero for IPv6 peers, RemoteAddress has the full address
     uint16_t RemotePort;
+    StormSocketIPAddress RemoteAddress;
 
     StormWebsocketMessageReader & GetWebsocketReader() { return *((StormWebsocketMessageReader *)ReaderBuffer); }
     StormHttpResponseReader & GetHttpResponseReader() { return *((StormHttpResponseReader *)ReaderBuffer); }
@@ -67,8 +93,29 @@ namespace StormSockets
     int MaxPendingIncomingPacketsPerConnection = 32;
     int MaxSendQueueElements = 32;
     int MaxPendingSendBlocks = 1024 * 16;
+    int MaxFileBlocksInFlight = 16; // Upper bound on how much of a file body is in flight per connection, in blocks
+
+    // Outgoing packets wait in one queue per StormSocketSendPriority until the connection has fewer than MaxStagedPacketsPerConnection
+    // packets ahead of the socket.  Lanes are picked by weighted round robin, each lane getting its weight in packets per round.
+    // MaxPendingOutgoingPacketsPerConnection is the size of each lane's queue, and since packets only leave it once they're staged,
+    // a send fails when its lane has that many packets waiting behind the staged ones.  While a message split over several packets
+    // is partly staged, only its lane and standalone control frames on the High lane are taken from
+    int SendPriorityWeights[StormSocketSendPriority::Count] = { 8, 4, 1 };
+    int MaxStagedPacketsPerConnection = 8;
     int HandshakeTimeout = 0;
     bool LoadSystemCertificates = false;
+
+#ifndef _INCLUDEOS
+    // Resolved hostnames are cached for DnsCacheTTL seconds and failed lookups for DnsNegativeCacheTTL.  ResolveFunc replaces
+    // the system resolver and can report its own TTL per lookup
+    int DnsCacheTTL = 60;
+    int DnsNegativeCacheTTL = 5;
+    StormDnsResolveFunc ResolveFunc;
+
+    // When a host resolves to several addresses, a new connection attempt starts every ConnectAttemptDelay milliseconds
+    // (or as soon as one fails) alternating IPv6 and IPv4, and the first to connect wins
+    int ConnectAttemptDelay = 250;
+#endif
   };
 
   struct StormSocketServerSSLSettings
@@ -80,7 +127,7 @@ namespace StormSockets
   struct StormSocketListenData
   {
     uint16_t Port = 9001;
-    const char * LocalInterface = "0.0.0.0";
+    const char * LocalInterface = "0.0.0.0"; // "::" listens on both IPv6 and IPv4
   };
 
   struct StormSocketFrontendSettings
@@ -88,6 +135,11 @@ namespace StormSockets
     int MessageQueueSize = 128;
     int MaxConnections = 256;
 
+    // Hold small writes for up to CoalesceWindow microseconds, or until CoalesceBytes are waiting, so that they go out in one send.
+    // Flush sends whatever is being held right away.  Batches are limited by MaxStagedPacketsPerConnection.  0 disables
+    int CoalesceWindow = 0;
+    int CoalesceBytes = 16 * 1024;
+
     StormSemaphore * EventSemaphore = nullptr;
   };
 
@@ -98,16 +150,61 @@ namespace StormSockets
 
     int MaxHeaderSize = 8092;
     int MaxPacketSize = 0;
+
+    // Incoming messages up to this size can be read as a single contiguous span with GetContiguousPayload
+    int MaxContiguousPayloadSize = 0;
+
+    // Validate uses IsUtf8Valid on the reader to flag bad text messages, ValidateAndClose drops the connection instead
+    StormSocketUtf8ValidationMode::Index Utf8Validation = StormSocketUtf8ValidationMode::Off;
+
+    // Leave incoming data frames masked until they're read, so that ReadPayload can unmask, validate and copy them in one pass.
+    // Text is still validated on the IO thread with ValidateAndClose, or when fragments aren't combined
+    bool DeferUnmask = false;
+
+    // Send a ping every KeepaliveInterval milliseconds once the handshake is done, and drop the connection if the matching pong
+    // doesn't come back within KeepaliveTimeout milliseconds (checked on each interval, 0 uses the interval).  0 disables
+    int KeepaliveInterval = 0;
+    int KeepaliveTimeout = 0;
+
+    // Uncompressed data frames with a payload larger than this are delivered in chunks as the data arrives instead of being
+    // buffered whole, and aren't subject to MaxPacketSize.  Chunks look like fragments with DeliverImmediately: the first has the
+    // frame's type, the rest are Continuation, and the last one of a final frame is final.  0 disables
+    int StreamingThreshold = 0;
+
+    // Outgoing messages with a larger payload are split into frames of at most this size as they're sent, so that control frames
+    // and other connections' traffic can go out between them.  Like manual fragmentation, only one thread should send to a given
+    // connection at a time while this is on.  0 disables
+    int MaxFrameSize = 0;
+
+    // permessage-deflate (RFC 7692), ignored when built with DISABLE_ZLIB
+    bool UsePerMessageDeflate = false;
+    bool DeflateLocalNoContextTakeover = false;
+    bool DeflateRemoteNoContextTakeover = false;
+    int DeflateMaxWindowBits = 15;
+    int DeflateMemLevel = 8;
+    int DeflateMaxContexts = 0; // Connections past this limit don't negotiate compression, 0 uses MaxConnections
+    int DeflateMinMessageSize = 64;
+
+    // Compressed messages that inflate to more than this are dropped with close code 1009, 0 for no limit
+    int DeflateMaxMessageSize = 16 * 1024 * 1024;
   };
 
   struct StormSocketFrontendHttpSettings : public StormSocketFrontendSettings
   {
-
+    // Connections sending a larger body are dropped, 0 for no limit.  Bodies that aren't streamed are also limited to 2 GB
+    int64_t MaxBodySize = 0;
   };
 
   struct StormSocketClientFrontendHttpSettings : public StormSocketFrontendHttpSettings
   {
-
+    // Requests to the same host and port reuse kept-alive connections when MaxConnectionsPerHost is non zero.  Once a host
+    // has that many connections, new requests wait in a queue for that host and go out on the first connection to free up,
+    // or on a new one if a connection closes.  RequestConnect returns InvalidConnectionId for those, so they're matched to
+    // their responses with m_RequestTag.  Idle connections past MaxIdleConnectionsPerHost are closed, as are connections idle
+    // for PoolIdleTimeout milliseconds
+    int MaxConnectionsPerHost = 0;
+    int MaxIdleConnectionsPerHost = 4;
+    int PoolIdleTimeout = 30000;
   };
 
   struct StormSocketClientFrontendWebsocketSettings : public StormSocketFrontendWebsocketSettings
@@ -127,6 +224,23 @@ namespace StormSockets
   {
     StormSocketServerSSLSettings SSLSettings;
     StormSocketListenData ListenSettings;
+
+    // Keep connections open between requests unless the client sends "Connection: close" (or is HTTP/1.0 without keep-alive).
+    // Pipelined requests are delivered as they're parsed and their responses go out in request order.  Reading stops while
+    // MaxPipelinedRequests requests are waiting on a response.  Idle connections are closed after IdleTimeout milliseconds, 0 never
+    bool KeepAlive = true;
+    int MaxPipelinedRequests = 8;
+    int IdleTimeout = 0;
+
+    // Requests matching one of the router's IOThread routes go straight to their handler instead of the event queue.
+    // The router isn't owned by the frontend and has to outlive it
+    StormHttpRouter * Router = nullptr;
+
+    // Streamed requests are delivered as a Data event as soon as their headers are parsed, followed by BodyChunk events as the
+    // body arrives, the last one marked with IsLastChunk.  Reading stops while MaxPendingBodyChunks chunks haven't been freed.
+    // Free the request and its chunks in the order they arrive.  Streamed requests always go through the event queue
+    bool StreamRequestBodies = false;
+    int MaxPendingBodyChunks = 8;
   };
 }
 
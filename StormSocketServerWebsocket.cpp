@@ -66,16 +66,24 @@ namespace StormSockets
     return server->FinalizeOutgoingPacket(writer);
   }
 
-  bool StormSocketServerWebsocket::SendPacketToConnection(StormWebsocketMessageWriter & writer, StormSocketConnectionId id)
+  bool StormSocketServerWebsocket::SendPacketToConnection(StormWebsocketMessageWriter & writer, StormSocketConnectionId id,
+    StormSocketSendPriority::Index priority)
   {
     FrontendType * server = (FrontendType *)m_Frontend;
-    return server->SendPacketToConnection(writer, id);
+    return server->SendPacketToConnection(writer, id, priority);
   }
 
-  void StormSocketServerWebsocket::SendPacketToConnectionBlocking(StormWebsocketMessageWriter & writer, StormSocketConnectionId id)
+  void StormSocketServerWebsocket::SendPacketToConnectionBlocking(StormWebsocketMessageWriter & writer, StormSocketConnectionId id,
+    StormSocketSendPriority::Index priority)
   {
     FrontendType * server = (FrontendType *)m_Frontend;
-    return server->SendPacketToConnectionBlocking(writer, id);
+    return server->SendPacketToConnectionBlocking(writer, id, priority);
+  }
+
+  void StormSocketServerWebsocket::Flush(StormSocketConnectionId id)
+  {
+    FrontendType * server = (FrontendType *)m_Frontend;
+    server->Flush(id);
   }
 
   void StormSocketServerWebsocket::FreeOutgoingPacket(StormWebsocketMessageWriter & writer)
@@ -24,8 +24,12 @@ namespace StormSockets
     StormWebsocketMessageWriter CreateOutgoingPacket(StormSocketWebsocketDataType::Index type, bool final);
     void FinalizeOutgoingPacket(StormWebsocketMessageWriter & writer);
 
-    bool SendPacketToConnection(StormWebsocketMessageWriter & writer, StormSocketConnectionId id);
-    void SendPacketToConnectionBlocking(StormWebsocketMessageWriter & writer, StormSocketConnectionId id);
+    bool SendPacketToConnection(StormWebsocketMessageWriter & writer, StormSocketConnectionId id,
+      StormSocketSendPriority::Index priority = StormSocketSendPriority::Normal);
+    void SendPacketToConnectionBlocking(StormWebsocketMessageWriter & writer, StormSocketConnectionId id,
+      StormSocketSendPriority::Index priority = StormSocketSendPriority::Normal);
+
+    void Flush(StormSocketConnectionId id);
 
     void FreeOutgoingPacket(StormWebsocketMessageWriter & writer);
     void FreeIncomingPacket(StormWebsocketMessageReader & reader);
@@ -0,0 +1,144 @@
+
+#include "StormUtf8Validator.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define STORM_UTF8_X64
+#include <emmintrin.h>
+#endif
+
+namespace StormSockets
+{
+  // Skips the leading run of ASCII bytes, 16 at a time when SSE2 is available
+  static int StormUtf8SkipAscii(const uint8_t * data, int length)
+  {
+    int offset = 0;
+
+#ifdef STORM_UTF8_X64
+    while (offset + 16 <= length)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i *)(data + offset));
+      int high_bits = _mm_movemask_epi8(v);
+      if (high_bits != 0)
+      {
+        for (int bit = 0; bit < 16; ++bit)
+        {
+          if (high_bits & (1 << bit))
+          {
+            return offset + bit;
+          }
+        }
+      }
+
+      offset += 16;
+    }
+#else
+    while (offset + 8 <= length)
+    {
+      uint64_t v;
+      memcpy(&v, data + offset, sizeof(v));
+      if ((v & 0x8080808080808080ULL) != 0)
+      {
+        break;
+      }
+
+      offset += 8;
+    }
+#endif
+
+    while (offset < length && data[offset] < 0x80)
+    {
+      offset++;
+    }
+
+    return offset;
+  }
+
+  bool StormUtf8Validate(const void * data, int length, StormUtf8ValidatorState & state)
+  {
+    if (state.m_Failed)
+    {
+      return false;
+    }
+
+    const uint8_t * ptr = (const uint8_t *)data;
+    int offset = 0;
+
+    int remaining = state.m_Remaining;
+    uint8_t lower = state.m_Lower;
+    uint8_t upper = state.m_Upper;
+
+    while (offset < length)
+    {
+      if (remaining == 0)
+      {
+        offset += StormUtf8SkipAscii(ptr + offset, length - offset);
+        if (offset == length)
+        {
+          break;
+        }
+
+        uint8_t b = ptr[offset++];
+        lower = 0x80;
+        upper = 0xBF;
+
+        if (b >= 0xC2 && b <= 0xDF)
+        {
+          remaining = 1;
+        }
+        else if (b >= 0xE0 && b <= 0xEF)
+        {
+          remaining = 2;
+
+          // Overlong encodings and UTF-16 surrogates
+          if (b == 0xE0)
+          {
+            lower = 0xA0;
+          }
+          else if (b == 0xED)
+          {
+            upper = 0x9F;
+          }
+        }
+        else if (b >= 0xF0 && b <= 0xF4)
+        {
+          remaining = 3;
+
+          // Overlong encodings and code points above U+10FFFF
+          if (b == 0xF0)
+          {
+            lower = 0x90;
+          }
+          else if (b == 0xF4)
+          {
+            upper = 0x8F;
+          }
+        }
+        else
+        {
+          state.m_Failed = true;
+          return false;
+        }
+      }
+      else
+      {
+        uint8_t b = ptr[offset++];
+        if (b < lower || b > upper)
+        {
+          state.m_Failed = true;
+          return false;
+        }
+
+        remaining--;
+        lower = 0x80;
+        upper = 0xBF;
+      }
+    }
+
+    state.m_Remaining = (uint8_t)remaining;
+    state.m_Lower = lower;
+    state.m_Upper = upper;
+    return true;
+  }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace StormSockets
+{
+  // Incremental UTF-8 validator state, so that a sequence can be split across blocks and continuation frames
+  struct StormUtf8ValidatorState
+  {
+    uint8_t m_Remaining = 0;
+    uint8_t m_Lower = 0x80;
+    uint8_t m_Upper = 0xBF;
+    bool m_Failed = false;
+  };
+
+  // Returns false as soon as the data seen so far can't be valid UTF-8
+  bool StormUtf8Validate(const void * data, int length, StormUtf8ValidatorState & state);
+
+  // True if everything validated so far ends on a character boundary
+  inline bool StormUtf8Complete(const StormUtf8ValidatorState & state)
+  {
+    return state.m_Failed == false && state.m_Remaining == 0;
+  }
+}
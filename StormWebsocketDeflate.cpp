@@ -0,0 +1,523 @@
+
+#include "StormWebsocketDeflate.h"
+#include "StormMemOps.h"
+
+#include <algorithm>
+#include <string.h>
+#include <ctype.h>
+
+namespace StormSockets
+{
+  static const int kDeflateMinWindowBits = 9;
+  static const int kDeflateMaxWindowBits = 15;
+
+  static std::string StormWebsocketDeflateTrim(const std::string & str)
+  {
+    std::size_t start = str.find_first_not_of(" \t");
+    if (start == std::string::npos)
+    {
+      return std::string();
+    }
+
+    std::size_t end = str.find_last_not_of(" \t");
+    return str.substr(start, end - start + 1);
+  }
+
+  static void StormWebsocketDeflateSplit(const std::string & str, char delim, std::vector<std::string> & parts)
+  {
+    std::size_t start = 0;
+    while (true)
+    {
+      std::size_t end = str.find(delim, start);
+      parts.push_back(StormWebsocketDeflateTrim(str.substr(start, end == std::string::npos ? std::string::npos : end - start)));
+
+      if (end == std::string::npos)
+      {
+        return;
+      }
+
+      start = end + 1;
+    }
+  }
+
+  static void StormWebsocketDeflateParseParam(const std::string & param, std::string & name, std::string & value, bool & has_value)
+  {
+    std::size_t equals = param.find('=');
+    if (equals == std::string::npos)
+    {
+      name = param;
+      value.clear();
+      has_value = false;
+      return;
+    }
+
+    name = StormWebsocketDeflateTrim(param.substr(0, equals));
+    value = StormWebsocketDeflateTrim(param.substr(equals + 1));
+    has_value = true;
+
+    if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+    {
+      value = value.substr(1, value.size() - 2);
+    }
+  }
+
+  static bool StormWebsocketDeflateParseWindowBits(const std::string & value, int & bits)
+  {
+    if (value.size() == 0 || value.size() > 2)
+    {
+      return false;
+    }
+
+    bits = 0;
+    for (char c : value)
+    {
+      if (c < '0' || c > '9')
+      {
+        return false;
+      }
+
+      bits = bits * 10 + (c - '0');
+    }
+
+    return bits >= 8 && bits <= kDeflateMaxWindowBits;
+  }
+
+  void StormWebsocketDeflateReadHeader(StormMessageReaderCursor & reader, std::string & value)
+  {
+    if (value.size() > 0)
+    {
+      value += ", ";
+    }
+
+    while (reader.GetRemainingLength() > 0)
+    {
+      value.push_back((char)tolower(reader.ReadByte()));
+    }
+  }
+
+  bool StormWebsocketDeflateAcceptOffer(const std::string & offer, const StormWebsocketDeflateParams & settings, StormWebsocketDeflateParams & result, std::string & response)
+  {
+    std::vector<std::string> extensions;
+    StormWebsocketDeflateSplit(offer, ',', extensions);
+
+    for (auto & extension : extensions)
+    {
+      std::vector<std::string> params;
+      StormWebsocketDeflateSplit(extension, ';', params);
+
+      if (params[0] != "permessage-deflate")
+      {
+        continue;
+      }
+
+      bool server_no_context_takeover = false;
+      bool client_no_context_takeover = false;
+      bool has_server_window_bits = false;
+      bool has_client_window_bits = false;
+      int server_window_bits = kDeflateMaxWindowBits;
+      bool valid = true;
+
+      for (std::size_t index = 1; index < params.size() && valid; ++index)
+      {
+        std::string name, value;
+        bool has_value;
+        StormWebsocketDeflateParseParam(params[index], name, value, has_value);
+
+        if (name == "server_no_context_takeover" && has_value == false && server_no_context_takeover == false)
+        {
+          server_no_context_takeover = true;
+        }
+        else if (name == "client_no_context_takeover" && has_value == false && client_no_context_takeover == false)
+        {
+          client_no_context_takeover = true;
+        }
+        else if (name == "server_max_window_bits" && has_value && has_server_window_bits == false &&
+          StormWebsocketDeflateParseWindowBits(value, server_window_bits))
+        {
+          has_server_window_bits = true;
+        }
+        else if (name == "client_max_window_bits" && has_client_window_bits == false)
+        {
+          // We always inflate with the largest window, so the value only needs to be well formed
+          int client_window_bits;
+          valid = has_value == false || StormWebsocketDeflateParseWindowBits(value, client_window_bits);
+          has_client_window_bits = true;
+        }
+        else
+        {
+          valid = false;
+        }
+      }
+
+      int window_bits = std::min(settings.m_LocalMaxWindowBits, server_window_bits);
+      if (valid == false || window_bits < kDeflateMinWindowBits)
+      {
+        continue;
+      }
+
+      result.m_LocalNoContextTakeover = settings.m_LocalNoContextTakeover || server_no_context_takeover;
+      result.m_RemoteNoContextTakeover = settings.m_RemoteNoContextTakeover || client_no_context_takeover;
+      result.m_LocalMaxWindowBits = window_bits;
+
+      response = "permessage-deflate";
+      if (result.m_LocalNoContextTakeover)
+      {
+        response += "; server_no_context_takeover";
+      }
+
+      if (result.m_RemoteNoContextTakeover)
+      {
+        response += "; client_no_context_takeover";
+      }
+
+      if (has_server_window_bits || window_bits < kDeflateMaxWindowBits)
+      {
+        response += "; server_max_window_bits=" + std::to_string(window_bits);
+      }
+
+      return true;
+    }
+
+    return false;
+  }
+
+  std::string StormWebsocketDeflateCreateOffer(const StormWebsocketDeflateParams & settings)
+  {
+    std::string offer = "permessage-deflate; client_max_window_bits";
+    if (settings.m_LocalNoContextTakeover)
+    {
+      offer += "; client_no_context_takeover";
+    }
+
+    if (settings.m_RemoteNoContextTakeover)
+    {
+      offer += "; server_no_context_takeover";
+    }
+
+    return offer;
+  }
+
+  bool StormWebsocketDeflateParseResponse(const std::string & response, const StormWebsocketDeflateParams & settings, StormWebsocketDeflateParams & result)
+  {
+    std::vector<std::string> extensions;
+    StormWebsocketDeflateSplit(response, ',', extensions);
+
+    if (extensions.size() != 1)
+    {
+      return false;
+    }
+
+    std::vector<std::string> params;
+    StormWebsocketDeflateSplit(extensions[0], ';', params);
+
+    if (params[0] != "permessage-deflate")
+    {
+      return false;
+    }
+
+    bool server_no_context_takeover = false;
+    bool client_no_context_takeover = false;
+    bool has_server_window_bits = false;
+    bool has_client_window_bits = false;
+    int client_window_bits = kDeflateMaxWindowBits;
+
+    for (std::size_t index = 1; index < params.size(); ++index)
+    {
+      std::string name, value;
+      bool has_value;
+      StormWebsocketDeflateParseParam(params[index], name, value, has_value);
+
+      int server_window_bits;
+      if (name == "server_no_context_takeover" && has_value == false && server_no_context_takeover == false)
+      {
+        server_no_context_takeover = true;
+      }
+      else if (name == "client_no_context_takeover" && has_value == false && client_no_context_takeover == false)
+      {
+        client_no_context_takeover = true;
+      }
+      else if (name == "server_max_window_bits" && has_value && has_server_window_bits == false &&
+        StormWebsocketDeflateParseWindowBits(value, server_window_bits))
+      {
+        has_server_window_bits = true;
+      }
+      else if (name == "client_max_window_bits" && has_value && has_client_window_bits == false &&
+        StormWebsocketDeflateParseWindowBits(value, client_window_bits))
+      {
+        has_client_window_bits = true;
+      }
+      else
+      {
+        return false;
+      }
+    }
+
+    int window_bits = std::min(settings.m_LocalMaxWindowBits, client_window_bits);
+    if (window_bits < kDeflateMinWindowBits)
+    {
+      return false;
+    }
+
+    result.m_LocalNoContextTakeover = settings.m_LocalNoContextTakeover || client_no_context_takeover;
+    result.m_RemoteNoContextTakeover = server_no_context_takeover;
+    result.m_LocalMaxWindowBits = window_bits;
+    return true;
+  }
+
+#ifndef DISABLE_ZLIB
+
+  static const int kDeflateChunkSize = 4096;
+  static const int kDeflateTrailerSize = 4;
+  static const uint8_t s_DeflateTrailer[kDeflateTrailerSize] = { 0x00, 0x00, 0xFF, 0xFF };
+
+  StormWebsocketDeflateContext::StormWebsocketDeflateContext() :
+    m_DeflateInit(false),
+    m_InflateInit(false),
+    m_DeflateWindowBits(0),
+    m_DeflateMemLevel(0)
+  {
+    memset(&m_Deflate, 0, sizeof(m_Deflate));
+    memset(&m_Inflate, 0, sizeof(m_Inflate));
+  }
+
+  StormWebsocketDeflateContext::~StormWebsocketDeflateContext()
+  {
+    if (m_DeflateInit)
+    {
+      deflateEnd(&m_Deflate);
+    }
+
+    if (m_InflateInit)
+    {
+      inflateEnd(&m_Inflate);
+    }
+  }
+
+  bool StormWebsocketDeflateContext::Init(const StormWebsocketDeflateParams & params, int mem_level)
+  {
+    if (m_DeflateInit && (m_DeflateWindowBits != params.m_LocalMaxWindowBits || m_DeflateMemLevel != mem_level))
+    {
+      deflateEnd(&m_Deflate);
+      m_DeflateInit = false;
+    }
+
+    if (m_DeflateInit)
+    {
+      deflateReset(&m_Deflate);
+    }
+    else
+    {
+      if (deflateInit2(&m_Deflate, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -params.m_LocalMaxWindowBits, mem_level, Z_DEFAULT_STRATEGY) != Z_OK)
+      {
+        return false;
+      }
+
+      m_DeflateInit = true;
+      m_DeflateWindowBits = params.m_LocalMaxWindowBits;
+      m_DeflateMemLevel = mem_level;
+    }
+
+    if (m_InflateInit)
+    {
+      inflateReset(&m_Inflate);
+    }
+    else
+    {
+      // The peer may compress with any window up to the maximum
+      if (inflateInit2(&m_Inflate, -kDeflateMaxWindowBits) != Z_OK)
+      {
+        return false;
+      }
+
+      m_InflateInit = true;
+    }
+
+    m_Params = params;
+    return true;
+  }
+
+  bool StormWebsocketDeflateContext::Compress(const void * data, int length, StormMessageWriter & writer)
+  {
+    uint8_t buffer[kDeflateChunkSize];
+
+    m_Deflate.next_in = (Bytef *)data;
+    m_Deflate.avail_in = (uInt)length;
+
+    do
+    {
+      m_Deflate.next_out = buffer;
+      m_Deflate.avail_out = kDeflateChunkSize;
+
+      if (deflate(&m_Deflate, Z_NO_FLUSH) == Z_STREAM_ERROR)
+      {
+        return false;
+      }
+
+      int produced = kDeflateChunkSize - (int)m_Deflate.avail_out;
+      if (produced > 0)
+      {
+        writer.WriteByteBlock(buffer, 0, produced);
+      }
+    } while (m_Deflate.avail_out == 0);
+
+    return true;
+  }
+
+  bool StormWebsocketDeflateContext::FinishMessage(StormMessageWriter & writer)
+  {
+    // The sync flush ends with an empty stored block which the receiver puts back, so hold back the last 4 bytes
+    uint8_t buffer[kDeflateChunkSize + kDeflateTrailerSize];
+    int held_length = 0;
+
+    m_Deflate.next_in = nullptr;
+    m_Deflate.avail_in = 0;
+
+    do
+    {
+      m_Deflate.next_out = buffer + held_length;
+      m_Deflate.avail_out = kDeflateChunkSize;
+
+      int ret = deflate(&m_Deflate, Z_SYNC_FLUSH);
+      if (ret != Z_OK && ret != Z_BUF_ERROR)
+      {
+        return false;
+      }
+
+      int total_length = held_length + kDeflateChunkSize - (int)m_Deflate.avail_out;
+      int write_length = std::max(total_length - kDeflateTrailerSize, 0);
+      if (write_length > 0)
+      {
+        writer.WriteByteBlock(buffer, 0, write_length);
+      }
+
+      held_length = total_length - write_length;
+      memmove(buffer, buffer + write_length, held_length);
+    } while (m_Deflate.avail_out == 0);
+
+    if (held_length != kDeflateTrailerSize || memcmp(buffer, s_DeflateTrailer, kDeflateTrailerSize) != 0)
+    {
+      return false;
+    }
+
+    if (m_Params.m_LocalNoContextTakeover)
+    {
+      deflateReset(&m_Deflate);
+    }
+
+    return true;
+  }
+
+  void StormWebsocketDeflateContext::ResetCompressor()
+  {
+    deflateReset(&m_Deflate);
+  }
+
+  bool StormWebsocketDeflateContext::Decompress(const void * data, int length, StormFixedBlockAllocator & allocator, StormWebsocketInflateOutput & output, int max_length)
+  {
+    int block_size = allocator.GetBlockSize();
+
+    m_Inflate.next_in = (Bytef *)data;
+    m_Inflate.avail_in = (uInt)length;
+
+    do
+    {
+      if (output.m_CurBlock == InvalidBlockHandle)
+      {
+        output.m_StartBlock = allocator.AllocateBlock(StormFixedBlockType::BlockMem);
+        output.m_CurBlock = output.m_StartBlock;
+        output.m_WriteOffset = 0;
+      }
+      else if (output.m_WriteOffset == block_size)
+      {
+        output.m_CurBlock = allocator.AllocateBlock(output.m_CurBlock, StormFixedBlockType::BlockMem);
+        output.m_WriteOffset = 0;
+      }
+
+      void * block = allocator.ResolveHandle(output.m_CurBlock);
+      int space_avail = block_size - output.m_WriteOffset;
+
+      m_Inflate.next_out = (Bytef *)Marshal::MemOffset(block, output.m_WriteOffset);
+      m_Inflate.avail_out = (uInt)space_avail;
+
+      int ret = inflate(&m_Inflate, Z_SYNC_FLUSH);
+
+      int produced = space_avail - (int)m_Inflate.avail_out;
+      output.m_WriteOffset += produced;
+      output.m_Length += produced;
+
+      if (ret == Z_STREAM_END)
+      {
+        // The peer finished the deflate stream with a final block, the next message starts a new one
+        inflateReset(&m_Inflate);
+      }
+      else if (ret != Z_OK && ret != Z_BUF_ERROR)
+      {
+        return false;
+      }
+
+      if (max_length >= 0 && output.m_Length > max_length)
+      {
+        return false;
+      }
+
+    } while (m_Inflate.avail_in > 0 || m_Inflate.avail_out == 0);
+
+    return true;
+  }
+
+  bool StormWebsocketDeflateContext::FinishDecompress(StormFixedBlockAllocator & allocator, StormWebsocketInflateOutput & output, int max_length)
+  {
+    return Decompress(s_DeflateTrailer, kDeflateTrailerSize, allocator, output, max_length);
+  }
+
+  StormWebsocketDeflatePool::StormWebsocketDeflatePool(int max_contexts, int mem_level) :
+    m_MaxContexts(max_contexts),
+    m_MemLevel(mem_level)
+  {
+
+  }
+
+  StormWebsocketDeflateContext * StormWebsocketDeflatePool::Allocate(const StormWebsocketDeflateParams & params)
+  {
+    StormWebsocketDeflateContext * context;
+
+    {
+      StormLockGuard<StormMutex> lock(m_Mutex);
+      if (m_FreeContexts.size() > 0)
+      {
+        context = m_FreeContexts.back();
+        m_FreeContexts.pop_back();
+      }
+      else if ((int)m_Contexts.size() < m_MaxContexts)
+      {
+        m_Contexts.emplace_back(std::make_unique<StormWebsocketDeflateContext>());
+        context = m_Contexts.back().get();
+      }
+      else
+      {
+        return nullptr;
+      }
+    }
+
+    if (context->Init(params, m_MemLevel) == false)
+    {
+      Free(context);
+      return nullptr;
+    }
+
+    return context;
+  }
+
+  bool StormWebsocketDeflatePool::Reconfigure(StormWebsocketDeflateContext * context, const StormWebsocketDeflateParams & params)
+  {
+    return context->Init(params, m_MemLevel);
+  }
+
+  void StormWebsocketDeflatePool::Free(StormWebsocketDeflateContext * context)
+  {
+    StormLockGuard<StormMutex> lock(m_Mutex);
+    m_FreeContexts.push_back(context);
+  }
+
+#endif
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "StormFixedBlockAllocator.h"
+#include "StormMessageReaderCursor.h"
+#include "StormMessageWriter.h"
+#include "StormMutex.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#ifndef DISABLE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace StormSockets
+{
+  // Negotiated permessage-deflate (RFC 7692) parameters.  "Local" refers to our compressor, "remote" to the peer's
+  struct StormWebsocketDeflateParams
+  {
+    bool m_LocalNoContextTakeover = false;
+    bool m_RemoteNoContextTakeover = false;
+    int m_LocalMaxWindowBits = 15;
+  };
+
+  void StormWebsocketDeflateReadHeader(StormMessageReaderCursor & reader, std::string & value);
+
+  bool StormWebsocketDeflateAcceptOffer(const std::string & offer, const StormWebsocketDeflateParams & settings, StormWebsocketDeflateParams & result, std::string & response);
+  std::string StormWebsocketDeflateCreateOffer(const StormWebsocketDeflateParams & settings);
+  bool StormWebsocketDeflateParseResponse(const std::string & response, const StormWebsocketDeflateParams & settings, StormWebsocketDeflateParams & result);
+
+#ifndef DISABLE_ZLIB
+
+  struct StormWebsocketInflateOutput
+  {
+    StormFixedBlockHandle m_StartBlock = InvalidBlockHandle;
+    StormFixedBlockHandle m_CurBlock = InvalidBlockHandle;
+    int m_WriteOffset = 0;
+    int m_Length = 0;
+  };
+
+  class StormWebsocketDeflateContext
+  {
+  public:
+    StormWebsocketDeflateContext();
+    ~StormWebsocketDeflateContext();
+
+    bool Init(const StormWebsocketDeflateParams & params, int mem_level);
+    const StormWebsocketDeflateParams & GetParams() const { return m_Params; }
+
+    bool Compress(const void * data, int length, StormMessageWriter & writer);
+    bool FinishMessage(StormMessageWriter & writer);
+    void ResetCompressor();
+
+    // Appends the inflated data to the output block chain.  Fails on corrupt data or if the output grows past max_length, which
+    // is ignored when negative
+    bool Decompress(const void * data, int length, StormFixedBlockAllocator & allocator, StormWebsocketInflateOutput & output, int max_length);
+    bool FinishDecompress(StormFixedBlockAllocator & allocator, StormWebsocketInflateOutput & output, int max_length);
+
+  private:
+    z_stream m_Deflate;
+    z_stream m_Inflate;
+    bool m_DeflateInit;
+    bool m_InflateInit;
+    int m_DeflateWindowBits;
+    int m_DeflateMemLevel;
+
+    StormWebsocketDeflateParams m_Params;
+  };
+
+  // Caps the number of live zlib contexts.  Released contexts are kept around and reset for the next connection
+  class StormWebsocketDeflatePool
+  {
+  public:
+    StormWebsocketDeflatePool(int max_contexts, int mem_level);
+
+    StormWebsocketDeflateContext * Allocate(const StormWebsocketDeflateParams & params);
+    bool Reconfigure(StormWebsocketDeflateContext * context, const StormWebsocketDeflateParams & params);
+    void Free(StormWebsocketDeflateContext * context);
+
+  private:
+    StormMutex m_Mutex;
+    std::vector<std::unique_ptr<StormWebsocketDeflateContext>> m_Contexts;
+    std::vector<StormWebsocketDeflateContext *> m_FreeContexts;
+
+    int m_MaxContexts;
+    int m_MemLevel;
+  };
+
+#endif
+}
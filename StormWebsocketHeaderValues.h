@@ -9,16 +9,11 @@ namespace StormSockets
     enum Index
     {
       GetHeader,
-      WebsocketHeader,
-      ConnectionUpdgradeHeader,
+      UpgradeWebsocket,
       UpdgradePart,
-      WebsocketKeyHeader,
-      WebsocketVerHeader,
-      WebsocketProtoHeader,
+      Protocol,
       Response,
       StatusLine,
-      WebsocketAcceptHeader,
-      WebsocketProtoResponseHeader,
       ResponseTerminator,
       Count,
     };
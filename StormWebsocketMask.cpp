@@ -0,0 +1,182 @@
+
+#include "StormWebsocketMask.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define STORM_MASK_X64
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define STORM_MASK_TARGET_AVX2
+#else
+#define STORM_MASK_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace StormSockets
+{
+  using StormWebsocketMaskFunc = void(*)(uint8_t * data, int length, uint32_t mask);
+
+  static uint32_t StormWebsocketRotateMask(uint32_t mask, int length)
+  {
+    int shift = (length & 3) * 8;
+    if (shift == 0)
+    {
+      return mask;
+    }
+
+    return (mask >> shift) | (mask << (32 - shift));
+  }
+
+  static void StormWebsocketMaskTail(uint8_t * data, int length, uint32_t mask)
+  {
+    for (int index = 0; index < length; index++)
+    {
+      data[index] ^= (uint8_t)(mask >> ((index & 3) * 8));
+    }
+  }
+
+  static void StormWebsocketMaskScalar(uint8_t * data, int length, uint32_t mask)
+  {
+    // Lay the key out in memory order so the wide XOR lines up with the bytes on either endianness
+    uint8_t mask_bytes[8];
+    for (int index = 0; index < 8; index++)
+    {
+      mask_bytes[index] = (uint8_t)(mask >> ((index & 3) * 8));
+    }
+
+    uint64_t wide_mask;
+    memcpy(&wide_mask, mask_bytes, sizeof(wide_mask));
+
+    while (length >= 8)
+    {
+      uint64_t val;
+      memcpy(&val, data, sizeof(val));
+      val ^= wide_mask;
+      memcpy(data, &val, sizeof(val));
+
+      data += 8;
+      length -= 8;
+    }
+
+    StormWebsocketMaskTail(data, length, mask);
+  }
+
+#ifdef STORM_MASK_X64
+
+  static void StormWebsocketMaskSSE2(uint8_t * data, int length, uint32_t mask)
+  {
+    __m128i wide_mask = _mm_set1_epi32((int)mask);
+    while (length >= 64)
+    {
+      __m128i v0 = _mm_loadu_si128((const __m128i *)(data + 0));
+      __m128i v1 = _mm_loadu_si128((const __m128i *)(data + 16));
+      __m128i v2 = _mm_loadu_si128((const __m128i *)(data + 32));
+      __m128i v3 = _mm_loadu_si128((const __m128i *)(data + 48));
+
+      _mm_storeu_si128((__m128i *)(data + 0), _mm_xor_si128(v0, wide_mask));
+      _mm_storeu_si128((__m128i *)(data + 16), _mm_xor_si128(v1, wide_mask));
+      _mm_storeu_si128((__m128i *)(data + 32), _mm_xor_si128(v2, wide_mask));
+      _mm_storeu_si128((__m128i *)(data + 48), _mm_xor_si128(v3, wide_mask));
+
+      data += 64;
+      length -= 64;
+    }
+
+    while (length >= 16)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i *)data);
+      _mm_storeu_si128((__m128i *)data, _mm_xor_si128(v, wide_mask));
+
+      data += 16;
+      length -= 16;
+    }
+
+    StormWebsocketMaskScalar(data, length, mask);
+  }
+
+  STORM_MASK_TARGET_AVX2 static void StormWebsocketMaskAVX2(uint8_t * data, int length, uint32_t mask)
+  {
+    __m256i wide_mask = _mm256_set1_epi32((int)mask);
+    while (length >= 64)
+    {
+      __m256i v0 = _mm256_loadu_si256((const __m256i *)(data + 0));
+      __m256i v1 = _mm256_loadu_si256((const __m256i *)(data + 32));
+
+      _mm256_storeu_si256((__m256i *)(data + 0), _mm256_xor_si256(v0, wide_mask));
+      _mm256_storeu_si256((__m256i *)(data + 32), _mm256_xor_si256(v1, wide_mask));
+
+      data += 64;
+      length -= 64;
+    }
+
+    if (length >= 32)
+    {
+      __m256i v = _mm256_loadu_si256((const __m256i *)data);
+      _mm256_storeu_si256((__m256i *)data, _mm256_xor_si256(v, wide_mask));
+
+      data += 32;
+      length -= 32;
+    }
+
+    StormWebsocketMaskScalar(data, length, mask);
+  }
+
+  static bool StormWebsocketCpuHasAVX2()
+  {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+      return false;
+    }
+
+    __cpuid(info, 1);
+    bool os_saves_ymm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+    if (os_saves_ymm == false)
+    {
+      return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+  }
+
+#endif
+
+  static StormWebsocketMaskFunc StormWebsocketSelectMaskFunc()
+  {
+#ifdef STORM_MASK_X64
+    if (StormWebsocketCpuHasAVX2())
+    {
+      return &StormWebsocketMaskAVX2;
+    }
+
+    return &StormWebsocketMaskSSE2;
+#else
+    return &StormWebsocketMaskScalar;
+#endif
+  }
+
+  uint32_t StormWebsocketApplyMask(void * data, int length, uint32_t mask)
+  {
+    static const StormWebsocketMaskFunc s_MaskFunc = StormWebsocketSelectMaskFunc();
+
+    if (length <= 0)
+    {
+      return mask;
+    }
+
+    s_MaskFunc((uint8_t *)data, length, mask);
+    return StormWebsocketRotateMask(mask, length);
+  }
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace StormSockets
+{
+  // XORs length bytes in place with a websocket masking key.  Byte 0 of data is combined with the low byte of mask.
+  // Returns the key rotated so that it can be passed straight through for the next contiguous segment of the payload
+  uint32_t StormWebsocketApplyMask(void * data, int length, uint32_t mask);
+}
@@ -1,8 +1,10 @@
 #include "StormWebsocketMessageReader.h"
 #include "StormMemOps.h"
 #include "StormProfiling.h"
+#include "StormWebsocketMask.h"
 
 #include <stdexcept>
+#include <vector>
 
 namespace StormSockets
 {
@@ -12,6 +14,10 @@ namespace StormSockets
     m_Allocator = block_allocator;
     m_ReaderAllocator = reader_allocator;
     m_FixedBlockSize = fixed_block_size;
+    m_MaxContiguousPayloadSize = 0;
+    m_Utf8Valid = true;
+    m_Utf8Pending = false;
+    m_Utf8State = {};
 
     StormFixedBlockHandle packet_handle = reader_allocator->AllocateBlock(StormFixedBlockType::Reader);
     StormMessageReaderData * packet_info = (StormMessageReaderData *)reader_allocator->ResolveHandle(packet_handle);
@@ -24,6 +30,9 @@ namespace StormSockets
     m_PacketInfo->m_CurBlock = cur_block_ptr;
     m_PacketInfo->m_DataLength = data_len;
     m_PacketInfo->m_ReadOffset = parse_offset;
+    m_PacketInfo->m_OwnedBlocks = InvalidBlockHandle;
+    m_PacketInfo->m_Mask = 0;
+    m_PacketInfo->m_Deferred = false;
   }
 
 
@@ -37,6 +46,11 @@ namespace StormSockets
 		return m_FinalInSequence;
 	}
 
+	bool StormWebsocketMessageReader::IsUtf8Valid()
+	{
+		return m_Utf8Valid;
+	}
+
 	void StormWebsocketMessageReader::SetNextBlock(const StormWebsocketMessageReader & next_reader)
 	{
 		m_ReaderAllocator->SetNextBlock(m_PacketHandle, next_reader.m_PacketHandle);
@@ -76,11 +90,21 @@ namespace StormSockets
 		void * cur_block = next_reader->m_CurBlock;
 		int read_offset = next_reader->m_ReadOffset;
 		int data_length = next_reader->m_DataLength;
+		uint32_t mask = next_reader->m_Mask;
+		bool deferred = next_reader->m_Deferred;
 		StormMessageReaderData * next_next_reader = (StormMessageReaderData *)m_ReaderAllocator->GetNextBlock(next_reader);
 
+		if (m_PacketInfo->m_OwnedBlocks != InvalidBlockHandle)
+		{
+			m_Allocator->FreeBlockChain(m_PacketInfo->m_OwnedBlocks, StormFixedBlockType::BlockMem);
+		}
+
 		m_PacketInfo->m_CurBlock = cur_block;
 		m_PacketInfo->m_ReadOffset = read_offset;
 		m_PacketInfo->m_DataLength = data_length;
+		m_PacketInfo->m_OwnedBlocks = next_reader->m_OwnedBlocks;
+		m_PacketInfo->m_Mask = mask;
+		m_PacketInfo->m_Deferred = deferred;
 		m_ReaderAllocator->SetNextBlock(m_PacketInfo, next_next_reader);
 
 		m_ReaderAllocator->FreeBlock(next_reader, StormFixedBlockType::Reader);
@@ -92,6 +116,12 @@ namespace StormSockets
 
 		while (cur_packet != InvalidBlockHandle)
 		{
+			StormMessageReaderData * packet_info = (StormMessageReaderData *)m_ReaderAllocator->ResolveHandle(cur_packet);
+			if (packet_info->m_OwnedBlocks != InvalidBlockHandle)
+			{
+				m_Allocator->FreeBlockChain(packet_info->m_OwnedBlocks, StormFixedBlockType::BlockMem);
+			}
+
 			StormFixedBlockHandle next_packet = m_ReaderAllocator->FreeBlock(cur_packet, StormFixedBlockType::Reader);
 			cur_packet = next_packet;
 		}
@@ -106,6 +136,11 @@ namespace StormSockets
 	{
 		uint64_t prof = Profiling::StartProfiler();
 
+		if (m_PacketInfo->m_Deferred)
+		{
+			UnmaskPayload();
+		}
+
 		void * cur_block = m_PacketInfo->m_CurBlock;
 		int read_offset = m_PacketInfo->m_ReadOffset;
 		int data_length = m_PacketInfo->m_DataLength;
@@ -156,14 +191,18 @@ namespace StormSockets
 
 	uint16_t StormWebsocketMessageReader::ReadInt16()
 	{
+		if (m_PacketInfo->m_Deferred)
+		{
+			UnmaskPayload();
+		}
+
 		int read_offset = m_PacketInfo->m_ReadOffset;
 		int data_length = m_PacketInfo->m_DataLength;
 		if (read_offset + 2 > m_FixedBlockSize || data_length < 2)
 		{
-			uint16_t v1 = ReadByte() & 0xFF;
-			uint16_t v2 = ReadByte() & 0xFF;
-
-			return (uint16_t)((v2 << 8) | v1);
+			uint16_t v;
+			ReadByteBlock(&v, sizeof(v));
+			return v;
 		}
 
 		void * cur_block = m_PacketInfo->m_CurBlock;
@@ -188,14 +227,18 @@ namespace StormSockets
 
 	uint32_t StormWebsocketMessageReader::ReadInt32()
 	{
+		if (m_PacketInfo->m_Deferred)
+		{
+			UnmaskPayload();
+		}
+
 		int read_offset = m_PacketInfo->m_ReadOffset;
 		int data_length = m_PacketInfo->m_DataLength;
 		if (read_offset + 4 > m_FixedBlockSize || data_length < 4)
 		{
-			uint32_t v1 = ReadInt16() & 0xFFFF;
-			uint32_t v2 = ReadInt16() & 0xFFFF;
-
-			return (uint32_t)((v2 << 16) | v1);
+			uint32_t v;
+			ReadByteBlock(&v, sizeof(v));
+			return v;
 		}
 
 		void * cur_block = m_PacketInfo->m_CurBlock;
@@ -220,14 +263,18 @@ namespace StormSockets
 
 	uint64_t StormWebsocketMessageReader::ReadInt64()
 	{
+		if (m_PacketInfo->m_Deferred)
+		{
+			UnmaskPayload();
+		}
+
 		int read_offset = m_PacketInfo->m_ReadOffset;
 		int data_length = m_PacketInfo->m_DataLength;
 		if (read_offset + 8 > m_FixedBlockSize || data_length < 8)
 		{
-			uint64_t v1 = ReadInt32() & 0xFFFFFFFF;
-			uint64_t v2 = ReadInt32() & 0xFFFFFFFF;
-
-			return (uint64_t)((v2 << 32) | v1);
+			uint64_t v;
+			ReadByteBlock(&v, sizeof(v));
+			return v;
 		}
 
 		void * cur_block = m_PacketInfo->m_CurBlock;
@@ -249,33 +296,132 @@ namespace StormSockets
 		return v;
 	}
 
+  int StormWebsocketMessageReader::GetRemainingLength()
+  {
+    int length = 0;
+    StormMessageReaderData * packet_info = m_PacketInfo;
+    while (packet_info)
+    {
+      length += packet_info->m_DataLength;
+      packet_info = (StormMessageReaderData *)m_ReaderAllocator->GetNextBlock(packet_info);
+    }
+
+    return length;
+  }
+
+  bool StormWebsocketMessageReader::GetContiguousPayload(const void * & data, int & length)
+  {
+    if (m_PacketInfo->m_Deferred)
+    {
+      UnmaskPayload();
+    }
+
+    int read_offset = m_PacketInfo->m_ReadOffset;
+    int data_length = m_PacketInfo->m_DataLength;
+
+    if (read_offset + data_length <= m_FixedBlockSize && m_ReaderAllocator->GetNextBlock(m_PacketInfo) == nullptr)
+    {
+      data = Marshal::MemOffset(m_PacketInfo->m_CurBlock, read_offset);
+      length = data_length;
+
+      m_PacketInfo->m_ReadOffset += data_length;
+      m_PacketInfo->m_DataLength = 0;
+      return true;
+    }
+
+    int remaining_length = GetRemainingLength();
+    if (remaining_length > m_MaxContiguousPayloadSize)
+    {
+      return false;
+    }
+
+    static thread_local std::vector<uint8_t> scratch_buffer;
+    if ((int)scratch_buffer.size() < remaining_length)
+    {
+      scratch_buffer.resize(remaining_length);
+    }
+
+    ReadByteBlock(scratch_buffer.data(), remaining_length);
+
+    data = scratch_buffer.data();
+    length = remaining_length;
+    return true;
+  }
+
   void StormWebsocketMessageReader::ReadByteBlock(void * data, unsigned int length)
   {
+    if (m_PacketInfo->m_Deferred)
+    {
+      UnmaskPayload();
+    }
+
     void * cur_block = m_PacketInfo->m_CurBlock;
     int read_offset = m_PacketInfo->m_ReadOffset;
     int data_length = m_PacketInfo->m_DataLength;
 
     while (length > 0)
     {
-      while (data_length > 0)
+      while (data_length > 0 && length > 0)
       {
-        unsigned int data_avail = m_FixedBlockSize - read_offset;
+        unsigned int data_avail = std::min(m_FixedBlockSize - read_offset, data_length);
+        unsigned int copy_len = std::min(data_avail, length);
+
+        memcpy(data, Marshal::MemOffset(cur_block, read_offset), copy_len);
+        length -= copy_len;
+        data_length -= copy_len;
+        read_offset += copy_len;
 
-        if (data_avail > length)
+        data = Marshal::MemOffset(data, copy_len);
+
+        if (read_offset >= m_FixedBlockSize)
         {
-          memcpy(data, Marshal::MemOffset(cur_block, read_offset), length);
-          read_offset += length;
-          data_length -= length;
-          length = 0;
-          break;
+          cur_block = m_Allocator->GetNextBlock(cur_block);
+          read_offset = 0;
         }
-        else
+      }
+
+      if (length > 0 && data_length == 0)
+      {
+        Advance();
+
+        cur_block = m_PacketInfo->m_CurBlock;
+        read_offset = m_PacketInfo->m_ReadOffset;
+        data_length = m_PacketInfo->m_DataLength;
+      }
+    }
+
+    m_PacketInfo->m_CurBlock = cur_block;
+    m_PacketInfo->m_ReadOffset = read_offset;
+    m_PacketInfo->m_DataLength = data_length;
+  }
+
+  bool StormWebsocketMessageReader::ReadPayload(void * buffer, int length)
+  {
+    void * cur_block = m_PacketInfo->m_CurBlock;
+    int read_offset = m_PacketInfo->m_ReadOffset;
+    int data_length = m_PacketInfo->m_DataLength;
+
+    while (length > 0)
+    {
+      while (data_length > 0 && length > 0)
+      {
+        int segment_length = std::min(std::min(m_FixedBlockSize - read_offset, data_length), length);
+
+        // Segments are at most one block, so the copy is still in L1 when it's unmasked and validated
+        memcpy(buffer, Marshal::MemOffset(cur_block, read_offset), segment_length);
+        if (m_PacketInfo->m_Deferred)
         {
-          memcpy(data, Marshal::MemOffset(cur_block, read_offset), data_avail);
-          length -= data_avail;
-          data_length -= data_avail;
+          ProcessDeferredSpan(m_PacketInfo, buffer, segment_length);
+        }
 
-          data = Marshal::MemOffset(data, data_avail);
+        length -= segment_length;
+        data_length -= segment_length;
+        read_offset += segment_length;
+
+        buffer = Marshal::MemOffset(buffer, segment_length);
+
+        if (read_offset >= m_FixedBlockSize)
+        {
           cur_block = m_Allocator->GetNextBlock(cur_block);
           read_offset = 0;
         }
@@ -294,5 +440,66 @@ namespace StormSockets
     m_PacketInfo->m_CurBlock = cur_block;
     m_PacketInfo->m_ReadOffset = read_offset;
     m_PacketInfo->m_DataLength = data_length;
+
+    if (data_length == 0 && m_ReaderAllocator->GetNextBlock(m_PacketInfo) == nullptr)
+    {
+      FinishUtf8();
+    }
+
+    return m_Utf8Valid;
+  }
+
+  bool StormWebsocketMessageReader::UnmaskPayload()
+  {
+    StormMessageReaderData * packet_info = m_PacketInfo;
+    while (packet_info)
+    {
+      if (packet_info->m_Deferred)
+      {
+        void * cur_block = packet_info->m_CurBlock;
+        int read_offset = packet_info->m_ReadOffset;
+        int data_length = packet_info->m_DataLength;
+
+        while (data_length > 0)
+        {
+          int segment_length = std::min(m_FixedBlockSize - read_offset, data_length);
+          ProcessDeferredSpan(packet_info, Marshal::MemOffset(cur_block, read_offset), segment_length);
+
+          data_length -= segment_length;
+          cur_block = m_Allocator->GetNextBlock(cur_block);
+          read_offset = 0;
+        }
+
+        packet_info->m_Mask = 0;
+        packet_info->m_Deferred = false;
+      }
+
+      packet_info = (StormMessageReaderData *)m_ReaderAllocator->GetNextBlock(packet_info);
+    }
+
+    FinishUtf8();
+    return m_Utf8Valid;
+  }
+
+  void StormWebsocketMessageReader::ProcessDeferredSpan(StormMessageReaderData * packet_info, void * data, int length)
+  {
+    if (packet_info->m_Mask != 0)
+    {
+      packet_info->m_Mask = StormWebsocketApplyMask(data, length, packet_info->m_Mask);
+    }
+
+    if (m_Utf8Pending && StormUtf8Validate(data, length, m_Utf8State) == false)
+    {
+      m_Utf8Valid = false;
+    }
+  }
+
+  void StormWebsocketMessageReader::FinishUtf8()
+  {
+    if (m_Utf8Pending && m_FinalInSequence)
+    {
+      m_Utf8Valid = m_Utf8Valid && StormUtf8Complete(m_Utf8State);
+      m_Utf8Pending = false;
+    }
   }
 }
\ No newline at end of file
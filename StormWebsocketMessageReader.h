@@ -3,8 +3,10 @@
 #include "StormFixedBlockAllocator.h"
 #include "StormSocketConnectionId.h"
 #include "StormMessageReaderData.h"
+#include "StormUtf8Validator.h"
 
 #include <cstdint>
+#include <algorithm>
 
 
 namespace StormSockets
@@ -30,9 +32,13 @@ namespace StormSockets
 		int m_FixedBlockSize;
 		int m_PacketDataLen;
 		int m_FullDataLen;
+		int m_MaxContiguousPayloadSize;
 		StormSocketConnectionId m_ConnectionId;
 		StormSocketWebsocketDataType::Index m_DataType;
 		bool m_FinalInSequence;
+		bool m_Utf8Valid;
+		bool m_Utf8Pending;
+		StormUtf8ValidatorState m_Utf8State;
 
     friend class StormSocketFrontendWebsocketBase;
 
@@ -44,6 +50,10 @@ namespace StormSockets
 
 		bool GetFinalInSequence();
 
+		// Always true unless the frontend is set to StormSocketUtf8ValidationMode::Validate and this text message wasn't valid UTF-8.
+		// With DeferUnmask the message is only validated as it's read, so this is final once the whole message has been consumed
+		bool IsUtf8Valid();
+
 		int GetDataLength();
 
 		uint8_t ReadByte();
@@ -54,6 +64,63 @@ namespace StormSockets
 
     void ReadByteBlock(void * data, unsigned int length);
 
+    // Consumes length bytes into buffer, unmasking and validating data that was deferred by the frontend in the same pass
+    // as the copy.  Returns false once the message is known not to be valid UTF-8
+    bool ReadPayload(void * buffer, int length);
+
+    // Unmasks and validates the rest of the message in place without consuming it
+    bool UnmaskPayload();
+
+    int GetRemainingLength();
+
+    // Consumes the rest of the message as a single span.  If the data straddles blocks it is copied into a per-thread
+    // scratch buffer which stays valid until the next call on the same thread.  Fails if the message is larger than
+    // the frontend's MaxContiguousPayloadSize and doesn't already fit in one block
+    bool GetContiguousPayload(const void * & data, int & length);
+
+    // Consumes the rest of the message, calling callback(const void * data, int length) for each contiguous span
+    template <typename Callback>
+    void ForEachSegment(Callback && callback)
+    {
+      if (m_PacketInfo->m_Deferred)
+      {
+        UnmaskPayload();
+      }
+
+      while (true)
+      {
+        void * cur_block = m_PacketInfo->m_CurBlock;
+        int read_offset = m_PacketInfo->m_ReadOffset;
+        int data_length = m_PacketInfo->m_DataLength;
+
+        while (data_length > 0)
+        {
+          int segment_length = std::min(m_FixedBlockSize - read_offset, data_length);
+          callback((const uint8_t *)cur_block + read_offset, segment_length);
+
+          read_offset += segment_length;
+          data_length -= segment_length;
+
+          if (read_offset >= m_FixedBlockSize)
+          {
+            cur_block = m_Allocator->GetNextBlock(cur_block);
+            read_offset = 0;
+          }
+        }
+
+        m_PacketInfo->m_CurBlock = cur_block;
+        m_PacketInfo->m_ReadOffset = read_offset;
+        m_PacketInfo->m_DataLength = data_length;
+
+        if (m_ReaderAllocator->GetNextBlock(m_PacketInfo) == nullptr)
+        {
+          return;
+        }
+
+        Advance();
+      }
+    }
+
   private:
     StormWebsocketMessageReader(StormFixedBlockAllocator * block_allocator, StormFixedBlockAllocator * reader_allocator, StormFixedBlockHandle cur_block,
       int data_len, int parse_offset, StormSocketConnectionId connection_id, int fixed_block_size);
@@ -64,5 +131,8 @@ namespace StormSockets
 
     void Advance();
     void FreeChain();
+
+    void ProcessDeferredSpan(StormMessageReaderData * packet_info, void * data, int length);
+    void FinishUtf8();
 	};
 }
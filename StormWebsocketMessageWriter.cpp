@@ -1,7 +1,10 @@
 
 #include "StormWebsocketMessageWriter.h"
+#include "StormWebsocketMask.h"
 #include "StormMemOps.h"
 
+#include <algorithm>
+
 
 namespace StormSockets
 {
@@ -21,12 +24,19 @@ namespace StormSockets
     m_PacketInfo->m_WriteOffset = WebsocketMaxHeaderSize + m_ReservedHeaderLength;
   }
 
+  int StormWebsocketMessageWriter::GetPayloadLength()
+  {
+    return m_PacketInfo->m_TotalLength - (WebsocketMaxHeaderSize - m_PacketInfo->m_SendOffset);
+  }
+
   void StormWebsocketMessageWriter::CreateHeaderAndApplyMask(int opcode, bool fin, int mask)
   {
     StormFixedBlockHandle start_handle = m_PacketInfo->m_StartBlock;
     void * start_block = m_Allocator->ResolveHandle(start_handle);
 
-    int packet_length = m_PacketInfo->m_TotalLength;
+    // A sliced payload isn't held by this writer, so only its length counts here
+    int own_length = m_PacketInfo->m_TotalLength;
+    int packet_length = own_length + m_PacketInfo->m_SliceLength;
     int base_offset;
     int payload_bits;
 
@@ -66,6 +76,12 @@ namespace StormSockets
     // Set the op code
     payload_bits |= opcode & 0x0F;
 
+    // Per message compression flag
+    if (m_Compressed)
+    {
+      payload_bits |= 0x40;
+    }
+
     // Set the fin bit
     if (fin)
     {
@@ -101,7 +117,7 @@ namespace StormSockets
 
     void * cur_block = start_block;
     int read_offset = cur_offset;
-    int data_length = packet_length;
+    int data_length = own_length;
 
     // Include the header in the total length
     int header_size = WebsocketMaxHeaderSize - base_offset;
@@ -110,33 +126,18 @@ namespace StormSockets
     if (mask != 0)
     {
       // Mask out the rest of the data
-      do
+      uint32_t cur_mask = (uint32_t)mask;
+      int block_end = m_Allocator->GetBlockSize() - m_ReservedTrailerLength;
+
+      while (data_length > 0 && cur_block != NULL)
       {
-        if (data_length >= 4 && read_offset + 4 <= m_Allocator->GetBlockSize() - m_ReservedTrailerLength)
-        {
-          int val = Marshal::ReadInt32(cur_block, read_offset);
-          val ^= mask;
-          Marshal::WriteInt32(cur_block, read_offset, val);
-          read_offset += 4;
-          data_length -= 4;
-        }
-        else if (data_length > 0 && read_offset != m_Allocator->GetBlockSize() - m_ReservedTrailerLength)
-        {
-          int val = Marshal::ReadByte(cur_block, read_offset);
-          val ^= mask;
-          Marshal::WriteByte(cur_block, read_offset, (uint8_t)val);
-          read_offset += 1;
-          data_length -= 1;
-
-          mask = (mask << 24) | (mask >> 8);
-        }
-
-        if (read_offset == m_Allocator->GetBlockSize() - m_ReservedTrailerLength)
-        {
-          cur_block = m_Allocator->GetNextBlock(cur_block);
-          read_offset = m_ReservedHeaderLength;
-        }
-      } while (data_length > 0 && cur_block != NULL);
+        int segment_length = std::min(block_end - read_offset, data_length);
+        cur_mask = StormWebsocketApplyMask(Marshal::MemOffset(cur_block, read_offset), segment_length, cur_mask);
+        data_length -= segment_length;
+
+        cur_block = m_Allocator->GetNextBlock(cur_block);
+        read_offset = m_ReservedHeaderLength;
+      }
     }
   }
 }
@@ -2,6 +2,8 @@
 
 #include "StormMessageWriter.h"
 
+#include <algorithm>
+
 namespace StormSockets
 {
   class StormWebsocketMessageWriter : public StormMessageWriter
@@ -9,8 +11,14 @@ namespace StormSockets
   protected:
 
     bool m_Final;
+    bool m_Compressed;
     StormWebsocketOp::Index m_Mode;
 
+    // Compressed on the first send to a connection that doesn't use context takeover
+    bool m_SharedCompressionDone;
+    bool m_HasCompressedWriter;
+    StormMessageWriter m_CompressedWriter;
+
     friend class StormSocketServerFrontendWebsocket;
     friend class StormSocketClientFrontendWebsocket;
     friend class StormSocketFrontendWebsocketBase;
@@ -25,6 +33,28 @@ namespace StormSockets
     void SaveHeaderRoom();
     void CreateHeaderAndApplyMask(int opcode, bool fin, int mask);
 
+    // Only valid once the header has been created
+    int GetPayloadLength();
+
+    template <typename Callback>
+    void ForEachPayloadSegment(Callback && callback)
+    {
+      int block_end = m_Allocator->GetBlockSize() - m_ReservedTrailerLength;
+      void * cur_block = m_Allocator->ResolveHandle(m_PacketInfo->m_StartBlock);
+      int read_offset = m_ReservedHeaderLength + WebsocketMaxHeaderSize;
+      int data_length = GetPayloadLength();
+
+      while (data_length > 0 && cur_block != nullptr)
+      {
+        int segment_length = std::min(block_end - read_offset, data_length);
+        callback((const uint8_t *)cur_block + read_offset, segment_length);
+        data_length -= segment_length;
+
+        cur_block = m_Allocator->GetNextBlock(cur_block);
+        read_offset = m_ReservedHeaderLength;
+      }
+    }
+
     static const int WebsocketMaxHeaderSize = 14;
 
   };